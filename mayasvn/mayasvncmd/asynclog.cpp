@@ -0,0 +1,384 @@
+/*=======================================================================*
+ |   file name : asynclog.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : log file written by a background thread
+ *=======================================================================*/
+
+/*
+   Any thread can call alWrite.  It copies the message into a slot in a
+   fixed size ring and returns, no locks, no file I/O, and unless the
+   message is long no malloc either.  One writer thread
+   empties the ring into the log file.  If the ring is full the message
+   is dropped and counted rather than making the caller wait.
+
+   The ring is the bounded queue from Dmitry Vyukov.  Each slot has a
+   sequence number that says whose turn it is: a producer may fill slot
+   n when its sequence is n, the writer may empty it when it's n + 1.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <process.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "asynclog.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define AL_NUM_SLOTS	4096	// must be a power of 2
+#define AL_SLOT_TEXT	216		// longer messages are malloced
+#define AL_WAKE_MS		100		// how often the writer looks
+
+static const char* s_levelNames[] = { "error", "warning", "status", "debug", };
+
+/******************************* t y p e s *******************************/
+
+struct LogSlot
+{
+	volatile LONG	sequence;
+	int				level;
+	DWORD			threadId;
+	SYSTEMTIME		time;
+	size_t			len;
+	char*			pLong;		// NULL or malloced by the producer, freed by the writer
+	char			text[AL_SLOT_TEXT];
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+volatile int g_alLevel = -1;
+
+static bool				s_bInitialized;
+static CRITICAL_SECTION	s_cs;			// the file, not the ring
+static LogSlot			s_slots[AL_NUM_SLOTS];
+static volatile LONG	s_enqueuePos;
+static LONG				s_dequeuePos;	// writer thread only
+static volatile LONG	s_dropped;
+static HANDLE			s_thread;
+static HANDLE			s_wakeEvent;
+static volatile bool	s_bStop;
+static int				s_level = AL_DEFAULT_LEVEL;
+static string			s_logFile;
+static FILE*			s_fp;
+static long				s_bytes;		// in the current file
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static void alInit ()
+{
+	if (!s_bInitialized)
+	{
+		for (LONG ii = 0; ii < AL_NUM_SLOTS; ++ii)
+		{
+			s_slots[ii].sequence = ii;
+		}
+		InitializeCriticalSection(&s_cs);
+		s_wakeEvent    = CreateEvent(NULL, FALSE, FALSE, NULL);
+		s_bInitialized = true;
+	}
+}
+
+// log -> log.1 -> log.2 ...  call with s_cs held
+static void alRotate ()
+{
+	if (s_fp)
+	{
+		fclose(s_fp);
+		s_fp = NULL;
+	}
+
+	for (int ii = AL_NUM_OLD_LOGS; ii > 0; --ii)
+	{
+		char from[MAX_PATH * 2];
+		char to[MAX_PATH * 2];
+
+		if (ii > 1)
+		{
+			_snprintf(from, sizeof(from), "%s.%d", s_logFile.c_str(), ii - 1);
+		}
+		else
+		{
+			_snprintf(from, sizeof(from), "%s", s_logFile.c_str());
+		}
+		_snprintf(to, sizeof(to), "%s.%d", s_logFile.c_str(), ii);
+		from[sizeof(from) - 1] = '\0';
+		to[sizeof(to) - 1]     = '\0';
+		MoveFileEx(from, to, MOVEFILE_REPLACE_EXISTING);
+	}
+
+	s_fp    = fopen(s_logFile.c_str(), "a");
+	s_bytes = 0;
+}
+
+// call with s_cs held
+static void alWriteSlot (const LogSlot& slot)
+{
+	if (!s_fp)
+	{
+		return;
+	}
+
+	const char*	pText = slot.pLong ? slot.pLong : slot.text;
+	int			len   = fprintf(s_fp, "%04d-%02d-%02d %02d:%02d:%02d.%03d [%lu] %s: ",
+					  slot.time.wYear, slot.time.wMonth, slot.time.wDay,
+					  slot.time.wHour, slot.time.wMinute, slot.time.wSecond, slot.time.wMilliseconds,
+					  (unsigned long)slot.threadId, s_levelNames[slot.level]);
+	fwrite(pText, slot.len, 1, s_fp);
+	if (!slot.len || pText[slot.len - 1] != '\n')
+	{
+		fputc('\n', s_fp);
+		++len;
+	}
+	s_bytes += len + (long)slot.len;
+
+	if (s_bytes >= AL_MAX_BYTES)
+	{
+		alRotate();
+	}
+}
+
+// empty the ring.  Only the writer thread (or shutdown after it's gone)
+static void alDrain ()
+{
+	EnterCriticalSection(&s_cs);
+
+	for (;;)
+	{
+		LogSlot& slot = s_slots[s_dequeuePos & (AL_NUM_SLOTS - 1)];
+
+		if (slot.sequence != s_dequeuePos + 1)
+		{
+			break;	// empty
+		}
+
+		alWriteSlot(slot);
+		free(slot.pLong);
+		slot.pLong = NULL;
+
+		// hand the slot back to the producers for the next lap
+		InterlockedExchange(&slot.sequence, s_dequeuePos + AL_NUM_SLOTS);
+		++s_dequeuePos;
+	}
+
+	LONG dropped = InterlockedExchange(&s_dropped, 0);
+	if (dropped && s_fp)
+	{
+		s_bytes += fprintf(s_fp, "*** %ld log messages dropped, the log could not keep up\n", (long)dropped);
+	}
+	if (s_fp)
+	{
+		fflush(s_fp);
+	}
+
+	LeaveCriticalSection(&s_cs);
+}
+
+static unsigned __stdcall alThreadMain (void* pData)
+{
+	while (!s_bStop)
+	{
+		WaitForSingleObject(s_wakeEvent, AL_WAKE_MS);
+		alDrain();
+	}
+	alDrain();
+	return 0;
+}
+
+static void alStopThread ()
+{
+	if (s_thread)
+	{
+		s_bStop = true;
+		SetEvent(s_wakeEvent);
+		WaitForSingleObject(s_thread, INFINITE);
+		CloseHandle(s_thread);
+		s_thread = NULL;
+	}
+}
+
+/*************************************************************************
+                              alSetLogFile
+ *************************************************************************
+
+   SYNOPSIS
+		bool alSetLogFile (const char* filename, string* pError)
+
+   PURPOSE
+		start logging to filename, appending if it's there.  ""
+		flushes and closes the log.  Main thread only.
+
+   RETURNS
+		false if the file could not be opened
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool alSetLogFile (const char* filename, string* pError)
+{
+	bool bOk = true;
+
+	alInit();
+
+	// stop taking messages, write out what we have
+	g_alLevel = -1;
+	alStopThread();
+	alDrain();
+
+	EnterCriticalSection(&s_cs);
+	if (s_fp)
+	{
+		fclose(s_fp);
+		s_fp = NULL;
+	}
+	s_logFile = filename;
+	if (!s_logFile.empty())
+	{
+		s_fp = fopen(filename, "a");
+		if (!s_fp)
+		{
+			*pError = string("could not open \"") + filename + "\"";
+			s_logFile.clear();
+			bOk = false;
+		}
+		else
+		{
+			fseek(s_fp, 0, SEEK_END);
+			s_bytes = ftell(s_fp);
+		}
+	}
+	LeaveCriticalSection(&s_cs);
+
+	if (!s_fp)
+	{
+		return bOk;
+	}
+
+	s_bStop  = false;
+	s_thread = (HANDLE)_beginthreadex(NULL, 0, alThreadMain, NULL, 0, NULL);
+	if (!s_thread)
+	{
+		*pError = "could not start log thread";
+		return false;
+	}
+
+	g_alLevel = s_level;
+	return true;
+}
+
+string alGetLogFile ()
+{
+	return s_logFile;
+}
+
+void alSetLevel (int level)
+{
+	s_level = level;
+	if (g_alLevel >= 0)
+	{
+		g_alLevel = level;
+	}
+}
+
+int alGetLevel ()
+{
+	return s_level;
+}
+
+/*************************************************************************
+                                 alWrite
+ *************************************************************************
+
+   SYNOPSIS
+		void alWrite (int level, const char* pText, size_t len)
+
+   PURPOSE
+		queue a message for the log.  Any thread.  Never blocks, if
+		the writer is that far behind the message is dropped.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void alWrite (int level, const char* pText, size_t len)
+{
+	if (!alWants(level) || level < AL_ERROR || level > AL_DEBUG)
+	{
+		return;
+	}
+
+	LONG pos = s_enqueuePos;
+
+	for (;;)
+	{
+		LogSlot& slot = s_slots[pos & (AL_NUM_SLOTS - 1)];
+		LONG     diff = slot.sequence - pos;
+
+		if (diff == 0)
+		{
+			// it's free, try to claim it
+			if (InterlockedCompareExchange(&s_enqueuePos, pos + 1, pos) == pos)
+			{
+				slot.level    = level;
+				slot.threadId = GetCurrentThreadId();
+				GetLocalTime(&slot.time);
+				if (len >= AL_SLOT_TEXT)
+				{
+					slot.pLong = (char*)malloc(len + 1);
+				}
+				if (slot.pLong)
+				{
+					memcpy(slot.pLong, pText, len);
+					slot.pLong[len] = '\0';
+				}
+				else
+				{
+					// short, or no memory for all of it
+					len = len < AL_SLOT_TEXT ? len : AL_SLOT_TEXT - 1;
+					memcpy(slot.text, pText, len);
+					slot.text[len] = '\0';
+				}
+				slot.len = len;
+
+				// now the writer can have it
+				InterlockedExchange(&slot.sequence, pos + 1);
+				return;
+			}
+			pos = s_enqueuePos;
+		}
+		else if (diff < 0)
+		{
+			// full
+			InterlockedIncrement(&s_dropped);
+			return;
+		}
+		else
+		{
+			// someone else got it first
+			pos = s_enqueuePos;
+		}
+	}
+}
+
+void alShutdown ()
+{
+	if (s_bInitialized)
+	{
+		string error;
+
+		alSetLogFile("", &error);
+		CloseHandle(s_wakeEvent);
+		DeleteCriticalSection(&s_cs);
+		s_bInitialized = false;
+	}
+}
+
@@ -0,0 +1,48 @@
+/*=======================================================================*
+ |   file name : asynclog.h
+ |-----------------------------------------------------------------------*
+ |   function  : log file written by a background thread
+ *=======================================================================*/
+
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+/*************************** c o n s t a n t s ***************************/
+
+// lower is more important.  alSetLevel(AL_STATUS) logs errors,
+// warnings and status but not debug messages
+#define AL_ERROR	0
+#define AL_WARNING	1
+#define AL_STATUS	2
+#define AL_DEBUG	3
+
+#define AL_DEFAULT_LEVEL	AL_STATUS
+#define AL_MAX_BYTES		(4 * 1024 * 1024)	// rotate after this much
+#define AL_NUM_OLD_LOGS		3					// keep log.1 to log.3
+
+/******************************* t y p e s *******************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+extern volatile int g_alLevel;	// -1 = no log file
+
+/****************************** m a c r o s ******************************/
+
+// cheap enough to check before formatting anything
+#define alWants(level)	((level) <= g_alLevel)
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool alSetLogFile (const char* filename, std::string* pError);
+extern std::string alGetLogFile ();
+extern void alSetLevel (int level);
+extern int alGetLevel ();
+extern void alWrite (int level, const char* pText, size_t len);
+extern void alShutdown ();
+
+#endif /* ASYNCLOG_H */
+
@@ -0,0 +1,538 @@
+/*=======================================================================*
+ |   file name : asyncqueue.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : run svn commands on a background thread
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <process.h>
+#include <stdio.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "asyncqueue.h"
+#include "lockcache.h"
+#include "statuscache.h"
+
+using std::deque;
+using std::map;
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct Job
+{
+	int				id;
+	JobState		state;
+	string			subcommand;
+	StringList		paths;
+	string			message;
+	string			callback;
+	StringList		results;
+	volatile long	cancel;
+};
+
+typedef map<int, Job*> JobMap;
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static bool				s_bInitialized;
+static CRITICAL_SECTION	s_cs;
+static HANDLE			s_thread;
+static HANDLE			s_wakeEvent;
+static bool				s_bStop;
+static int				s_nextId = 1;
+static JobMap			s_jobs;			// every job we still remember
+static deque<int>		s_queue;		// waiting to run
+static deque<int>		s_finished;		// delivered by aqTakeFinished, oldest first
+static vector<int>		s_undelivered;	// finished but not given to aqTakeFinished
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// call with s_cs held
+static void aqFinish (Job* pJob, JobState state)
+{
+	pJob->state = state;
+	s_undelivered.push_back(pJob->id);
+}
+
+// only jobs that have been delivered are forgotten, however many
+// finish between calls to aqTakeFinished.  Call with s_cs held
+static void aqForgetDelivered ()
+{
+	while (s_finished.size() > AQ_MAX_FINISHED)
+	{
+		JobMap::iterator it = s_jobs.find(s_finished.front());
+		s_finished.pop_front();
+		if (it != s_jobs.end())
+		{
+			delete it->second;
+			s_jobs.erase(it);
+		}
+	}
+}
+
+static unsigned __stdcall aqThreadMain (void* pData)
+{
+	for (;;)
+	{
+		Job* pJob = NULL;
+
+		EnterCriticalSection(&s_cs);
+		if (!s_queue.empty())
+		{
+			pJob = s_jobs[s_queue.front()];
+			s_queue.pop_front();
+			pJob->state = JOB_RUNNING;
+		}
+		else if (s_bStop)
+		{
+			LeaveCriticalSection(&s_cs);
+			break;
+		}
+		LeaveCriticalSection(&s_cs);
+
+		if (!pJob)
+		{
+			WaitForSingleObject(s_wakeEvent, INFINITE);
+			continue;
+		}
+
+		// the job can't be freed while it's running, only finished
+		// jobs get thrown away, so it's safe to use without the lock
+		StringList	results;
+		string		error;
+		bool		bOk = scRun(pJob->subcommand, pJob->paths, pJob->message, results, &error, &pJob->cancel);
+
+		if (pJob->subcommand != "info")
+		{
+			for (size_t ii = 0; ii < pJob->paths.size(); ++ii)
+			{
+				stMarkDirty(pJob->paths[ii].c_str());
+				lcInvalidate(pJob->paths[ii].c_str());
+			}
+		}
+
+		EnterCriticalSection(&s_cs);
+		if (bOk)
+		{
+			pJob->results = results;
+			aqFinish(pJob, JOB_DONE);
+		}
+		else
+		{
+			pJob->results.clear();
+			pJob->results.push_back(error);
+			aqFinish(pJob, pJob->cancel ? JOB_CANCELLED : JOB_FAILED);
+		}
+		LeaveCriticalSection(&s_cs);
+	}
+
+	return 0;
+}
+
+/*************************************************************************
+                              aqEnqueue
+ *************************************************************************
+
+   SYNOPSIS
+		int aqEnqueue (const string& subcommand, const StringList& paths,
+					   const string& message, const string& callback,
+					   string* pError)
+
+   PURPOSE
+		queue an svn command (see scRun) to run on the background
+		thread.  Jobs run one at a time in the order they were queued.
+		Must be called from the main thread.
+
+   INPUT
+		callback : just stored with the job for whoever takes it from
+				   aqTakeFinished
+
+   RETURNS
+		job id or 0 if the job could not be queued (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int aqEnqueue (const string& subcommand, const StringList& paths, const string& message,
+			   const string& callback, string* pError)
+{
+	if (!scIsSubcommand(subcommand.c_str()))
+	{
+		*pError = "unknown svn subcommand (" + subcommand + ")";
+		return 0;
+	}
+
+	// make sure svn gets started on this thread not the worker
+	if (!scInit(pError))
+	{
+		return 0;
+	}
+
+	if (!s_bInitialized)
+	{
+		InitializeCriticalSection(&s_cs);
+		s_wakeEvent    = CreateEvent(NULL, FALSE, FALSE, NULL);
+		s_bInitialized = true;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	if (!s_thread)
+	{
+		s_bStop  = false;
+		s_thread = (HANDLE)_beginthreadex(NULL, 0, aqThreadMain, NULL, 0, NULL);
+		if (!s_thread)
+		{
+			LeaveCriticalSection(&s_cs);
+			*pError = "could not start svn thread";
+			return 0;
+		}
+	}
+
+	Job* pJob = new Job;
+
+	pJob->id         = s_nextId++;
+	pJob->state      = JOB_QUEUED;
+	pJob->subcommand = subcommand;
+	pJob->paths      = paths;
+	pJob->message    = message;
+	pJob->callback   = callback;
+	pJob->cancel     = 0;
+
+	s_jobs[pJob->id] = pJob;
+	s_queue.push_back(pJob->id);
+
+	LeaveCriticalSection(&s_cs);
+
+	SetEvent(s_wakeEvent);
+
+	return pJob->id;
+}
+
+/*************************************************************************
+                              aqGetStatus
+ *************************************************************************
+
+   SYNOPSIS
+		JobState aqGetStatus (int id, StringList* pResults)
+
+   PURPOSE
+		get the state of a job and, if it's finished, its results
+
+   RETURNS
+		JOB_UNKNOWN if there is no such job or it finished so long
+		ago we forgot about it.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+JobState aqGetStatus (int id, StringList* pResults)
+{
+	if (!s_bInitialized)
+	{
+		return JOB_UNKNOWN;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	JobState state = JOB_UNKNOWN;
+	JobMap::const_iterator it = s_jobs.find(id);
+	if (it != s_jobs.end())
+	{
+		state = it->second->state;
+		if (state != JOB_QUEUED && state != JOB_RUNNING)
+		{
+			*pResults = it->second->results;
+		}
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return state;
+}
+
+/*************************************************************************
+                              aqCancel
+ *************************************************************************
+
+   SYNOPSIS
+		bool aqCancel (int id)
+
+   PURPOSE
+		cancel a job.  A queued job is dropped.  A running job is asked
+		to stop and finishes as cancelled the next time svn checks
+		(a commit that already reached the server still happens).
+
+   RETURNS
+		false if the job is unknown or already finished
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool aqCancel (int id)
+{
+	if (!s_bInitialized)
+	{
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	bool bCancelled = false;
+	JobMap::iterator it = s_jobs.find(id);
+	if (it != s_jobs.end())
+	{
+		Job* pJob = it->second;
+		if (pJob->state == JOB_QUEUED)
+		{
+			for (deque<int>::iterator qit = s_queue.begin(); qit != s_queue.end(); ++qit)
+			{
+				if (*qit == id)
+				{
+					s_queue.erase(qit);
+					break;
+				}
+			}
+			pJob->results.push_back("cancelled");
+			aqFinish(pJob, JOB_CANCELLED);
+			bCancelled = true;
+		}
+		else if (pJob->state == JOB_RUNNING)
+		{
+			InterlockedExchange(&pJob->cancel, 1);
+			bCancelled = true;
+		}
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return bCancelled;
+}
+
+/*************************************************************************
+                              aqTakeFinished
+ *************************************************************************
+
+   SYNOPSIS
+		void aqTakeFinished (vector<JobResult>& finished)
+
+   PURPOSE
+		get the jobs that finished since the last call.  Each job is
+		returned once.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void aqTakeFinished (vector<JobResult>& finished)
+{
+	if (!s_bInitialized)
+	{
+		return;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	for (size_t ii = 0; ii < s_undelivered.size(); ++ii)
+	{
+		JobMap::const_iterator it = s_jobs.find(s_undelivered[ii]);
+		if (it != s_jobs.end())
+		{
+			JobResult jr;
+
+			jr.id       = it->second->id;
+			jr.state    = it->second->state;
+			jr.callback = it->second->callback;
+			jr.results  = it->second->results;
+			finished.push_back(jr);
+			s_finished.push_back(jr.id);
+		}
+	}
+	s_undelivered.clear();
+	aqForgetDelivered();
+
+	LeaveCriticalSection(&s_cs);
+}
+
+/*************************************************************************
+                              aqNumOutstanding
+ *************************************************************************
+
+   SYNOPSIS
+		int aqNumOutstanding ()
+
+   PURPOSE
+		number of jobs queued, running or finished but not yet taken
+		by aqTakeFinished
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int aqNumOutstanding ()
+{
+	if (!s_bInitialized)
+	{
+		return 0;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	int count = (int)(s_queue.size() + s_undelivered.size());
+	for (JobMap::const_iterator it = s_jobs.begin(); it != s_jobs.end(); ++it)
+	{
+		if (it->second->state == JOB_RUNNING)
+		{
+			++count;
+		}
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return count;
+}
+
+/*************************************************************************
+                              aqDrain
+ *************************************************************************
+
+   SYNOPSIS
+		bool aqDrain (StringList* pAbandoned)
+
+   PURPOSE
+		run everything still queued then stop the thread.  Called when
+		maya exits or the plugin is unloaded.  We wait rather than
+		cancel because queued jobs are usually commits and unlocks
+		the user expects to happen, but only for AQ_DRAIN_WAIT_MS.  A
+		server that doesn't answer or svn asking for a password must
+		not keep maya from exiting.  After that queued jobs are
+		dropped and the running one is cancelled.
+
+   OUTPUT
+		pAbandoned : a line for each job that was dropped or
+					 cancelled, for telling the user
+
+   RETURNS
+		false if the thread still hasn't stopped
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static string aqDescribe (const Job* pJob)
+{
+	char	buf[32];
+	string	desc;
+
+	sprintf(buf, "job %d: svn ", pJob->id);
+	desc = buf + pJob->subcommand;
+	for (size_t ii = 0; ii < pJob->paths.size(); ++ii)
+	{
+		desc += " \"" + pJob->paths[ii] + "\"";
+	}
+	return desc;
+}
+
+bool aqDrain (StringList* pAbandoned)
+{
+	if (!s_bInitialized)
+	{
+		return true;
+	}
+
+	EnterCriticalSection(&s_cs);
+	HANDLE thread = s_thread;
+	s_bStop = true;
+	LeaveCriticalSection(&s_cs);
+
+	if (!thread)
+	{
+		return true;
+	}
+
+	SetEvent(s_wakeEvent);
+	if (WaitForSingleObject(thread, AQ_DRAIN_WAIT_MS) == WAIT_TIMEOUT)
+	{
+		EnterCriticalSection(&s_cs);
+		while (!s_queue.empty())
+		{
+			Job* pJob = s_jobs[s_queue.front()];
+
+			s_queue.pop_front();
+			pAbandoned->push_back(aqDescribe(pJob) + " (never started)");
+			pJob->results.push_back("cancelled");
+			aqFinish(pJob, JOB_CANCELLED);
+		}
+		for (JobMap::iterator it = s_jobs.begin(); it != s_jobs.end(); ++it)
+		{
+			if (it->second->state == JOB_RUNNING)
+			{
+				pAbandoned->push_back(aqDescribe(it->second) + " (cancelled while running)");
+				InterlockedExchange(&it->second->cancel, 1);
+			}
+		}
+		LeaveCriticalSection(&s_cs);
+
+		if (WaitForSingleObject(thread, AQ_CANCEL_WAIT_MS) == WAIT_TIMEOUT)
+		{
+			return false;
+		}
+	}
+	CloseHandle(thread);
+
+	EnterCriticalSection(&s_cs);
+	s_thread = NULL;
+	LeaveCriticalSection(&s_cs);
+	return true;
+}
+
+// false if the thread would not stop, in which case everything it uses
+// is left alone
+bool aqShutdown ()
+{
+	if (s_bInitialized)
+	{
+		StringList abandoned;
+
+		if (!aqDrain(&abandoned))
+		{
+			return false;
+		}
+
+		for (JobMap::iterator it = s_jobs.begin(); it != s_jobs.end(); ++it)
+		{
+			delete it->second;
+		}
+		s_jobs.clear();
+		s_queue.clear();
+		s_finished.clear();
+		s_undelivered.clear();
+
+		CloseHandle(s_wakeEvent);
+		DeleteCriticalSection(&s_cs);
+		s_bInitialized = false;
+	}
+	return true;
+}
+
+const char* aqStateName (JobState state)
+{
+	switch (state)
+	{
+	case JOB_QUEUED:    return "queued";
+	case JOB_RUNNING:   return "running";
+	case JOB_DONE:      return "done";
+	case JOB_FAILED:    return "failed";
+	case JOB_CANCELLED: return "cancelled";
+	default:            return "unknown";
+	}
+}
+
@@ -0,0 +1,64 @@
+/*=======================================================================*
+ |   file name : asyncqueue.h
+ |-----------------------------------------------------------------------*
+ |   function  : run svn commands on a background thread
+ *=======================================================================*/
+
+#ifndef ASYNCQUEUE_H
+#define ASYNCQUEUE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+#include "svnclient.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+// how many delivered jobs we remember for aqGetStatus
+#define AQ_MAX_FINISHED	64
+
+// how long aqDrain lets queued jobs finish before giving up on them and
+// then how long it waits for the running one to notice it was cancelled
+#define AQ_DRAIN_WAIT_MS	30000
+#define AQ_CANCEL_WAIT_MS	5000
+
+/******************************* t y p e s *******************************/
+
+enum JobState
+{
+	JOB_UNKNOWN,
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,
+	JOB_FAILED,
+	JOB_CANCELLED
+};
+
+struct JobResult
+{
+	int			id;
+	JobState	state;
+	std::string	callback;
+	StringList	results;	// from scRun or the error if the job failed
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern int  aqEnqueue (const std::string& subcommand, const StringList& paths, const std::string& message,
+					   const std::string& callback, std::string* pError);
+extern JobState aqGetStatus (int id, StringList* pResults);
+extern bool aqCancel (int id);
+extern void aqTakeFinished (std::vector<JobResult>& finished);
+extern int  aqNumOutstanding ();
+extern bool aqDrain (StringList* pAbandoned);
+extern bool aqShutdown ();
+extern const char* aqStateName (JobState state);
+
+#endif /* ASYNCQUEUE_H */
+
@@ -0,0 +1,333 @@
+/*=======================================================================*
+ |   file name : coretest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the parts of mayaSvn that don't need Maya
+ *=======================================================================*/
+
+/*
+   coretest [-v] [test]...
+
+   Runs the named tests, or all of them.  Prints every check that fails
+   (every check with -v) and returns 1 if any did.
+
+   dbgprint.cpp needs Maya so the dbgprint functions the cores use are
+   here and say nothing.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "coretest.h"
+#include "dbgprint.h"
+#include "pathnorm.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_TICKS_PER_SEC	((LONGLONG)10000000)	// FILETIME
+
+/******************************* t y p e s *******************************/
+
+struct CoreTest
+{
+	const char*	pName;
+	void		(*pFunc)();
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static const CoreTest s_tests[] =
+{
+	{ "eventdispatch",	testEventDispatch },
+	{ "filecopy",		testFileCopy },
+	{ "hashindex",		testHashIndex },
+	{ "lockcache",		testLockCache },
+	{ "procrun",		testProcRun },
+	{ "seqscan",		testSeqScan },
+	{ "statuscache",	testStatusCache },
+	{ "svnclient",		testSvnClient },
+	{ "syncplan",		testSyncPlan },
+	{ "texmanifest",	testTexManifest },
+	{ "threadpool",		testThreadPool },
+};
+
+static FakeSvn*	s_pFakeSvn;		// only one at a time, StatusQueryFunc has no context
+static bool		s_bVerbose;
+static unsigned	s_numChecks;
+static unsigned	s_numFailed;
+
+/****************************** m a c r o s ******************************/
+
+#define NUM_TESTS	(sizeof(s_tests) / sizeof(s_tests[0]))
+
+/**************************** r o u t i n e s ****************************/
+
+int dbgGetDebug ()
+{
+	return 0;
+}
+
+int dbgPrintf (const char *fmt, ...)
+{
+	return 0;
+}
+
+bool ctCheck (bool bOk, const char* pExpr, const char* pFile, int line)
+{
+	++s_numChecks;
+	if (!bOk)
+	{
+		++s_numFailed;
+		printf ("FAILED %s(%d): %s\n", pFile, line, pExpr);
+	}
+	else if (s_bVerbose)
+	{
+		printf ("ok     %s(%d): %s\n", pFile, line, pExpr);
+	}
+	return bOk;
+}
+
+// FsInterface::listFiles, like FindFirstFile the prefix doesn't care
+// about case and a folder that isn't there is just empty
+static bool ctFakeListFiles (const char* dir, const char* namePrefix, vector<string>* pNames, string* pError, void* pContext)
+{
+	FakeFs*	pFake = (FakeFs*)pContext;
+	string	key = puNormalizePath(dir) + "/";
+	size_t	len = strlen(namePrefix);
+
+	++pFake->numListings;
+	pNames->clear();
+	if (key == pFake->badDir)
+	{
+		*pError = "could not list \"" + string(dir) + "\"";
+		return false;
+	}
+
+	map<string, vector<string> >::const_iterator it = pFake->dirs.find(key);
+	if (it == pFake->dirs.end())
+	{
+		return true;
+	}
+	for (size_t ii = 0; ii < it->second.size(); ++ii)
+	{
+		const string& name = it->second[ii];
+
+		if (name.size() >= len && !_strnicmp(name.c_str(), namePrefix, len))
+		{
+			pNames->push_back(name);
+		}
+	}
+	return true;
+}
+
+// an empty tree and an FsInterface that lists it
+void ctInitFakeFs (FakeFs* pFake, FsInterface* pFs)
+{
+	pFake->dirs.clear();
+	pFake->badDir.erase();
+	pFake->numListings = 0;
+	pFs->listFiles = ctFakeListFiles;
+	pFs->pContext  = pFake;
+}
+
+void ctAddFakeFiles (FakeFs* pFake, const char* dir, const char* const* ppNames, size_t numNames)
+{
+	vector<string>& names = pFake->dirs[puNormalizePath(dir) + "/"];
+
+	names.insert(names.end(), ppNames, ppNames + numNames);
+}
+
+// StatusQueryFunc.  Like svn an unversioned path just says nothing
+static bool ctFakeStatus (const char* path, bool bRecurse, StatusFunc func, void* pContext, string* pError)
+{
+	FakeSvn*	pFake = s_pFakeSvn;
+	string		key   = puNormalizePath(path);
+
+	pFake->queries.push_back(string(path) + (bRecurse ? " -R" : ""));
+	if (pFake->bFail)
+	{
+		*pError = "could not reach \"" + string(path) + "\"";
+		return false;
+	}
+
+	map<string, SvnStatus>::const_iterator it = pFake->statuses.lower_bound(key);
+	for (; it != pFake->statuses.end() && !it->first.compare(0, key.size(), key); ++it)
+	{
+		if (it->first.size() == key.size() || (bRecurse && it->first[key.size()] == '/'))
+		{
+			func(it->second, pContext);
+		}
+	}
+	return true;
+}
+
+// a server with nothing on it, and the StatusQueryFunc that asks it
+StatusQueryFunc ctInitFakeSvn (FakeSvn* pFake)
+{
+	pFake->statuses.clear();
+	pFake->queries.clear();
+	pFake->bFail = false;
+	s_pFakeSvn   = pFake;
+	return ctFakeStatus;
+}
+
+// what status will say about path from now on
+void ctSetFakeStatus (FakeSvn* pFake, const string& path, const char* status, bool bIsDir)
+{
+	SvnStatus& entry = pFake->statuses[puNormalizePath(path.c_str())];
+
+	entry.path            = path;
+	entry.status          = status;
+	entry.bVersioned      = status[0] != '?';
+	entry.bIsDir          = bIsDir;
+	entry.bOutOfDate      = false;
+	entry.revision        = 1;
+	entry.changedRevision = 1;
+}
+
+// a new empty folder for a test to write in
+bool ctMakeTempDir (const char* name, string* pDir)
+{
+	char tempDir[MAX_PATH];
+	char buf[64];
+
+	GetTempPath(sizeof(tempDir), tempDir);
+	_snprintf (buf, sizeof(buf), "coretest.%lu.%s", (unsigned long)GetCurrentProcessId(), name);
+	buf[sizeof(buf) - 1] = '\0';
+
+	*pDir = string(tempDir) + buf;
+	ctRemoveDir(*pDir);
+	return CreateDirectory(pDir->c_str(), NULL) != 0;
+}
+
+// dir and everything in it
+void ctRemoveDir (const string& dir)
+{
+	WIN32_FIND_DATA	fd;
+	HANDLE			hFind = FindFirstFile((dir + "\\*").c_str(), &fd);
+
+	if (hFind != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			string path = dir + "\\" + fd.cFileName;
+
+			if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			{
+				SetFileAttributes(path.c_str(), FILE_ATTRIBUTE_NORMAL);
+				DeleteFile(path.c_str());
+			}
+			else if (strcmp(fd.cFileName, ".") && strcmp(fd.cFileName, ".."))
+			{
+				ctRemoveDir(path);
+			}
+		} while (FindNextFile(hFind, &fd));
+		FindClose(hFind);
+	}
+	RemoveDirectory(dir.c_str());
+}
+
+// write pData to path and date it ageSecs ago
+bool ctWriteFile (const string& path, const char* pData, int ageSecs)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	bool bOk = fwrite(pData, 1, strlen(pData), fp) == strlen(pData);
+
+	bOk = (fclose(fp) == 0) && bOk;
+	if (!bOk || !ageSecs)
+	{
+		return bOk;
+	}
+
+	HANDLE fh = CreateFile(path.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fh == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	FILETIME		ft;
+	ULARGE_INTEGER	ticks;
+
+	GetSystemTimeAsFileTime(&ft);
+	ticks.LowPart     = ft.dwLowDateTime;
+	ticks.HighPart    = ft.dwHighDateTime;
+	ticks.QuadPart   -= ageSecs * CT_TICKS_PER_SEC;
+	ft.dwLowDateTime  = ticks.LowPart;
+	ft.dwHighDateTime = ticks.HighPart;
+
+	bOk = SetFileTime(fh, NULL, NULL, &ft) != 0;
+	CloseHandle(fh);
+	return bOk;
+}
+
+static int usage ()
+{
+	fprintf (stderr, "usage: coretest [-v] [test]...\ntests:");
+	for (size_t ii = 0; ii < NUM_TESTS; ++ii)
+	{
+		fprintf (stderr, " %s", s_tests[ii].pName);
+	}
+	fprintf (stderr, "\n");
+	return 2;
+}
+
+int main (int argc, char** argv)
+{
+	bool	bRun[NUM_TESTS];
+	bool	bAll = true;
+
+	memset(bRun, 0, sizeof(bRun));
+	for (int ii = 1; ii < argc; ++ii)
+	{
+		if (!strcmp(argv[ii], "-v"))
+		{
+			s_bVerbose = true;
+			continue;
+		}
+
+		size_t tt = 0;
+
+		while (tt < NUM_TESTS && _stricmp(argv[ii], s_tests[tt].pName))
+		{
+			++tt;
+		}
+		if (tt == NUM_TESTS)
+		{
+			return usage();
+		}
+		bRun[tt] = true;
+		bAll     = false;
+	}
+
+	for (size_t ii = 0; ii < NUM_TESTS; ++ii)
+	{
+		if (bAll || bRun[ii])
+		{
+			unsigned failed = s_numFailed;
+
+			s_tests[ii].pFunc();
+			printf ("%-14s %s\n", s_tests[ii].pName, s_numFailed == failed ? "ok" : "FAILED");
+		}
+	}
+
+	printf ("%u checks, %u failed\n", s_numChecks, s_numFailed);
+	return s_numFailed ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+/*=======================================================================*
+ |   file name : coretest.h
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the parts of mayaSvn that don't need Maya
+ *=======================================================================*/
+
+/*
+   Each module with checks has a <module>test.cpp with one entry point,
+   listed in coretest.cpp's s_tests.  CHECK counts and prints, it doesn't
+   stop the test so one run shows everything that's wrong.
+*/
+
+#ifndef CORETEST_H
+#define CORETEST_H
+/**************************** i n c l u d e s ****************************/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fsiface.h"
+#include "svnclient.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// a folder tree that only exists in memory, see ctInitFakeFs
+struct FakeFs
+{
+	std::map<std::string, std::vector<std::string> >	dirs;	// normalized folder + "/" -> names in it
+	std::string											badDir;	// same form as dirs, listing it fails
+	unsigned											numListings;
+};
+
+// a server that only exists in memory, see ctInitFakeSvn
+struct FakeSvn
+{
+	std::map<std::string, SvnStatus>	statuses;	// normalized path -> what status says about it
+	std::vector<std::string>			queries;	// path, then " -R" if recursive, for every status asked for
+	bool								bFail;		// every status fails
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+#define CHECK(expr)		ctCheck((expr), #expr, __FILE__, __LINE__)
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool ctCheck (bool bOk, const char* pExpr, const char* pFile, int line);
+extern void ctInitFakeFs (FakeFs* pFake, FsInterface* pFs);
+extern void ctAddFakeFiles (FakeFs* pFake, const char* dir, const char* const* ppNames, size_t numNames);
+extern StatusQueryFunc ctInitFakeSvn (FakeSvn* pFake);
+extern void ctSetFakeStatus (FakeSvn* pFake, const std::string& path, const char* status, bool bIsDir);
+extern bool ctMakeTempDir (const char* name, std::string* pDir);
+extern void ctRemoveDir (const std::string& dir);
+extern bool ctWriteFile (const std::string& path, const char* pData, int ageSecs);
+
+extern void testEventDispatch ();		// eventdispatchtest.cpp
+extern void testFileCopy ();		// filecopytest.cpp
+extern void testHashIndex ();		// hashindextest.cpp
+extern void testLockCache ();		// lockcachetest.cpp
+extern void testProcRun ();		// procruntest.cpp
+extern void testSeqScan ();		// seqscantest.cpp
+extern void testStatusCache ();		// statuscachetest.cpp
+extern void testSvnClient ();		// svnclienttest.cpp
+extern void testSyncPlan ();		// syncplantest.cpp
+extern void testTexManifest ();		// texmanifesttest.cpp
+extern void testThreadPool ();		// threadpooltest.cpp
+
+#endif /* CORETEST_H */
+
@@ -9,6 +9,8 @@
 /**************************** i n c l u d e s ****************************/
 
 #include <maya/mglobal.h>
+#include <stdlib.h>
+#include "asynclog.h"
 #include "dbgprint.h"
 
 /*************************** c o n s t a n t s ***************************/
@@ -32,6 +34,10 @@ static int fDebug;
 
 /****************************** m a c r o s ******************************/
 
+// VC before 2013 has no va_copy.  Its va_list is just a pointer
+#ifndef va_copy
+#define va_copy(dst, src)	((dst) = (src))
+#endif
 
 /**************************** r o u t i n e s ****************************/
 
@@ -39,10 +45,30 @@ void dbgReset() { numErrors = 0; numWarnings = 0; fDebug = false; }
 int dbgGetNumErrors () { return numErrors; }
 int dbgGetNumWarnings () { return numWarnings; }
 int dbgSetDebug (int on) { int old = fDebug; fDebug = on; return old; }
+int dbgGetDebug () { return fDebug; }
+
+// with a log file the log has everything.  The screen still gets what
+// someone in Maya has to see, errors and warnings, but a batch session
+// on the farm has nobody watching so it only writes the log
+static bool dbgWantsScreen (int type, bool bLogged)
+{
+	if (!bLogged)
+	{
+		return type != DBG_DEBUG || fDebug;
+	}
+	return (type == DBG_ERROR || type == DBG_WARN) && MGlobal::mayaState() == MGlobal::kInteractive;
+}
 
 static void dbgPrintToAll (const char* str, int type)
 {
+	static const char* prefixes[] = { "", "WARNING : ", "ERROR : ", "", "", };
+
+	OutputDebugString (prefixes[type]);
 	OutputDebugString (str);
+	if (type != DBG_DEBUG)
+	{
+		OutputDebugString ("\n");
+	}
 
 	switch (type)
 	{
@@ -96,17 +122,50 @@ int dbgVPrintf (const char *pszFormat, va_list ap, int type)
 {
 #define DBG_VPRINTF_CHARS_MAX  1023
 
+	static const int logLevels[] = { 0, AL_WARNING, AL_ERROR, AL_DEBUG, AL_STATUS, };
+
 	char szTemp[DBG_VPRINTF_CHARS_MAX+1];
+	char* pszText = szTemp;
 	int len;
+	va_list apCount;
+
+	// anything too long for the stack gets the heap.  Counting uses up a
+	// va_list so it gets its own
+	va_copy (apCount, ap);
+	len = _vscprintf (pszFormat, apCount);
+	va_end (apCount);
+	if (len < 0)
+	{
+		return len;
+	}
+	if (len > DBG_VPRINTF_CHARS_MAX)
+	{
+		pszText = (char*)malloc (len + 1);
+		if (!pszText)
+		{
+			return -1;
+		}
+	}
+	_vsnprintf (pszText, len + 1, pszFormat, ap);
+	pszText[len] = '\0';
 
-	len = _vsnprintf (szTemp, DBG_VPRINTF_CHARS_MAX, pszFormat,ap);
+	int level = logLevels[type];
+	bool bLogged = alWants(level);
+	if (bLogged)
+	{
+		alWrite (level, pszText, len);
+	}
 
-	if (len == -1 && len == DBG_VPRINTF_CHARS_MAX)
+	// printing is what makes debugging slow, see dbgWantsScreen
+	if (dbgWantsScreen(type, bLogged))
 	{
-		strcpy (szTemp, "dbgVPrintf() needs larger string buffer!\n");
+		dbgPrintToAll (pszText, type);
 	}
 
-	dbgPrintToAll (szTemp, type);
+	if (pszText != szTemp)
+	{
+		free (pszText);
+	}
 
 	return len;
 
@@ -148,7 +207,8 @@ int dbgVPrintf (const char *pszFormat, va_list ap, int type)
 
 int dbgPrintf (const char *frmt, ...)
 {
-	if (fDebug)
+	// decide before formatting anything
+	if (fDebug || alWants(AL_DEBUG))
 	{
 		int len;
 
@@ -199,7 +259,6 @@ int dbgPrintf (const char *frmt, ...)
 int errVPrintf (const char* fmt, va_list ap)
 {
 	++numErrors;
-	OutputDebugString ("ERROR : ");
 	return dbgVPrintf (fmt, ap, DBG_ERROR);
 }
 int errPrintf (const char *frmt, ...)
@@ -211,8 +270,6 @@ int errPrintf (const char *frmt, ...)
 	len = errVPrintf (frmt, ap);
 	va_end (ap);	/* clean up when done */
 
-	OutputDebugString ("\n");
-
 	return len;
 }
 
@@ -222,14 +279,11 @@ int warnPrintf (const char *frmt, ...)
 	va_list ap;	/* points to each unnamed arg in turn */
 
 	++numWarnings;
-	OutputDebugString ("WARNING : ");
 
 	va_start (ap,frmt); /* make ap point to 1st unnamed arg */
 	len = dbgVPrintf (frmt, ap, DBG_WARN);
 	va_end (ap);	/* clean up when done */
 
-	OutputDebugString ("\n");
-
 	return len;
 }
 
@@ -242,8 +296,6 @@ int statPrintf (const char *frmt, ...)
 	len = dbgVPrintf (frmt, ap, DBG_STATUS);
 	va_end (ap);	/* clean up when done */
 
-	OutputDebugString ("\n");
-
 	return len;
 }
 
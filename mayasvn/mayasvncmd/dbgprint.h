@@ -30,6 +30,7 @@
 
 extern void dbgReset();
 extern int dbgSetDebug (int on);
+extern int dbgGetDebug ();
 extern int dbgGetNumErrors ();
 extern int dbgGetNumWarnings ();
 extern int errPrintf (const char *fmt, ...);
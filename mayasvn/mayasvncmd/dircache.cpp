@@ -0,0 +1,642 @@
+/*=======================================================================*
+ |   file name : dircache.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : directory listings of the project folders kept in
+ |               memory, thrown away when windows says they changed
+ *=======================================================================*/
+
+/*
+   The project folders live on a file server so every "file -q -ex" and
+   getFileList is a round trip.  Folders under a root given to
+   dcSetRoots are listed once and kept, along with the size and time of
+   everything in them.  A thread sits in ReadDirectoryChangesW on each
+   root and throws away the listing of any folder windows says changed.
+   If windows loses track (too many changes at once) the whole root is
+   thrown away.  Anything outside the roots, or under a root we could
+   not watch, goes to the disk every time.
+
+   A listing read while a change comes in could be stale so listings are
+   only stored if nothing was invalidated while they were being read.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <process.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dircache.h"
+#include "pathutil.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define DC_BUFFER_SIZE	(32 * 1024)	// network shares fail above 64k
+#define DC_NOTIFY_FILTER	(FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | \
+							 FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+/******************************* t y p e s *******************************/
+
+struct WatchRoot
+{
+	string		path;		// as given, no trailing slash
+	string		key;		// normalized
+	HANDLE		hDir;
+	HANDLE		hEvent;
+	OVERLAPPED	overlapped;
+	bool		bWatching;	// false = gave up, everything under it goes to disk
+	DWORD		buffer[DC_BUFFER_SIZE / sizeof(DWORD)];	// must be DWORD aligned
+};
+
+struct DirListing
+{
+	bool			bExists;
+	vector<DirItem>	items;		// sorted by name, case insensitive
+};
+
+typedef map<string, DirListing> DirMap;	// keyed by normalized path
+
+struct ltdiritem
+{
+	bool operator()(const DirItem& i1, const DirItem& i2) const
+	{
+		return _stricmp(i1.name.c_str(), i2.name.c_str()) < 0;
+	}
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static volatile LONG		s_csState;		// 0 = no s_cs yet, 1 = being made, 2 = ready
+static CRITICAL_SECTION		s_cs;
+static vector<WatchRoot*>	s_roots;
+static DirMap				s_dirs;
+static unsigned				s_generation;	// bumped by every invalidation
+static HANDLE				s_thread;
+static HANDLE				s_wakeEvent;
+static volatile bool		s_bStop;
+static DirCacheStats		s_stats;
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// dcInvalidate is called from the copy threads so this has to be safe
+// to race
+static void dcInit ()
+{
+	if (InterlockedCompareExchange(&s_csState, 1, 0) == 0)
+	{
+		InitializeCriticalSection(&s_cs);
+		s_wakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		InterlockedExchange(&s_csState, 2);
+	}
+	while (s_csState != 2)
+	{
+		Sleep(0);
+	}
+}
+
+// strip trailing slashes, leaving "x:/" alone
+static string dcTrimPath (const char* path)
+{
+	string result = path;
+
+	while (result.size() > 1 && (result[result.size() - 1] == '/' || result[result.size() - 1] == '\\') &&
+		   result[result.size() - 2] != ':')
+	{
+		result.erase(result.size() - 1);
+	}
+	return result;
+}
+
+// the root key is under, NULL if none.  Call with s_cs held
+static WatchRoot* dcFindRoot (const string& key)
+{
+	for (size_t ii = 0; ii < s_roots.size(); ++ii)
+	{
+		WatchRoot* pRoot = s_roots[ii];
+
+		if (pRoot->bWatching &&
+			key.compare(0, pRoot->key.size(), pRoot->key) == 0 &&
+			(key.size() == pRoot->key.size() || key[pRoot->key.size()] == '/'))
+		{
+			return pRoot;
+		}
+	}
+	return NULL;
+}
+
+// forget key, the folder it's in and everything under it.  Call with s_cs held
+static void dcForget (const string& key)
+{
+	size_t slash = key.rfind('/');
+
+	if (slash != string::npos)
+	{
+		s_dirs.erase(key.substr(0, slash));
+	}
+
+	string	under = key + "/";
+	DirMap::iterator it = s_dirs.lower_bound(key);
+
+	while (it != s_dirs.end() && (it->first == key || it->first.compare(0, under.size(), under) == 0))
+	{
+		s_dirs.erase(it++);
+	}
+
+	++s_generation;
+	++s_stats.invalidations;
+}
+
+static bool dcFindItem (const DirListing& listing, const string& name, PathInfo* pInfo)
+{
+	DirItem item;
+
+	item.name = name;
+
+	vector<DirItem>::const_iterator it = std::lower_bound(listing.items.begin(), listing.items.end(), item, ltdiritem());
+	if (it == listing.items.end() || _stricmp(it->name.c_str(), name.c_str()))
+	{
+		return false;
+	}
+
+	pInfo->bExists = true;
+	pInfo->bIsDir  = it->bIsDir;
+	pInfo->size    = it->size;
+	pInfo->mtime   = it->mtime;
+	return true;
+}
+
+static bool dcReadDir (const string& path, DirListing* pListing, string* pError)
+{
+	WIN32_FIND_DATA	fd;
+	string			pattern = path + "\\*";
+	HANDLE			hFind = FindFirstFile(pattern.c_str(), &fd);
+
+	pListing->items.clear();
+	pListing->bExists = true;
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		DWORD err = GetLastError();
+
+		// an empty drive
+		if (err == ERROR_FILE_NOT_FOUND)
+		{
+			return true;
+		}
+
+		// a folder that isn't there is an answer too
+		pListing->bExists = false;
+		if (err == ERROR_PATH_NOT_FOUND)
+		{
+			return true;
+		}
+
+		char buf[64];
+		sprintf(buf, "could not list \"%s\" (error %lu)", path.c_str(), (unsigned long)err);
+		*pError = buf;
+		return false;
+	}
+
+	do
+	{
+		if (!strcmp(fd.cFileName, ".") || !strcmp(fd.cFileName, ".."))
+		{
+			continue;
+		}
+
+		DirItem item;
+
+		item.name   = fd.cFileName;
+		item.bIsDir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		item.size   = ((unsigned __int64)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+		item.mtime  = FILETIME_TO_U64(fd.ftLastWriteTime);
+		pListing->items.push_back(item);
+	} while (FindNextFile(hFind, &fd));
+
+	FindClose(hFind);
+
+	std::sort(pListing->items.begin(), pListing->items.end(), ltdiritem());
+	return true;
+}
+
+// the listing of path, from memory if we can
+static bool dcGetListing (const string& path, DirListing* pListing, string* pError)
+{
+	string key = puNormalizePath(path.c_str());
+
+	EnterCriticalSection(&s_cs);
+
+	bool		bCached    = dcFindRoot(key) != NULL;
+	unsigned	generation = s_generation;
+
+	if (bCached)
+	{
+		DirMap::const_iterator it = s_dirs.find(key);
+		if (it != s_dirs.end())
+		{
+			*pListing = it->second;
+			++s_stats.hits;
+			LeaveCriticalSection(&s_cs);
+			return true;
+		}
+		++s_stats.misses;
+	}
+	else
+	{
+		++s_stats.uncached;
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	// no lock while we go to the disk
+	if (!dcReadDir(path, pListing, pError))
+	{
+		return false;
+	}
+
+	if (bCached)
+	{
+		EnterCriticalSection(&s_cs);
+		if (generation == s_generation && dcFindRoot(key))
+		{
+			s_dirs[key] = *pListing;
+		}
+		LeaveCriticalSection(&s_cs);
+	}
+	return true;
+}
+
+// ask for the next batch of changes.  Watcher thread or dcSetRoots
+static bool dcWatch (WatchRoot* pRoot)
+{
+	memset(&pRoot->overlapped, 0, sizeof(pRoot->overlapped));
+	pRoot->overlapped.hEvent = pRoot->hEvent;
+
+	return ReadDirectoryChangesW(pRoot->hDir, pRoot->buffer, sizeof(pRoot->buffer), TRUE,
+								 DC_NOTIFY_FILTER, NULL, &pRoot->overlapped, NULL) != 0;
+}
+
+static void dcHandleChanges (WatchRoot* pRoot)
+{
+	DWORD bytes = 0;
+
+	if (!GetOverlappedResult(pRoot->hDir, &pRoot->overlapped, &bytes, FALSE))
+	{
+		bytes = 0;
+	}
+
+	EnterCriticalSection(&s_cs);
+	if (!bytes)
+	{
+		// the buffer overflowed, we don't know what changed
+		++s_stats.overflows;
+		dcForget(pRoot->key);
+	}
+	else
+	{
+		const char* p = (const char*)pRoot->buffer;
+
+		for (;;)
+		{
+			const FILE_NOTIFY_INFORMATION*	pInfo = (const FILE_NOTIFY_INFORMATION*)p;
+			char							name[MAX_PATH * 2];
+			int len = WideCharToMultiByte(CP_ACP, 0, pInfo->FileName, pInfo->FileNameLength / sizeof(WCHAR),
+										  name, sizeof(name) - 1, NULL, NULL);
+
+			name[len > 0 ? len : 0] = '\0';
+			dcForget(puNormalizePath((pRoot->path + "/" + name).c_str()));
+
+			if (!pInfo->NextEntryOffset)
+			{
+				break;
+			}
+			p += pInfo->NextEntryOffset;
+		}
+	}
+
+	if (!dcWatch(pRoot))
+	{
+		// the folder went away or the server stopped talking to us
+		pRoot->bWatching = false;
+		dcForget(pRoot->key);
+	}
+	LeaveCriticalSection(&s_cs);
+}
+
+static unsigned __stdcall dcThreadMain (void* pData)
+{
+	while (!s_bStop)
+	{
+		HANDLE		handles[DC_MAX_ROOTS + 1];
+		WatchRoot*	roots[DC_MAX_ROOTS + 1];
+		DWORD		numHandles = 0;
+
+		handles[numHandles++] = s_wakeEvent;
+		EnterCriticalSection(&s_cs);
+		for (size_t ii = 0; ii < s_roots.size(); ++ii)
+		{
+			if (s_roots[ii]->bWatching)
+			{
+				roots[numHandles]     = s_roots[ii];
+				handles[numHandles++] = s_roots[ii]->hEvent;
+			}
+		}
+		LeaveCriticalSection(&s_cs);
+
+		DWORD result = WaitForMultipleObjects(numHandles, handles, FALSE, INFINITE);
+
+		if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + numHandles)
+		{
+			dcHandleChanges(roots[result - WAIT_OBJECT_0]);
+		}
+	}
+	return 0;
+}
+
+static void dcStopWatching ()
+{
+	if (s_thread)
+	{
+		s_bStop = true;
+		SetEvent(s_wakeEvent);
+		WaitForSingleObject(s_thread, INFINITE);
+		CloseHandle(s_thread);
+		s_thread = NULL;
+	}
+
+	for (size_t ii = 0; ii < s_roots.size(); ++ii)
+	{
+		WatchRoot* pRoot = s_roots[ii];
+
+		if (pRoot->bWatching)
+		{
+			DWORD bytes;
+
+			// the request has to be done before the buffer goes away
+			CancelIo(pRoot->hDir);
+			GetOverlappedResult(pRoot->hDir, &pRoot->overlapped, &bytes, TRUE);
+		}
+		CloseHandle(pRoot->hDir);
+		CloseHandle(pRoot->hEvent);
+		delete pRoot;
+	}
+	s_roots.clear();
+	s_dirs.clear();
+}
+
+/*************************************************************************
+                               dcSetRoots
+ *************************************************************************
+
+   SYNOPSIS
+		bool dcSetRoots (const vector<string>& roots, string* pError)
+
+   PURPOSE
+		cache everything under these folders, forgetting the old ones.
+		An empty list turns the cache off.  Main thread only.
+
+   RETURNS
+		false if any root could not be watched (pError says which).
+		The others are still cached.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool dcSetRoots (const vector<string>& roots, string* pError)
+{
+	bool bOk = true;
+
+	dcInit();
+	dcStopWatching();
+
+	for (size_t ii = 0; ii < roots.size(); ++ii)
+	{
+		if (roots[ii].empty())
+		{
+			continue;
+		}
+		if (s_roots.size() >= DC_MAX_ROOTS)
+		{
+			*pError += "too many roots, ignoring \"" + roots[ii] + "\"\n";
+			bOk = false;
+			break;
+		}
+
+		WatchRoot* pRoot = new WatchRoot;
+
+		pRoot->path      = dcTrimPath(roots[ii].c_str());
+		pRoot->key       = puNormalizePath(pRoot->path.c_str());
+		pRoot->hEvent    = CreateEvent(NULL, TRUE, FALSE, NULL);
+		pRoot->hDir      = CreateFile(pRoot->path.c_str(), FILE_LIST_DIRECTORY,
+									  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+									  OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		pRoot->bWatching = pRoot->hDir != INVALID_HANDLE_VALUE && dcWatch(pRoot);
+
+		if (!pRoot->bWatching)
+		{
+			char buf[64];
+			sprintf(buf, "\" (error %lu)\n", (unsigned long)GetLastError());
+			*pError += "could not watch \"" + pRoot->path + buf;
+			if (pRoot->hDir != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(pRoot->hDir);
+			}
+			CloseHandle(pRoot->hEvent);
+			delete pRoot;
+			bOk = false;
+			continue;
+		}
+		s_roots.push_back(pRoot);
+	}
+
+	s_stats.numRoots = (unsigned)s_roots.size();
+	if (!s_roots.empty())
+	{
+		s_bStop  = false;
+		s_thread = (HANDLE)_beginthreadex(NULL, 0, dcThreadMain, NULL, 0, NULL);
+		if (!s_thread)
+		{
+			*pError += "could not start the watcher thread\n";
+			dcStopWatching();
+			s_stats.numRoots = 0;
+			return false;
+		}
+	}
+	return bOk;
+}
+
+void dcGetRoots (vector<string>& roots)
+{
+	if (s_csState != 2)
+	{
+		return;
+	}
+	EnterCriticalSection(&s_cs);
+	for (size_t ii = 0; ii < s_roots.size(); ++ii)
+	{
+		if (s_roots[ii]->bWatching)
+		{
+			roots.push_back(s_roots[ii]->path);
+		}
+	}
+	LeaveCriticalSection(&s_cs);
+}
+
+/*************************************************************************
+                                dcListDir
+ *************************************************************************
+
+   SYNOPSIS
+		bool dcListDir (const char* path, vector<DirItem>& items, bool* pbExists,
+						string* pError)
+
+   PURPOSE
+		what's in a folder, sorted by name.  From memory if path is
+		under a root and nothing in it changed since last time.  Any
+		thread.  A folder that isn't there is empty with *pbExists
+		false.
+
+   RETURNS
+		false if the folder couldn't be read
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool dcListDir (const char* path, vector<DirItem>& items, bool* pbExists, string* pError)
+{
+	DirListing listing;
+
+	dcInit();
+	if (!dcGetListing(dcTrimPath(path), &listing, pError))
+	{
+		return false;
+	}
+	*pbExists = listing.bExists;
+	items.swap(listing.items);
+	return true;
+}
+
+/*************************************************************************
+                              dcGetPathInfo
+ *************************************************************************
+
+   SYNOPSIS
+		bool dcGetPathInfo (const char* path, PathInfo* pInfo)
+
+   PURPOSE
+		puGetPathInfo but answered from the listing of the folder path
+		is in when we have it.  Any thread.
+
+   RETURNS
+		true if the path exists
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool dcGetPathInfo (const char* path, PathInfo* pInfo)
+{
+	dcInit();
+
+	string	trimmed = dcTrimPath(path);
+	size_t	slash   = trimmed.find_last_of("/\\");
+
+	pInfo->bExists = false;
+	pInfo->bIsDir  = false;
+	pInfo->size    = 0;
+	pInfo->mtime   = 0;
+
+	// a drive or a bare name, nothing to look it up in
+	if (slash == string::npos || slash == trimmed.size() - 1)
+	{
+		return puGetPathInfo(trimmed.c_str(), pInfo);
+	}
+
+	string	dir  = trimmed.substr(0, slash);
+	string	name = trimmed.substr(slash + 1);
+	string	key  = puNormalizePath(dir.c_str());
+
+	EnterCriticalSection(&s_cs);
+	if (!dcFindRoot(key))
+	{
+		// not ours, don't read a whole folder to answer one question
+		++s_stats.uncached;
+		LeaveCriticalSection(&s_cs);
+		return puGetPathInfo(trimmed.c_str(), pInfo);
+	}
+
+	DirMap::const_iterator it = s_dirs.find(key);
+	if (it != s_dirs.end())
+	{
+		bool bFound = dcFindItem(it->second, name, pInfo);
+
+		++s_stats.hits;
+		LeaveCriticalSection(&s_cs);
+		return bFound;
+	}
+	LeaveCriticalSection(&s_cs);
+
+	DirListing	listing;
+	string		error;
+
+	if (!dcGetListing(dir, &listing, &error))
+	{
+		return puGetPathInfo(trimmed.c_str(), pInfo);
+	}
+	return dcFindItem(listing, name, pInfo);
+}
+
+void dcGetStats (DirCacheStats* pStats)
+{
+	dcInit();
+	EnterCriticalSection(&s_cs);
+	*pStats = s_stats;
+	pStats->numDirs = (unsigned)s_dirs.size();
+	LeaveCriticalSection(&s_cs);
+}
+
+/*************************************************************************
+                              dcInvalidate
+ *************************************************************************
+
+   SYNOPSIS
+		void dcInvalidate (const char* path)
+
+   PURPOSE
+		forget path, the folder it's in and everything under it.  For
+		things mayaSvn writes itself so the next look doesn't have to
+		wait for the watch thread to notice.  Any thread.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void dcInvalidate (const char* path)
+{
+	dcInit();
+
+	string key = puNormalizePath(dcTrimPath(path).c_str());
+
+	EnterCriticalSection(&s_cs);
+	dcForget(key);
+	LeaveCriticalSection(&s_cs);
+}
+
+void dcShutdown ()
+{
+	if (s_csState == 2)
+	{
+		dcStopWatching();
+		CloseHandle(s_wakeEvent);
+		DeleteCriticalSection(&s_cs);
+		s_csState = 0;
+	}
+}
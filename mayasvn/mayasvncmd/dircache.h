@@ -0,0 +1,59 @@
+/*=======================================================================*
+ |   file name : dircache.h
+ |-----------------------------------------------------------------------*
+ |   function  : directory listings of the project folders kept in
+ |               memory, thrown away when windows says they changed
+ *=======================================================================*/
+
+#ifndef DIRCACHE_H
+#define DIRCACHE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+#include "pathutil.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+#define DC_MAX_ROOTS	32	// WaitForMultipleObjects wants fewer than 64 handles
+
+/******************************* t y p e s *******************************/
+
+struct DirItem
+{
+	std::string			name;		// as it is on disk
+	bool				bIsDir;
+	unsigned __int64	size;
+	unsigned __int64	mtime;		// FILETIME as 100ns ticks
+};
+
+struct DirCacheStats
+{
+	unsigned	numRoots;		// being watched
+	unsigned	numDirs;		// listings in memory
+	unsigned	hits;
+	unsigned	misses;
+	unsigned	uncached;		// lookups outside the roots
+	unsigned	invalidations;
+	unsigned	overflows;		// too many changes at once, a whole root was dropped
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool dcSetRoots (const std::vector<std::string>& roots, std::string* pError);
+extern void dcGetRoots (std::vector<std::string>& roots);
+extern bool dcListDir (const char* path, std::vector<DirItem>& items, bool* pbExists, std::string* pError);
+extern bool dcGetPathInfo (const char* path, PathInfo* pInfo);
+extern void dcGetStats (DirCacheStats* pStats);
+extern void dcInvalidate (const char* path);
+extern void dcShutdown ();
+
+#endif /* DIRCACHE_H */
+
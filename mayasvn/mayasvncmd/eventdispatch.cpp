@@ -0,0 +1,553 @@
+/*=======================================================================*
+ |   file name : eventdispatch.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : the scripts on each event and running them in order
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "dbgprint.h"
+#include "eventdispatch.h"
+#include "trace.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// run order: priority then name
+struct lteventscript
+{
+	bool operator()(const EventScript& s1, const EventScript& s2) const
+	{
+		if (s1._priority != s2._priority)
+		{
+			return s1._priority < s2._priority;
+		}
+		return _stricmp(s1._name.c_str(), s2._name.c_str()) < 0;
+	}
+};
+
+// an edRunScripts in progress.  A script can add or remove scripts on
+// the event being run, see edListChanging
+struct ScriptRun
+{
+	EventScriptList*	pScripts;
+	EventScriptList*	pBefore;	// NULL until pScripts changes, then the list being walked
+	bool				bOwner;		// delete pBefore when done
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static vector<ScriptRun> s_runs;	// events run from inside other events nest
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// index of the script called name or -1
+int edFindScript (const EventScriptList& scripts, const char* name)
+{
+	for (size_t ii = 0; ii < scripts.size(); ++ii)
+	{
+		if (!_stricmp(scripts[ii]._name.c_str(), name))
+		{
+			return (int)ii;
+		}
+	}
+	return -1;
+}
+
+// pScripts is about to change.  Any run walking it keeps walking the
+// list as it was: swapping moves the elements without moving them so
+// references the run holds stay good, and pScripts gets a copy to
+// change.  A run gets the changes from the next event.
+static void edListChanging (EventScriptList* pScripts)
+{
+	EventScriptList* pBefore = NULL;
+
+	for (size_t ii = 0; ii < s_runs.size(); ++ii)
+	{
+		ScriptRun& run = s_runs[ii];
+
+		if (run.pScripts == pScripts && !run.pBefore)
+		{
+			if (!pBefore)
+			{
+				pBefore = new EventScriptList;
+				pBefore->swap(*pScripts);
+				*pScripts = *pBefore;
+
+				// the outermost run finishes last
+				run.bOwner = true;
+			}
+			run.pBefore = pBefore;
+		}
+	}
+}
+
+// same name replaces, like it always has
+void edAddScript (EventScriptList* pScripts, const EventScript& script)
+{
+	int index = edFindScript(*pScripts, script._name.c_str());
+
+	edListChanging(pScripts);
+	if (index >= 0)
+	{
+		pScripts->erase(pScripts->begin() + index);
+	}
+	pScripts->insert(std::upper_bound(pScripts->begin(), pScripts->end(), script, lteventscript()), script);
+}
+
+// false if there wasn't one called name
+bool edRemoveScript (EventScriptList* pScripts, const char* name)
+{
+	int index = edFindScript(*pScripts, name);
+	if (index < 0)
+	{
+		return false;
+	}
+	edListChanging(pScripts);
+	pScripts->erase(pScripts->begin() + index);
+	return true;
+}
+
+/*************************************************************************
+                              edRunScripts
+ *************************************************************************
+
+   SYNOPSIS
+		bool edRunScripts (const char* pEvent, bool bCheck, EventScriptList* pScripts, EventStats* pStats, const EventExecutor& exec)
+
+   PURPOSE
+		run the MEL scripts and C++ handlers for an event in priority
+		order.  For a check event the first one that says no stops it.
+		pStats is the whole event, each script keeps its own.
+
+		Scripts added or removed by a script that's running take
+		effect from the next event, this one runs the list it started
+		with.  Main thread only.
+
+   RETURNS
+		false if a check event should be cancelled
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool edRunScripts (const char* pEvent, bool bCheck, EventScriptList* pScripts, EventStats* pStats, const EventExecutor& exec)
+{
+	if (pScripts->empty())
+	{
+		return true;
+	}
+
+	bool				bDebug = dbgGetDebug() != 0;
+	bool				bStats = esGetEnabled();
+	__int64				eventStart = bStats ? esNow() : 0;
+	bool				bOk = true;
+	bool				bCtxReady = false;
+	MayaSvnEventContext	ctx;
+
+	ScriptRun			run;
+	size_t				runIndex = s_runs.size();
+
+	run.pScripts = pScripts;
+	run.pBefore  = NULL;
+	run.bOwner   = false;
+	s_runs.push_back(run);
+
+	if (bDebug)
+	{
+		dbgPrintf ("executing %sscripts for event \"%s\"\n", bCheck ? "check " : "", pEvent);
+	}
+	for (size_t ii = 0; bOk; ++ii)
+	{
+		// s_runs can grow while a script runs so no references into it
+		const EventScriptList* pWalk = s_runs[runIndex].pBefore ? s_runs[runIndex].pBefore : pScripts;
+		if (ii >= pWalk->size())
+		{
+			break;
+		}
+
+		const EventScript& script = (*pWalk)[ii];
+		__int64 start = bStats ? esNow() : 0;
+		TraceSpan span(script._pHandler ? "handler" : "script", script._name.c_str());
+
+		span.setArg("event", pEvent);
+
+		if (bDebug)
+		{
+			dbgPrintf ("executing script \"%s\" for event \"%s\"\n", script._name.c_str(), pEvent);
+			dbgPrintf ("%s\n", script._pHandler ? "<native>" : script._melScript.c_str());
+		}
+		if (exec.bDryRun)
+		{
+			// everything but the script itself
+		}
+		else if (script._pHandler)
+		{
+			if (!bCtxReady)
+			{
+				ctx.version   = MAYASVN_HANDLER_VERSION;
+				ctx.pEvent    = pEvent;
+				ctx.pFilename = "";
+				ctx.ppNodes   = NULL;
+				ctx.numNodes  = 0;
+				ctx.bCheck    = bCheck;
+				ctx.bCancel   = false;
+				exec.fillContext(&ctx, exec.pContext);
+				bCtxReady = true;
+			}
+			script._pHandler(&ctx, script._pUserData);
+			bOk = !(bCheck && ctx.bCancel);
+		}
+		else
+		{
+			bool bResult = exec.runMel(script, bCheck, exec.pContext);
+
+			bOk = !bCheck || bResult;
+		}
+
+		if (bStats)
+		{
+			// if the list changed find where this script went, if it's still there
+			int index = s_runs[runIndex].pBefore ? edFindScript(*pScripts, script._name.c_str()) : (int)ii;
+
+			if (index >= 0)
+			{
+				esAdd(&(*pScripts)[index]._stats, esElapsedMs(start), !bOk);
+			}
+		}
+	}
+	if (s_runs[runIndex].bOwner)
+	{
+		delete s_runs[runIndex].pBefore;
+	}
+	s_runs.pop_back();
+
+	if (bStats)
+	{
+		esAdd(pStats, esElapsedMs(eventStart), !bOk);
+	}
+	if (bDebug)
+	{
+		fflush(stdout);
+	}
+	return bOk;
+}
+
+/*************************************************************************
+                              edWriteRecord
+ *************************************************************************
+
+   SYNOPSIS
+		void edWriteRecord (FILE* fp, double ms, const char* pEvent, const char* pFilename, const char* const* ppNodes, unsigned numNodes)
+
+   PURPOSE
+		one line per event: ms since recording started, event,
+		filename, then the nodes separated by |.  Fields are separated
+		by tabs.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void edWriteRecord (FILE* fp, double ms, const char* pEvent, const char* pFilename, const char* const* ppNodes, unsigned numNodes)
+{
+	fprintf(fp, "%.3f\t%s\t%s\t", ms, pEvent, pFilename);
+	for (unsigned ii = 0; ii < numNodes; ++ii)
+	{
+		fprintf(fp, "%s%s", ii ? "|" : "", ppNodes[ii]);
+	}
+	fputc('\n', fp);
+}
+
+/*************************************************************************
+                              edReadRecord
+ *************************************************************************
+
+   SYNOPSIS
+		bool edReadRecord (FILE* fp, EventRecord* pRecord)
+
+   PURPOSE
+		read the next event written by edWriteRecord, skipping blank
+		lines and # comments.  Lines can be any length.
+
+   RETURNS
+		false at the end of the file
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool edReadRecord (FILE* fp, EventRecord* pRecord)
+{
+	string	line;
+	char	buf[4096];
+
+	while (fgets(buf, sizeof(buf), fp))
+	{
+		line += buf;
+		if (line.empty() || line[line.size() - 1] != '\n')
+		{
+			if (!feof(fp))
+			{
+				continue;	// longer than buf
+			}
+		}
+		else
+		{
+			line.erase(line.size() - 1);
+		}
+		if (line.empty() || line[0] == '#')
+		{
+			line.erase();
+			continue;
+		}
+
+		// time, event, filename, nodes
+		string	fields[4];
+		size_t	pos = 0;
+
+		for (int ii = 0; ii < 4; ++ii)
+		{
+			size_t tab = ii < 3 ? line.find('\t', pos) : string::npos;
+
+			fields[ii] = line.substr(pos, tab == string::npos ? string::npos : tab - pos);
+			if (tab == string::npos)
+			{
+				break;
+			}
+			pos = tab + 1;
+		}
+
+		pRecord->ms       = atof(fields[0].c_str());
+		pRecord->event    = fields[1];
+		pRecord->filename = fields[2];
+		pRecord->nodes.clear();
+		for (size_t begin = 0; begin < fields[3].size(); )
+		{
+			size_t bar = fields[3].find('|', begin);
+
+			if (bar == string::npos)
+			{
+				bar = fields[3].size();
+			}
+			pRecord->nodes.push_back(fields[3].substr(begin, bar - begin));
+			begin = bar + 1;
+		}
+		return true;
+	}
+	return false;
+}
+
+static bool regWriteString(FILE* fp, const string& str)
+{
+	unsigned len = (unsigned)str.size();
+
+	return fwrite(&len, sizeof(len), 1, fp) == 1 &&
+		   (!len || fwrite(str.c_str(), len, 1, fp) == 1);
+}
+
+static bool regReadString(FILE* fp, string& str)
+{
+	unsigned len;
+
+	if (fread(&len, sizeof(len), 1, fp) != 1 || len > REG_MAX_STRING)
+	{
+		return false;
+	}
+	str.resize(len);
+	return !len || fread(&str[0], len, 1, fp) == 1;
+}
+
+// add re, or replace the one for the same event
+static void regSetEvent(vector<RegEvent>* pEvents, const RegEvent& re)
+{
+	for (size_t ii = 0; ii < pEvents->size(); ++ii)
+	{
+		if (!_stricmp((*pEvents)[ii].event.c_str(), re.event.c_str()))
+		{
+			(*pEvents)[ii] = re;
+			return;
+		}
+	}
+	pEvents->push_back(re);
+}
+
+/*************************************************************************
+                             edWriteRegistry
+ *************************************************************************
+
+   SYNOPSIS
+		bool edWriteRegistry (const char* filename, const vector<RegEvent>& events, const vector<RegScript>& scripts)
+
+   PURPOSE
+		header:  magic, version, number of events, number of scripts
+		event:   event (a length + chars), debounceMs
+		script:  event, name, mel (each a length + chars),
+		         priority, flags
+
+		Writes to a temp file and renames it like the hash index.
+
+   RETURNS
+		false if the file could not be written
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool edWriteRegistry (const char* filename, const vector<RegEvent>& events, const vector<RegScript>& scripts)
+{
+	string	tempFile = string(filename) + ".tmp";
+	FILE*	fp = fopen(tempFile.c_str(), "wb");
+	bool	bOk;
+
+	if (!fp)
+	{
+		return false;
+	}
+
+	unsigned header[4];
+
+	header[0] = REG_MAGIC;
+	header[1] = REG_VERSION;
+	header[2] = (unsigned)events.size();
+	header[3] = (unsigned)scripts.size();
+
+	bOk = fwrite(header, sizeof(header), 1, fp) == 1;
+	for (size_t ii = 0; bOk && ii < events.size(); ++ii)
+	{
+		bOk = regWriteString(fp, events[ii].event) &&
+			  fwrite(&events[ii].debounceMs, sizeof(events[ii].debounceMs), 1, fp) == 1;
+	}
+	for (size_t ii = 0; bOk && ii < scripts.size(); ++ii)
+	{
+		const RegScript& rs = scripts[ii];
+
+		bOk = regWriteString(fp, rs.event) &&
+			  regWriteString(fp, rs.name) &&
+			  regWriteString(fp, rs.mel) &&
+			  fwrite(rs.values, sizeof(rs.values), 1, fp) == 1;
+	}
+	bOk = (fclose(fp) == 0) && bOk;
+
+	if (bOk)
+	{
+		bOk = MoveFileEx(tempFile.c_str(), filename, MOVEFILE_REPLACE_EXISTING) != 0;
+	}
+	if (!bOk)
+	{
+		DeleteFile(tempFile.c_str());
+	}
+	return bOk;
+}
+
+/*************************************************************************
+                             edReadRegistry
+ *************************************************************************
+
+   SYNOPSIS
+		bool edReadRegistry (const char* filename, vector<RegEvent>* pEvents, vector<RegScript>* pScripts)
+
+   PURPOSE
+		read a file written by edWriteRegistry.  pEvents and pScripts
+		are only changed if the whole file is good.
+
+		Version 1 files had debounceMs in every script.  The last
+		script on an event decides it, which is what loading them
+		always did.
+
+   RETURNS
+		false if it couldn't be opened, isn't a registry or is corrupt
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool edReadRegistry (const char* filename, vector<RegEvent>* pEvents, vector<RegScript>* pScripts)
+{
+	FILE* fp = fopen(filename, "rb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	vector<RegEvent>	events;
+	vector<RegScript>	scripts;
+	unsigned			header[4];
+	bool				bOk = fread(header, sizeof(unsigned), 3, fp) == 3 &&
+							  header[0] == REG_MAGIC &&
+							  (header[1] == 1 || header[1] == REG_VERSION);
+
+	if (bOk && header[1] == REG_VERSION)
+	{
+		// version 1 went straight to the scripts
+		bOk = fread(&header[3], sizeof(unsigned), 1, fp) == 1;
+		for (unsigned ii = 0; bOk && ii < header[2]; ++ii)
+		{
+			RegEvent re;
+
+			bOk = regReadString(fp, re.event) &&
+				  fread(&re.debounceMs, sizeof(re.debounceMs), 1, fp) == 1;
+			if (bOk)
+			{
+				events.push_back(re);
+			}
+		}
+	}
+	else
+	{
+		header[3] = header[2];
+	}
+
+	for (unsigned ii = 0; bOk && ii < header[3]; ++ii)
+	{
+		RegScript	rs;
+		int			values[3];
+
+		bOk = regReadString(fp, rs.event) &&
+			  regReadString(fp, rs.name) &&
+			  regReadString(fp, rs.mel);
+		if (bOk && header[1] == 1)
+		{
+			// priority, debounceMs, flags
+			bOk = fread(values, sizeof(values), 1, fp) == 1;
+			if (bOk)
+			{
+				RegEvent re;
+
+				re.event      = rs.event;
+				re.debounceMs = values[1];
+				regSetEvent(&events, re);
+
+				rs.values[0] = values[0];
+				rs.values[1] = values[2];
+			}
+		}
+		else if (bOk)
+		{
+			bOk = fread(rs.values, sizeof(rs.values), 1, fp) == 1;
+		}
+		if (bOk)
+		{
+			scripts.push_back(rs);
+		}
+	}
+	fclose(fp);
+
+	if (bOk)
+	{
+		pEvents->swap(events);
+		pScripts->swap(scripts);
+	}
+	return bOk;
+}
+
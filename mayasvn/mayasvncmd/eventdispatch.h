@@ -0,0 +1,146 @@
+/*=======================================================================*
+ |   file name : eventdispatch.h
+ |-----------------------------------------------------------------------*
+ |   function  : the scripts on each event and running them in order
+ *=======================================================================*/
+
+/*
+   Nothing in here knows about Maya.  Whoever calls edRunScripts says how
+   to run a MEL script through an EventExecutor, mayaSvn hands them to
+   MGlobal and eventreplay just counts them.  The -recordEvents and
+   -saveRegistry files are read and written here too so both can use
+   them.
+*/
+
+#ifndef EVENTDISPATCH_H
+#define EVENTDISPATCH_H
+/**************************** i n c l u d e s ****************************/
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "eventstats.h"
+#include "mayaSvnHandler.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+#define REG_MAGIC		0x4752534D	// 'MSRG'
+#define REG_VERSION		2	// 1 kept debounceMs in every script
+#define REG_MAX_STRING	(1024 * 1024)	// anything longer is corrupt
+
+#define REG_DISPLAY_ENABLED	0x01
+#define REG_UNDO_ENABLED	0x02
+
+#define REC_HEADER		"# mayaSvn events 1"
+
+/******************************* t y p e s *******************************/
+
+// one MEL script or C++ handler on an event
+struct EventScript
+{
+	std::string		_name;
+	std::string		_melScript;
+	int				_priority;		// lower runs first
+	bool			_bDisplayEnabled;
+	bool			_bUndoEnabled;
+	MayaSvnHandler	_pHandler;		// not NULL = C++ handler instead of _melScript
+	void*			_pUserData;
+	EventStats		_stats;
+
+	EventScript(const std::string& name, const std::string& melScript, int priority, bool bDisplayEnabled, bool bUndoEnabled)
+	: _name(name)
+	, _melScript(melScript)
+	, _priority(priority)
+	, _bDisplayEnabled(bDisplayEnabled)
+	, _bUndoEnabled(bUndoEnabled)
+	, _pHandler(NULL)
+	, _pUserData(NULL)
+	{
+		esReset(&_stats);
+	}
+
+	EventScript(const std::string& name, MayaSvnHandler pHandler, void* pUserData, int priority)
+	: _name(name)
+	, _priority(priority)
+	, _bDisplayEnabled(false)
+	, _bUndoEnabled(false)
+	, _pHandler(pHandler)
+	, _pUserData(pUserData)
+	{
+		esReset(&_stats);
+	}
+
+	EventScript()
+	: _pHandler(NULL)
+	, _pUserData(NULL)
+	{
+		esReset(&_stats);
+	}
+};
+
+// kept sorted by priority then name so running them just walks it
+typedef std::vector<EventScript> EventScriptList;
+
+// how edRunScripts gets things done
+struct EventExecutor
+{
+	// run one MEL script.  For a check event return what the script
+	// returned, false cancels.
+	bool	(*runMel)(const EventScript& script, bool bCheck, void* pContext);
+
+	// fill in pFilename, ppNodes and numNodes for the C++ handlers.
+	// Only called if one runs, at most once per event.
+	void	(*fillContext)(MayaSvnEventContext* pCtx, void* pContext);
+
+	void*	pContext;
+	bool	bDryRun;	// everything but the scripts themselves
+};
+
+// one line of a -recordEvents file
+struct EventRecord
+{
+	double						ms;		// since recording started
+	std::string					event;
+	std::string					filename;
+	std::vector<std::string>	nodes;
+};
+
+// an event's own settings in a -saveRegistry file
+struct RegEvent
+{
+	std::string	event;
+	int			debounceMs;
+};
+
+// one script in a -saveRegistry file
+struct RegScript
+{
+	std::string	event;
+	std::string	name;
+	std::string	mel;
+	int			values[2];	// priority, flags
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern int edFindScript (const EventScriptList& scripts, const char* name);
+extern void edAddScript (EventScriptList* pScripts, const EventScript& script);
+extern bool edRemoveScript (EventScriptList* pScripts, const char* name);
+extern bool edRunScripts (const char* pEvent, bool bCheck, EventScriptList* pScripts, EventStats* pStats, const EventExecutor& exec);
+
+extern void edWriteRecord (FILE* fp, double ms, const char* pEvent, const char* pFilename, const char* const* ppNodes, unsigned numNodes);
+extern bool edReadRecord (FILE* fp, EventRecord* pRecord);
+
+extern bool edWriteRegistry (const char* filename, const std::vector<RegEvent>& events, const std::vector<RegScript>& scripts);
+extern bool edReadRegistry (const char* filename, std::vector<RegEvent>* pEvents, std::vector<RegScript>* pScripts);
+
+#endif /* EVENTDISPATCH_H */
+
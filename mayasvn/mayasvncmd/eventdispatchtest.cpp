@@ -0,0 +1,262 @@
+/*=======================================================================*
+ |   file name : eventdispatchtest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the scripts on each event
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "coretest.h"
+#include "eventdispatch.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// what the pretend MEL did
+struct RunLog
+{
+	EventScriptList*	pScripts;
+	string				ran;		// names, space separated
+	bool				bNest;		// "a" runs the event again
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// mayaSvn keeps an event's Maya callback only while its list isn't
+// empty so -delEvent of the last script has to leave it empty
+static void testAddRemove ()
+{
+	EventScriptList scripts;
+
+	edAddScript(&scripts, EventScript("b", "print b", 0, false, false));
+	edAddScript(&scripts, EventScript("a", "print a", 0, false, false));
+	edAddScript(&scripts, EventScript("first", "print first", -1, false, false));
+	CHECK(scripts.size() == 3);
+	CHECK(scripts[0]._name == "first" && scripts[1]._name == "a" && scripts[2]._name == "b");
+
+	// same name replaces
+	edAddScript(&scripts, EventScript("A", "print A", 1, false, false));
+	CHECK(scripts.size() == 3);
+	CHECK(scripts[2]._name == "A" && scripts[2]._melScript == "print A");
+
+	CHECK(!edRemoveScript(&scripts, "nope"));
+	CHECK(scripts.size() == 3);
+
+	CHECK(edRemoveScript(&scripts, "B"));
+	CHECK(edFindScript(scripts, "b") < 0);
+	CHECK(edRemoveScript(&scripts, "first"));
+	CHECK(!scripts.empty());
+	CHECK(edRemoveScript(&scripts, "a"));
+	CHECK(scripts.empty());
+	CHECK(!edRemoveScript(&scripts, "a"));
+}
+
+// EventExecutor::runMel.  Some of the scripts change the list while
+// it's being run, like a MEL script calling mayaSvn -addEvent would
+static bool logRunMel (const EventScript& script, bool bCheck, void* pContext)
+{
+	RunLog* pLog = (RunLog*)pContext;
+
+	pLog->ran += script._name + " ";
+	if (script._name == "a")
+	{
+		edRemoveScript(pLog->pScripts, "b");
+		edAddScript(pLog->pScripts, EventScript("z", "print z", 3, false, false));
+		if (pLog->bNest)
+		{
+			EventExecutor	exec;
+			EventStats		stats;
+
+			pLog->bNest   = false;
+			exec.runMel   = logRunMel;
+			exec.pContext = pLog;
+			exec.bDryRun  = false;
+			esReset(&stats);
+			pLog->ran += "( ";
+			edRunScripts("test", false, pLog->pScripts, &stats, exec);
+			pLog->ran += ") ";
+		}
+	}
+	else if (script._name == "c")
+	{
+		edRemoveScript(pLog->pScripts, "c");
+	}
+	return true;
+}
+
+static void testChangeWhileRunning ()
+{
+	EventScriptList	scripts;
+	EventExecutor	exec;
+	EventStats		stats;
+	RunLog			log;
+	bool			bWasEnabled = esGetEnabled();
+
+	esSetEnabled(true);
+	esReset(&stats);
+	exec.runMel   = logRunMel;
+	exec.pContext = &log;
+	exec.bDryRun  = false;
+	log.pScripts  = &scripts;
+	log.bNest     = false;
+
+	edAddScript(&scripts, EventScript("a", "print a", 0, false, false));
+	edAddScript(&scripts, EventScript("b", "print b", 1, false, false));
+	edAddScript(&scripts, EventScript("c", "print c", 2, false, false));
+
+	// this event runs the list it started with, changes are for the next
+	CHECK(edRunScripts("test", false, &scripts, &stats, exec));
+	CHECK(log.ran == "a b c ");
+	CHECK(scripts.size() == 2 && scripts[0]._name == "a" && scripts[1]._name == "z");
+
+	// each script's time went to that script
+	CHECK(scripts[0]._stats.calls == 1);
+	CHECK(scripts[1]._stats.calls == 0);
+	CHECK(stats.calls == 1);
+
+	log.ran.erase();
+	CHECK(edRunScripts("test", false, &scripts, &stats, exec));
+	CHECK(log.ran == "a z ");
+	CHECK(scripts[0]._stats.calls == 2 && scripts[1]._stats.calls == 1);
+
+	// an event run from inside itself sees the list as it is then and
+	// the outer one still finishes the list it started with
+	edAddScript(&scripts, EventScript("b", "print b", 1, false, false));
+	log.ran.erase();
+	log.bNest = true;
+	CHECK(edRunScripts("test", false, &scripts, &stats, exec));
+	CHECK(log.ran == "a ( a z ) b z ");
+	CHECK(scripts.size() == 2 && scripts[0]._stats.calls == 4);
+
+	esSetEnabled(bWasEnabled);
+}
+
+static RegScript makeRegScript (const char* event, const char* name, int priority, int flags)
+{
+	RegScript rs;
+
+	rs.event     = event;
+	rs.name      = name;
+	rs.mel       = string("print ") + name;
+	rs.values[0] = priority;
+	rs.values[1] = flags;
+	return rs;
+}
+
+static void writeV1String (FILE* fp, const char* str)
+{
+	unsigned len = (unsigned)strlen(str);
+
+	fwrite(&len, sizeof(len), 1, fp);
+	fwrite(str, len, 1, fp);
+}
+
+// what -saveRegistry wrote before each event's settings had their own
+// place: debounceMs in every script
+static bool writeV1Registry (const string& filename)
+{
+	FILE* fp = fopen(filename.c_str(), "wb");
+	if (!fp)
+	{
+		return false;
+	}
+
+	unsigned	header[3] = { REG_MAGIC, 1, 2, };
+	int			values1[3] = { 5, 100, REG_UNDO_ENABLED, };
+	int			values2[3] = { 6, 250, 0, };
+
+	fwrite(header, sizeof(header), 1, fp);
+	writeV1String(fp, "idle");
+	writeV1String(fp, "one");
+	writeV1String(fp, "print one");
+	fwrite(values1, sizeof(values1), 1, fp);
+	writeV1String(fp, "idle");
+	writeV1String(fp, "two");
+	writeV1String(fp, "print two");
+	fwrite(values2, sizeof(values2), 1, fp);
+	return fclose(fp) == 0;
+}
+
+static void testRegistry ()
+{
+	string dir;
+
+	if (!CHECK(ctMakeTempDir("eventdispatch", &dir)))
+	{
+		return;
+	}
+
+	string				filename = dir + "\\registry.dat";
+	vector<RegEvent>	events(2);
+	vector<RegScript>	scripts;
+	vector<RegEvent>	eventsIn;
+	vector<RegScript>	scriptsIn;
+
+	// each event's debounce once, however many scripts it has
+	events[0].event      = "idle";
+	events[0].debounceMs = 250;
+	events[1].event      = "AfterOpen";
+	events[1].debounceMs = 0;
+	scripts.push_back(makeRegScript("idle", "one", 5, REG_UNDO_ENABLED));
+	scripts.push_back(makeRegScript("idle", "two", 6, 0));
+	scripts.push_back(makeRegScript("AfterOpen", "three", 0, REG_DISPLAY_ENABLED));
+
+	CHECK(edWriteRegistry(filename.c_str(), events, scripts));
+	CHECK(edReadRegistry(filename.c_str(), &eventsIn, &scriptsIn));
+	CHECK(eventsIn.size() == 2);
+	CHECK(eventsIn[0].event == "idle" && eventsIn[0].debounceMs == 250);
+	CHECK(eventsIn[1].event == "AfterOpen" && eventsIn[1].debounceMs == 0);
+	CHECK(scriptsIn.size() == 3);
+	CHECK(scriptsIn[0].name == "one" && scriptsIn[0].mel == "print one");
+	CHECK(scriptsIn[0].values[0] == 5 && scriptsIn[0].values[1] == REG_UNDO_ENABLED);
+	CHECK(scriptsIn[2].event == "AfterOpen" && scriptsIn[2].values[1] == REG_DISPLAY_ENABLED);
+
+	// an old file still loads, its last script decides the debounce
+	CHECK(writeV1Registry(filename));
+	CHECK(edReadRegistry(filename.c_str(), &eventsIn, &scriptsIn));
+	CHECK(eventsIn.size() == 1 && eventsIn[0].event == "idle" && eventsIn[0].debounceMs == 250);
+	CHECK(scriptsIn.size() == 2);
+	CHECK(scriptsIn[0].values[0] == 5 && scriptsIn[0].values[1] == REG_UNDO_ENABLED);
+	CHECK(scriptsIn[1].values[0] == 6 && scriptsIn[1].values[1] == 0);
+
+	// a file cut short changes nothing
+	FILE* fp = fopen(filename.c_str(), "r+b");
+	if (CHECK(fp != NULL))
+	{
+		unsigned header[3] = { REG_MAGIC, 1, 3, };
+
+		fwrite(header, sizeof(header), 1, fp);
+		fclose(fp);
+	}
+	CHECK(!edReadRegistry(filename.c_str(), &eventsIn, &scriptsIn));
+	CHECK(eventsIn.size() == 1 && scriptsIn.size() == 2);
+
+	ctRemoveDir(dir);
+}
+
+void testEventDispatch ()
+{
+	testAddRemove();
+	testChangeWhileRunning();
+	testRegistry();
+}
@@ -0,0 +1,322 @@
+/*=======================================================================*
+ |   file name : eventreplay.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : replay a -recordEvents file without Maya
+ *=======================================================================*/
+
+/*
+   eventreplay [-v] [-dry] [-cancel script]... [-trace file] registry events
+
+   Loads the scripts from a -saveRegistry file, then sends every event in
+   a -recordEvents file through the same edRunScripts mayaSvn uses.  No
+   MEL is run.  Scripts are counted, and with -v each one is printed as
+   it would run, so the order can be checked or diffed.  A script named
+   with -cancel says no when it's on a check event.
+
+   Maya only tells us which events are check events through
+   MSceneMessage so here it's any event whose name ends in "Check",
+   which is true of every one mayaSvn has.
+
+   dbgprint.cpp needs Maya so the few dbgprint functions eventdispatch
+   uses are here, printing to stdout.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dbgprint.h"
+#include "eventdispatch.h"
+#include "eventstats.h"
+#include "trace.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct ReplayEvent
+{
+	string			label;		// as the registry spelled it
+	bool			bCheck;
+	EventScriptList	scripts;
+	EventStats		stats;
+};
+
+typedef map<string, ReplayEvent> ReplayEventMap;	// by lower case label
+
+struct ReplayContext
+{
+	bool				bVerbose;
+	vector<string>		cancels;	// -cancel
+	const ReplayEvent*	pEvent;		// being dispatched
+	const EventRecord*	pRecord;
+	vector<const char*>	nodes;
+	unsigned			numRun;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static int s_debug;
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+int dbgSetDebug (int on)
+{
+	int old = s_debug;
+
+	s_debug = on;
+	return old;
+}
+
+int dbgGetDebug ()
+{
+	return s_debug;
+}
+
+int dbgPrintf (const char *fmt, ...)
+{
+	int		len = 0;
+	va_list	ap;
+
+	if (s_debug)
+	{
+		va_start (ap, fmt);
+		len = vprintf (fmt, ap);
+		va_end (ap);
+	}
+	return len;
+}
+
+static string lowerCase (const string& str)
+{
+	string lower = str;
+
+	for (size_t ii = 0; ii < lower.size(); ++ii)
+	{
+		lower[ii] = (char)tolower((unsigned char)lower[ii]);
+	}
+	return lower;
+}
+
+// EventExecutor::runMel
+static bool replayRunMel (const EventScript& script, bool bCheck, void* pContext)
+{
+	ReplayContext* pCtx = (ReplayContext*)pContext;
+
+	++pCtx->numRun;
+	if (pCtx->bVerbose)
+	{
+		printf ("%s\t%s\t%s\n", pCtx->pEvent->label.c_str(), script._name.c_str(), script._melScript.c_str());
+	}
+	for (size_t ii = 0; bCheck && ii < pCtx->cancels.size(); ++ii)
+	{
+		if (!_stricmp(pCtx->cancels[ii].c_str(), script._name.c_str()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// EventExecutor::fillContext, the registry never has C++ handlers but
+// someone could add one here
+static void replayFillContext (MayaSvnEventContext* pEventCtx, void* pContext)
+{
+	ReplayContext* pCtx = (ReplayContext*)pContext;
+
+	pCtx->nodes.clear();
+	for (size_t ii = 0; ii < pCtx->pRecord->nodes.size(); ++ii)
+	{
+		pCtx->nodes.push_back(pCtx->pRecord->nodes[ii].c_str());
+	}
+	pEventCtx->pFilename = pCtx->pRecord->filename.c_str();
+	pEventCtx->ppNodes   = pCtx->nodes.empty() ? NULL : &pCtx->nodes[0];
+	pEventCtx->numNodes  = (unsigned)pCtx->nodes.size();
+}
+
+static bool loadScripts (const char* filename, ReplayEventMap* pEvents)
+{
+	vector<RegEvent>	events;
+	vector<RegScript>	scripts;
+
+	// replay doesn't debounce so the events' own settings don't matter
+	if (!edReadRegistry(filename, &events, &scripts))
+	{
+		fprintf (stderr, "could not read \"%s\", or it's not a mayaSvn registry\n", filename);
+		return false;
+	}
+
+	for (size_t ii = 0; ii < scripts.size(); ++ii)
+	{
+		const RegScript&	rs    = scripts[ii];
+		string				key   = lowerCase(rs.event);
+		ReplayEvent&		event = (*pEvents)[key];
+
+		if (event.label.empty())
+		{
+			event.label  = rs.event;
+			event.bCheck = key.size() > 5 && key.compare(key.size() - 5, 5, "check") == 0;
+			esReset(&event.stats);
+		}
+		edAddScript(&event.scripts, EventScript(rs.name, rs.mel, rs.values[0],
+												(rs.values[1] & REG_DISPLAY_ENABLED) != 0,
+												(rs.values[1] & REG_UNDO_ENABLED) != 0));
+	}
+	return true;
+}
+
+static int usage ()
+{
+	fprintf (stderr, "usage: eventreplay [-v] [-dry] [-cancel script]... [-trace file] registry events\n");
+	return 2;
+}
+
+int main (int argc, char** argv)
+{
+	ReplayContext	ctx;
+	EventExecutor	exec;
+	const char*		pTraceFile = NULL;
+	int				argi = 1;
+
+	ctx.bVerbose = false;
+	ctx.pEvent   = NULL;
+	ctx.pRecord  = NULL;
+	ctx.numRun   = 0;
+
+	exec.runMel      = replayRunMel;
+	exec.fillContext = replayFillContext;
+	exec.pContext    = &ctx;
+	exec.bDryRun     = false;
+
+	for (; argi < argc && argv[argi][0] == '-'; ++argi)
+	{
+		if (!strcmp(argv[argi], "-v"))
+		{
+			ctx.bVerbose = true;
+		}
+		else if (!strcmp(argv[argi], "-dry"))
+		{
+			exec.bDryRun = true;
+		}
+		else if (!strcmp(argv[argi], "-cancel") && argi + 1 < argc)
+		{
+			ctx.cancels.push_back(argv[++argi]);
+		}
+		else if (!strcmp(argv[argi], "-trace") && argi + 1 < argc)
+		{
+			pTraceFile = argv[++argi];
+		}
+		else
+		{
+			return usage();
+		}
+	}
+	if (argc - argi != 2)
+	{
+		return usage();
+	}
+
+	ReplayEventMap events;
+
+	if (!loadScripts(argv[argi], &events))
+	{
+		return 1;
+	}
+
+	FILE* fp = fopen(argv[argi + 1], "r");
+	if (!fp)
+	{
+		fprintf (stderr, "could not open \"%s\"\n", argv[argi + 1]);
+		return 1;
+	}
+
+	string error;
+
+	if (pTraceFile && !trStart(pTraceFile, &error))
+	{
+		fprintf (stderr, "%s\n", error.c_str());
+		pTraceFile = NULL;
+	}
+	esSetEnabled(true);
+
+	EventRecord	record;
+	unsigned	numEvents = 0;
+	unsigned	numNoScripts = 0;
+	unsigned	cancelled = 0;
+	__int64		start = esNow();
+
+	while (edReadRecord(fp, &record))
+	{
+		ReplayEventMap::iterator it = events.find(lowerCase(record.event));
+
+		++numEvents;
+		if (it == events.end())
+		{
+			// an event nothing was attached to is fine, mayaSvn
+			// only records those while -recordEvents is on
+			++numNoScripts;
+			continue;
+		}
+
+		ReplayEvent& event = it->second;
+
+		ctx.pEvent  = &event;
+		ctx.pRecord = &record;
+		if (!edRunScripts(event.label.c_str(), event.bCheck, &event.scripts, &event.stats, exec))
+		{
+			++cancelled;
+		}
+	}
+	fclose(fp);
+
+	double totalMs = esElapsedMs(start);
+
+	if (pTraceFile)
+	{
+		int numTraced;
+
+		if (!trStop(&numTraced, &error))
+		{
+			fprintf (stderr, "%s\n", error.c_str());
+		}
+	}
+
+	printf ("events=%u\n", numEvents);
+	printf ("noScripts=%u\n", numNoScripts);
+	printf ("cancelled=%u\n", cancelled);
+	printf ("scriptsRun=%u\n", ctx.numRun);
+	printf ("totalMs=%.3f\n", totalMs);
+	for (ReplayEventMap::const_iterator it = events.begin(); it != events.end(); ++it)
+	{
+		const EventStats& stats = it->second.stats;
+
+		if (stats.calls)
+		{
+			printf ("event=%s calls=%u failures=%u meanMs=%.3f p99Ms=%.3f\n",
+					it->second.label.c_str(), stats.calls, stats.failures,
+					stats.totalMs / (double)stats.calls, esPercentile(&stats, 99.0));
+		}
+	}
+	return 0;
+}
+
@@ -0,0 +1,150 @@
+/*=======================================================================*
+ |   file name : eventstats.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : timing for event scripts
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "eventstats.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static bool		s_bEnabled = true;
+static double	s_msPerTick;	// 0 = not looked up yet
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+void esSetEnabled (bool bEnabled)
+{
+	s_bEnabled = bEnabled;
+}
+
+bool esGetEnabled ()
+{
+	return s_bEnabled;
+}
+
+/*************************************************************************
+                                 esNow
+ *************************************************************************
+
+   SYNOPSIS
+		__int64 esNow ()
+
+   PURPOSE
+		read the performance counter.  It never goes backward so it's
+		safe to subtract, unlike the time of day.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+__int64 esNow ()
+{
+	LARGE_INTEGER now;
+
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+}
+
+double esElapsedMs (__int64 start)
+{
+	if (!s_msPerTick)
+	{
+		LARGE_INTEGER freq;
+
+		QueryPerformanceFrequency(&freq);
+		s_msPerTick = 1000.0 / (double)freq.QuadPart;
+	}
+	return (double)(esNow() - start) * s_msPerTick;
+}
+
+void esReset (EventStats* pStats)
+{
+	memset(pStats, 0, sizeof(*pStats));
+}
+
+void esAdd (EventStats* pStats, double ms, bool bFailed)
+{
+	if (!pStats->calls || ms < pStats->minMs)
+	{
+		pStats->minMs = ms;
+	}
+	if (ms > pStats->maxMs)
+	{
+		pStats->maxMs = ms;
+	}
+	++pStats->calls;
+	pStats->totalMs += ms;
+	if (bFailed)
+	{
+		++pStats->failures;
+	}
+
+	// keep the most recent ES_NUM_SAMPLES for the percentile
+	pStats->samples[pStats->nextSample] = (float)ms;
+	pStats->nextSample = (pStats->nextSample + 1) % ES_NUM_SAMPLES;
+	if (pStats->numSamples < ES_NUM_SAMPLES)
+	{
+		++pStats->numSamples;
+	}
+}
+
+/*************************************************************************
+                              esPercentile
+ *************************************************************************
+
+   SYNOPSIS
+		double esPercentile (const EventStats* pStats, double percent)
+
+   PURPOSE
+		nearest rank percentile (0 to 100) of the last ES_NUM_SAMPLES
+		times.  Only called when someone asks for the stats so sorting
+		a copy is fine.
+
+   RETURNS
+		milliseconds, 0 if there are no samples
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+double esPercentile (const EventStats* pStats, double percent)
+{
+	if (!pStats->numSamples)
+	{
+		return 0.0;
+	}
+
+	float sorted[ES_NUM_SAMPLES];
+	unsigned count = pStats->numSamples;
+
+	memcpy(sorted, pStats->samples, count * sizeof(sorted[0]));
+	std::sort(sorted, sorted + count);
+
+	unsigned rank = (unsigned)(percent / 100.0 * count + 0.999999);
+	if (rank < 1)
+	{
+		rank = 1;
+	}
+	if (rank > count)
+	{
+		rank = count;
+	}
+	return sorted[rank - 1];
+}
+
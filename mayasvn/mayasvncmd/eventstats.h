@@ -0,0 +1,47 @@
+/*=======================================================================*
+ |   file name : eventstats.h
+ |-----------------------------------------------------------------------*
+ |   function  : timing for event scripts
+ *=======================================================================*/
+
+#ifndef EVENTSTATS_H
+#define EVENTSTATS_H
+/**************************** i n c l u d e s ****************************/
+
+
+/*************************** c o n s t a n t s ***************************/
+
+#define ES_NUM_SAMPLES	128	// recent times kept for the percentile
+
+/******************************* t y p e s *******************************/
+
+struct EventStats
+{
+	unsigned	calls;
+	unsigned	failures;	// check scripts that cancelled the operation
+	double		totalMs;
+	double		minMs;
+	double		maxMs;
+	unsigned	numSamples;
+	unsigned	nextSample;
+	float		samples[ES_NUM_SAMPLES];
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern void esSetEnabled (bool bEnabled);
+extern bool esGetEnabled ();
+extern __int64 esNow ();
+extern double esElapsedMs (__int64 start);
+extern void esReset (EventStats* pStats);
+extern void esAdd (EventStats* pStats, double ms, bool bFailed);
+extern double esPercentile (const EventStats* pStats, double percent);
+
+#endif /* EVENTSTATS_H */
+
@@ -0,0 +1,317 @@
+/*=======================================================================*
+ |   file name : filecompare.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : fast binary file comparison
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <emmintrin.h>
+#include <string.h>
+#include "filecompare.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+// how much of each file we map at a time.  Must be a multiple of the
+// system allocation granularity (64k).  We are a 32bit process living
+// inside Maya so we can't just map a 500meg PSD in one go.
+#define FC_VIEW_SIZE	(16 * 1024 * 1024)
+
+// how much we compare before checking if we can stop.  This is also
+// the granularity of bytesRead
+#define FC_BLOCK_SIZE	(64 * 1024)
+
+// buffer size used if we can't map the files (some network shares)
+#define FC_STREAM_SIZE	(1024 * 1024)
+
+#ifndef PF_XMMI64_INSTRUCTIONS_AVAILABLE
+#define PF_XMMI64_INSTRUCTIONS_AVAILABLE	10
+#endif
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static int s_haveSSE2 = -1;	// -1 = don't know yet
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static bool fcMemEqualSSE2 (const unsigned char* p1, const unsigned char* p2, unsigned len)
+{
+	unsigned ii = 0;
+
+	for (; ii + 64 <= len; ii += 64)
+	{
+		__m128i eq0 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p1 + ii     )), _mm_load_si128((const __m128i*)(p2 + ii     )));
+		__m128i eq1 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p1 + ii + 16)), _mm_load_si128((const __m128i*)(p2 + ii + 16)));
+		__m128i eq2 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p1 + ii + 32)), _mm_load_si128((const __m128i*)(p2 + ii + 32)));
+		__m128i eq3 = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)(p1 + ii + 48)), _mm_load_si128((const __m128i*)(p2 + ii + 48)));
+
+		__m128i eq  = _mm_and_si128(_mm_and_si128(eq0, eq1), _mm_and_si128(eq2, eq3));
+
+		if (_mm_movemask_epi8(eq) != 0xFFFF)
+		{
+			return false;
+		}
+	}
+
+	return memcmp(p1 + ii, p2 + ii, len - ii) == 0;
+}
+
+/*************************************************************************
+                              fcMemEqual
+ *************************************************************************
+
+   SYNOPSIS
+		bool fcMemEqual (const void* p1, const void* p2, unsigned len)
+
+   PURPOSE
+		compare 2 blocks of memory.  Uses SSE2 if the cpu has it and
+		both blocks are 16 byte aligned (they always are for mapped
+		views and our stream buffers), otherwise memcmp.
+
+   RETURNS
+		true if the blocks are the same
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool fcMemEqual (const void* p1, const void* p2, unsigned len)
+{
+	if (s_haveSSE2 < 0)
+	{
+		s_haveSSE2 = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+	}
+
+	if (s_haveSSE2 && !(((size_t)p1 | (size_t)p2) & 15))
+	{
+		return fcMemEqualSSE2((const unsigned char*)p1, (const unsigned char*)p2, len);
+	}
+
+	return memcmp(p1, p2, len) == 0;
+}
+
+// returns 1 = same, 0 = different, -1 = read error (network file went away etc)
+// must not contain anything with a destructor because of __try
+static int fcCompareViews (const unsigned char* p1, const unsigned char* p2, unsigned len, unsigned __int64* pBytesRead)
+{
+	__try
+	{
+		for (unsigned offset = 0; offset < len; offset += FC_BLOCK_SIZE)
+		{
+			unsigned blockLen = len - offset > FC_BLOCK_SIZE ? FC_BLOCK_SIZE : len - offset;
+
+			*pBytesRead += blockLen;
+
+			if (!fcMemEqual(p1 + offset, p2 + offset, blockLen))
+			{
+				return 0;
+			}
+		}
+	}
+	__except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return -1;
+	}
+
+	return 1;
+}
+
+static int fcCompareMapped (HANDLE fh1, HANDLE fh2, unsigned __int64 size, FileCompareResult* pResult)
+{
+	int    result = -1;
+	HANDLE hMap1  = CreateFileMapping(fh1, NULL, PAGE_READONLY, 0, 0, NULL);
+	HANDLE hMap2  = CreateFileMapping(fh2, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (hMap1 && hMap2)
+	{
+		unsigned __int64 offset = 0;
+
+		result = 1;
+		while (result == 1 && offset < size)
+		{
+			unsigned viewLen = size - offset > FC_VIEW_SIZE ? FC_VIEW_SIZE : (unsigned)(size - offset);
+			DWORD    offHigh = (DWORD)(offset >> 32);
+			DWORD    offLow  = (DWORD)(offset & 0xFFFFFFFF);
+
+			const unsigned char* p1 = (const unsigned char*)MapViewOfFile(hMap1, FILE_MAP_READ, offHigh, offLow, viewLen);
+			const unsigned char* p2 = (const unsigned char*)MapViewOfFile(hMap2, FILE_MAP_READ, offHigh, offLow, viewLen);
+
+			if (p1 && p2)
+			{
+				result = fcCompareViews(p1, p2, viewLen, &pResult->bytesRead);
+			}
+			else
+			{
+				result = -1;
+			}
+
+			if (p2) UnmapViewOfFile(p2);
+			if (p1) UnmapViewOfFile(p1);
+
+			offset += viewLen;
+		}
+	}
+
+	if (hMap2) CloseHandle(hMap2);
+	if (hMap1) CloseHandle(hMap1);
+
+	return result;
+}
+
+static bool fcReadFull (HANDLE fh, unsigned char* buffer, DWORD len)
+{
+	while (len > 0)
+	{
+		DWORD numRead = 0;
+
+		if (!ReadFile(fh, buffer, len, &numRead, NULL) || numRead == 0)
+		{
+			return false;
+		}
+		buffer += numRead;
+		len    -= numRead;
+	}
+	return true;
+}
+
+static int fcCompareStreamed (HANDLE fh1, HANDLE fh2, unsigned __int64 size, FileCompareResult* pResult)
+{
+	int result = -1;
+	unsigned char* buffer1 = (unsigned char*)VirtualAlloc(NULL, FC_STREAM_SIZE, MEM_COMMIT, PAGE_READWRITE);
+	unsigned char* buffer2 = (unsigned char*)VirtualAlloc(NULL, FC_STREAM_SIZE, MEM_COMMIT, PAGE_READWRITE);
+
+	if (buffer1 && buffer2)
+	{
+		unsigned __int64 offset = 0;
+
+		SetFilePointer(fh1, 0, NULL, FILE_BEGIN);
+		SetFilePointer(fh2, 0, NULL, FILE_BEGIN);
+
+		result = 1;
+		while (result == 1 && offset < size)
+		{
+			DWORD sizeToRead = size - offset > FC_STREAM_SIZE ? FC_STREAM_SIZE : (DWORD)(size - offset);
+
+			if (!fcReadFull(fh1, buffer1, sizeToRead) || !fcReadFull(fh2, buffer2, sizeToRead))
+			{
+				result = -1;
+			}
+			else
+			{
+				result = fcCompareViews(buffer1, buffer2, sizeToRead, &pResult->bytesRead);
+			}
+
+			offset += sizeToRead;
+		}
+	}
+
+	if (buffer2) VirtualFree(buffer2, 0, MEM_RELEASE);
+	if (buffer1) VirtualFree(buffer1, 0, MEM_RELEASE);
+
+	return result;
+}
+
+/*************************************************************************
+                              fcCompareFiles
+ *************************************************************************
+
+   SYNOPSIS
+		bool fcCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult)
+
+   PURPOSE
+		Check if 2 files are binary identical.
+
+		Checks the cheap stuff first.  If both names are the same file
+		(same volume and file index) they are the same.  If the sizes
+		are different they are different.  Otherwise the files are
+		mapped and compared a block at a time, stopping at the first
+		block that is different.  If the files can't be mapped they
+		are read with large buffered reads instead.
+
+   INPUT
+		file1   : path of first file
+		file2   : path of second file
+		pResult : optional, gets details of what happened
+
+   RETURNS
+		true if the files are the same, false if they are different
+		or either one could not be read.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool fcCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult)
+{
+	FileCompareResult	dummy;
+	BY_HANDLE_FILE_INFORMATION info1;
+	BY_HANDLE_FILE_INFORMATION info2;
+	HANDLE				fh1 = INVALID_HANDLE_VALUE;
+	HANDLE				fh2 = INVALID_HANDLE_VALUE;
+
+	if (!pResult)
+	{
+		pResult = &dummy;
+	}
+
+	pResult->bSame     = false;
+	pResult->fileSize  = 0;
+	pResult->bytesRead = 0;
+	pResult->pReason   = "could not open";
+
+	fh1 = CreateFile(file1, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fh1 == INVALID_HANDLE_VALUE) goto cleanup;
+	fh2 = CreateFile(file2, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fh2 == INVALID_HANDLE_VALUE) goto cleanup;
+
+	if (!GetFileInformationByHandle(fh1, &info1) ||
+		!GetFileInformationByHandle(fh2, &info2))
+	{
+		pResult->pReason = "could not get file info";
+		goto cleanup;
+	}
+
+	pResult->fileSize = ((unsigned __int64)info1.nFileSizeHigh << 32) | info1.nFileSizeLow;
+
+	// same file by 2 names?
+	if (info1.dwVolumeSerialNumber == info2.dwVolumeSerialNumber &&
+		info1.nFileIndexHigh       == info2.nFileIndexHigh &&
+		info1.nFileIndexLow        == info2.nFileIndexLow)
+	{
+		pResult->bSame   = true;
+		pResult->pReason = "same file";
+		goto cleanup;
+	}
+
+	if (info1.nFileSizeHigh != info2.nFileSizeHigh ||
+		info1.nFileSizeLow  != info2.nFileSizeLow)
+	{
+		pResult->pReason = "size differs";
+		goto cleanup;
+	}
+
+	{
+		int result = fcCompareMapped(fh1, fh2, pResult->fileSize, pResult);
+		if (result < 0)
+		{
+			pResult->bytesRead = 0;
+			result = fcCompareStreamed(fh1, fh2, pResult->fileSize, pResult);
+		}
+
+		pResult->bSame   = (result == 1);
+		pResult->pReason = result == 1 ? "content same" : (result == 0 ? "content differs" : "read error");
+	}
+
+cleanup:
+	if (fh2 != INVALID_HANDLE_VALUE) CloseHandle(fh2);
+	if (fh1 != INVALID_HANDLE_VALUE) CloseHandle(fh1);
+
+	return pResult->bSame;
+}
+
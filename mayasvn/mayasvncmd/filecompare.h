@@ -0,0 +1,37 @@
+/*=======================================================================*
+ |   file name : filecompare.h
+ |-----------------------------------------------------------------------*
+ |   function  : fast binary file comparison
+ *=======================================================================*/
+
+#ifndef FILECOMPARE_H
+#define FILECOMPARE_H
+/**************************** i n c l u d e s ****************************/
+
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct FileCompareResult
+{
+	bool				bSame;
+	unsigned __int64	fileSize;	// size of the first file
+	unsigned __int64	bytesRead;	// bytes read from EACH file before we knew the answer
+	const char*			pReason;	// short description of how we decided
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool fcCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult);
+extern bool fcMemEqual (const void* p1, const void* p2, unsigned len);
+
+#endif /* FILECOMPARE_H */
+
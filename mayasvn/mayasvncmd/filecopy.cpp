@@ -0,0 +1,230 @@
+/*=======================================================================*
+ |   file name : filecopy.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : copy files so the destination is never half written
+ *=======================================================================*/
+
+/*
+   CopyFile does the reading and writing inside windows so none of the
+   data passes through our own buffers.  It copies to a temp file next
+   to the destination, the size is checked against the source and only
+   then is the temp file renamed over the destination.  Someone loading
+   the file during the copy gets the old one or the new one, never part
+   of the new one.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "dircache.h"
+#include "filecopy.h"
+#include "threadpool.h"
+#include "trace.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct CopyBatch
+{
+	const vector<string>*	srcs;
+	const vector<string>*	dsts;
+	vector<FileCopyResult>*	results;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static string cpError (const char* pWhat, const string& path)
+{
+	char buf[64];
+
+	sprintf(buf, " (error %lu)", (unsigned long)GetLastError());
+	return string(pWhat) + " \"" + path + "\"" + buf;
+}
+
+// make every folder above path that isn't there
+static bool cpMakeDirs (const string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+
+	if (slash == string::npos || slash == 0 || path[slash - 1] == ':')
+	{
+		return true;
+	}
+
+	string	dir   = path.substr(0, slash);
+	DWORD	attrs = GetFileAttributes(dir.c_str());
+
+	if (attrs != INVALID_FILE_ATTRIBUTES)
+	{
+		return (attrs & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	}
+	if (!cpMakeDirs(dir))
+	{
+		return false;
+	}
+	if (!CreateDirectory(dir.c_str(), NULL))
+	{
+		// another copy may have just made it
+		return GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+	dcInvalidate(dir.c_str());
+	return true;
+}
+
+static bool cpGetSize (const char* path, unsigned __int64* pSize)
+{
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+
+	if (!GetFileAttributesEx(path, GetFileExInfoStandard, &fad))
+	{
+		return false;
+	}
+	*pSize = ((unsigned __int64)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+	return true;
+}
+
+/*************************************************************************
+                               cpCopyFile
+ *************************************************************************
+
+   SYNOPSIS
+		bool cpCopyFile (const char* src, const char* dst, FileCopyResult* pResult)
+
+   PURPOSE
+		copy src to dst, making dst's folder if needed.  dst is
+		replaced in one step or not at all.  Any thread.
+
+   RETURNS
+		false if it wasn't copied, pResult->error says why
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool cpCopyFile (const char* src, const char* dst, FileCopyResult* pResult)
+{
+	TraceSpan		span("copy", "copyFile");
+	LARGE_INTEGER	freq;
+	LARGE_INTEGER	start;
+	LARGE_INTEGER	end;
+	unsigned __int64 srcSize;
+	unsigned __int64 tmpSize;
+	char			suffix[32];
+
+	span.setArg("src", src);
+	span.setArg("dst", dst);
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&start);
+
+	pResult->bOk     = false;
+	pResult->bytes   = 0;
+	pResult->seconds = 0.0;
+	pResult->error.erase();
+
+	// unique per thread so two copies to the same place don't collide
+	sprintf(suffix, ".%lx.mayasvn-tmp", (unsigned long)GetCurrentThreadId());
+
+	string tmp = string(dst) + suffix;
+
+	if (!cpGetSize(src, &srcSize))
+	{
+		pResult->error = cpError("could not read", src);
+	}
+	else if (!cpMakeDirs(dst))
+	{
+		pResult->error = cpError("could not make the folder for", dst);
+	}
+	else if (!CopyFile(src, tmp.c_str(), FALSE))
+	{
+		pResult->error = cpError("could not copy to", tmp);
+	}
+	else if (!cpGetSize(tmp.c_str(), &tmpSize) || tmpSize != srcSize)
+	{
+		pResult->error = "copy of \"" + string(src) + "\" came out the wrong size";
+	}
+	else
+	{
+		// CopyFile kept src's attributes, the temp file has to be
+		// writable for the rename to replace and later delete it
+		DWORD attrs = GetFileAttributes(tmp.c_str());
+
+		if (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_READONLY))
+		{
+			SetFileAttributes(tmp.c_str(), attrs & ~FILE_ATTRIBUTE_READONLY);
+		}
+		if (!MoveFileEx(tmp.c_str(), dst, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			pResult->error = cpError("could not replace", dst);
+		}
+		else
+		{
+			if (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_READONLY))
+			{
+				SetFileAttributes(dst, attrs);
+			}
+			dcInvalidate(dst);
+			pResult->bOk   = true;
+			pResult->bytes = srcSize;
+		}
+	}
+
+	if (!pResult->bOk)
+	{
+		DeleteFile(tmp.c_str());
+	}
+
+	QueryPerformanceCounter(&end);
+	pResult->seconds = (double)(end.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+	span.setArg("result", pResult->bOk ? "copied" : pResult->error.c_str());
+	return pResult->bOk;
+}
+
+static void cpCopyItem (int index, void* pContext)
+{
+	CopyBatch* pBatch = (CopyBatch*)pContext;
+
+	cpCopyFile((*pBatch->srcs)[index].c_str(), (*pBatch->dsts)[index].c_str(), &(*pBatch->results)[index]);
+}
+
+/*************************************************************************
+                               cpCopyFiles
+ *************************************************************************
+
+   SYNOPSIS
+		void cpCopyFiles (const vector<string>& srcs, const vector<string>& dsts, vector<FileCopyResult>& results)
+
+   PURPOSE
+		copy srcs[n] to dsts[n] for every n, CP_MAX_COPIES at a time.
+		A failure doesn't stop the rest.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void cpCopyFiles (const vector<string>& srcs, const vector<string>& dsts, vector<FileCopyResult>& results)
+{
+	CopyBatch batch;
+
+	results.resize(srcs.size());
+	batch.srcs    = &srcs;
+	batch.dsts    = &dsts;
+	batch.results = &results;
+
+	wpRunParallel((int)srcs.size(), cpCopyItem, &batch, CP_MAX_COPIES);
+}
@@ -0,0 +1,40 @@
+/*=======================================================================*
+ |   file name : filecopy.h
+ |-----------------------------------------------------------------------*
+ |   function  : copy files so the destination is never half written
+ *=======================================================================*/
+
+#ifndef FILECOPY_H
+#define FILECOPY_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CP_MAX_COPIES	4	// at once, more just makes the disk seek
+
+/******************************* t y p e s *******************************/
+
+struct FileCopyResult
+{
+	bool				bOk;
+	unsigned __int64	bytes;
+	double				seconds;
+	std::string			error;	// why not, when !bOk
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool cpCopyFile (const char* src, const char* dst, FileCopyResult* pResult);
+extern void cpCopyFiles (const std::vector<std::string>& srcs, const std::vector<std::string>& dsts, std::vector<FileCopyResult>& results);
+
+#endif /* FILECOPY_H */
+
@@ -0,0 +1,178 @@
+/*=======================================================================*
+ |   file name : filecopytest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for copying files
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "coretest.h"
+#include "filecopy.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_NUM_BATCH	8	// more than CP_MAX_COPIES
+#define CT_MISSING		3	// the one in the batch with no source
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// everything in path, "<missing>" if it can't be read
+static string readFile (const string& path)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (!fp)
+	{
+		return "<missing>";
+	}
+
+	string	data;
+	char	buf[256];
+	size_t	len;
+
+	while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+	{
+		data.append(buf, len);
+	}
+	fclose(fp);
+	return data;
+}
+
+// any temp file a copy left behind in dir
+static bool hasTempFiles (const string& dir)
+{
+	WIN32_FIND_DATA	fd;
+	HANDLE			hFind = FindFirstFile((dir + "\\*.mayasvn-tmp").c_str(), &fd);
+
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	FindClose(hFind);
+	return true;
+}
+
+static void testCopyFile (const string& dir)
+{
+	FileCopyResult	result;
+	string			src = dir + "\\a.txt";
+	string			dst = dir + "\\new\\deeper\\a.txt";
+
+	CHECK(ctWriteFile(src, "alpha", 0));
+
+	// folders that aren't there are made
+	CHECK(cpCopyFile(src.c_str(), dst.c_str(), &result));
+	CHECK(result.bOk);
+	CHECK(result.bytes == 5);
+	CHECK(result.error.empty());
+	CHECK(readFile(dst) == "alpha");
+	CHECK(!hasTempFiles(dir + "\\new\\deeper"));
+
+	// an existing file is replaced
+	CHECK(ctWriteFile(src, "alpha two", 0));
+	CHECK(cpCopyFile(src.c_str(), dst.c_str(), &result));
+	CHECK(result.bytes == 9);
+	CHECK(readFile(dst) == "alpha two");
+
+	// a read only source gives a read only copy
+	string roSrc = dir + "\\ro.txt";
+	string roDst = dir + "\\new\\ro.txt";
+
+	CHECK(ctWriteFile(roSrc, "read only", 0));
+	SetFileAttributes(roSrc.c_str(), FILE_ATTRIBUTE_READONLY);
+	CHECK(cpCopyFile(roSrc.c_str(), roDst.c_str(), &result));
+	CHECK(readFile(roDst) == "read only");
+	CHECK((GetFileAttributes(roDst.c_str()) & FILE_ATTRIBUTE_READONLY) != 0);
+	CHECK(!hasTempFiles(dir + "\\new"));
+
+	// nothing to copy
+	string missing = dir + "\\missing.txt";
+	string noDst   = dir + "\\new\\missing.txt";
+
+	CHECK(!cpCopyFile(missing.c_str(), noDst.c_str(), &result));
+	CHECK(!result.bOk);
+	CHECK(result.bytes == 0);
+	CHECK(!result.error.compare(0, 14, "could not read"));
+	CHECK(readFile(noDst) == "<missing>");
+}
+
+static void testCopyFiles (const string& dir)
+{
+	vector<string>			srcs;
+	vector<string>			dsts;
+	vector<FileCopyResult>	results;
+	char					name[32];
+
+	CHECK(CreateDirectory((dir + "\\batch").c_str(), NULL) != 0);
+	for (int ii = 0; ii < CT_NUM_BATCH; ++ii)
+	{
+		sprintf(name, "\\file%d.txt", ii);
+		srcs.push_back(dir + "\\batch" + name);
+		dsts.push_back(dir + "\\batchcopy" + name);
+		if (ii != CT_MISSING)
+		{
+			CHECK(ctWriteFile(srcs.back(), name, 0));
+		}
+	}
+
+	// one missing doesn't stop the rest
+	cpCopyFiles(srcs, dsts, results);
+	CHECK(results.size() == CT_NUM_BATCH);
+
+	bool bAllOk = results.size() == CT_NUM_BATCH;
+
+	for (size_t ii = 0; ii < results.size(); ++ii)
+	{
+		if (ii == CT_MISSING)
+		{
+			CHECK(!results[ii].bOk && !results[ii].error.empty());
+			CHECK(readFile(dsts[ii]) == "<missing>");
+			continue;
+		}
+		sprintf(name, "\\file%d.txt", (int)ii);
+		bAllOk = bAllOk && results[ii].bOk && readFile(dsts[ii]) == name;
+	}
+	CHECK(bAllOk);
+	CHECK(!hasTempFiles(dir + "\\batchcopy"));
+
+	// nothing to do
+	srcs.clear();
+	dsts.clear();
+	cpCopyFiles(srcs, dsts, results);
+	CHECK(results.empty());
+}
+
+void testFileCopy ()
+{
+	string dir;
+
+	if (!CHECK(ctMakeTempDir("filecopy", &dir)))
+	{
+		return;
+	}
+
+	testCopyFile(dir);
+	testCopyFiles(dir);
+
+	ctRemoveDir(dir);
+}
@@ -0,0 +1,43 @@
+/*=======================================================================*
+ |   file name : fsiface.h
+ |-----------------------------------------------------------------------*
+ |   function  : what the Maya-free code needs from the disk
+ *=======================================================================*/
+
+#ifndef FSIFACE_H
+#define FSIFACE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// list the files (not folders) in dir whose names start with namePrefix,
+// case doesn't matter and it's ok to return ones that don't match.  dir
+// is "" or ends in a slash.  Returns false only if dir couldn't be read,
+// dir not being there is no files.
+typedef bool (*FsListFilesFunc)(const char* dir, const char* namePrefix, std::vector<std::string>* pNames, std::string* pError, void* pContext);
+
+// pathutil.cpp has the real one, g_diskFs.  Anything else can hand
+// seqscan and texmanifest a pretend disk.
+struct FsInterface
+{
+	FsListFilesFunc	listFiles;
+	void*			pContext;
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+#endif /* FSIFACE_H */
+
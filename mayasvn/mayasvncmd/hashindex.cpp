@@ -0,0 +1,768 @@
+/*=======================================================================*
+ |   file name : hashindex.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : persistent index of file content hashes
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "hashindex.h"
+#include "pathutil.h"
+
+using std::map;
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define HI_MAGIC		0x4948534D	// 'MSHI'
+#define HI_VERSION		1
+
+#define HI_VIEW_SIZE	(16 * 1024 * 1024)
+#define HI_STREAM_SIZE	(1024 * 1024)
+
+// files modified this recently (100ns ticks) are not added to the index
+// because they could be modified again within the same timestamp and
+// we'd never notice.
+#define HI_RACY_TIME	((unsigned __int64)2 * 10000000)
+
+#ifdef _MSC_VER
+#define HI_U64(x)	x##ui64
+#else
+#define HI_U64(x)	x##ULL
+#endif
+
+#define XXH_PRIME64_1	HI_U64(0x9E3779B185EBCA87)
+#define XXH_PRIME64_2	HI_U64(0xC2B2AE3D27D4EB4F)
+#define XXH_PRIME64_3	HI_U64(0x165667B19E3779F9)
+#define XXH_PRIME64_4	HI_U64(0x85EBCA77C2B2AE63)
+#define XXH_PRIME64_5	HI_U64(0x27D4EB2F165667C5)
+
+/******************************* t y p e s *******************************/
+
+typedef unsigned __int64 U64;
+
+struct HashEntry
+{
+	U64		size;
+	U64		mtime;
+	U64		hash;
+};
+
+typedef map<string, HashEntry> HashMap;
+
+// xxHash64 streaming state
+struct XXH64State
+{
+	U64				totalLen;
+	U64				v1;
+	U64				v2;
+	U64				v3;
+	U64				v4;
+	unsigned char	mem[32];
+	unsigned		memSize;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static bool				s_bInitialized;
+static CRITICAL_SECTION	s_cs;
+static string			s_indexFile;
+static HashMap			s_entries;
+static bool				s_bDirty;
+static unsigned			s_hits;
+static unsigned			s_misses;
+static U64				s_bytesHashed;
+
+/****************************** m a c r o s ******************************/
+
+#define XXH_ROTL64(x,r)	(((x) << (r)) | ((x) >> (64 - (r))))
+
+/**************************** r o u t i n e s ****************************/
+
+static U64 xxhRead64 (const unsigned char* p)
+{
+	U64 v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static unsigned xxhRead32 (const unsigned char* p)
+{
+	unsigned v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static U64 xxhRound (U64 acc, U64 input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc  = XXH_ROTL64(acc, 31);
+	acc *= XXH_PRIME64_1;
+	return acc;
+}
+
+static U64 xxhMergeRound (U64 acc, U64 val)
+{
+	val  = xxhRound(0, val);
+	acc ^= val;
+	acc  = acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+	return acc;
+}
+
+static void xxhReset (XXH64State* pState, U64 seed)
+{
+	memset(pState, 0, sizeof(*pState));
+	pState->v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+	pState->v2 = seed + XXH_PRIME64_2;
+	pState->v3 = seed;
+	pState->v4 = seed - XXH_PRIME64_1;
+}
+
+static void xxhUpdate (XXH64State* pState, const unsigned char* p, unsigned len)
+{
+	const unsigned char* end = p + len;
+
+	pState->totalLen += len;
+
+	if (pState->memSize + len < 32)
+	{
+		memcpy(pState->mem + pState->memSize, p, len);
+		pState->memSize += len;
+		return;
+	}
+
+	if (pState->memSize)
+	{
+		unsigned fill = 32 - pState->memSize;
+
+		memcpy(pState->mem + pState->memSize, p, fill);
+		pState->v1 = xxhRound(pState->v1, xxhRead64(pState->mem));
+		pState->v2 = xxhRound(pState->v2, xxhRead64(pState->mem + 8));
+		pState->v3 = xxhRound(pState->v3, xxhRead64(pState->mem + 16));
+		pState->v4 = xxhRound(pState->v4, xxhRead64(pState->mem + 24));
+		p += fill;
+		pState->memSize = 0;
+	}
+
+	{
+		U64 v1 = pState->v1;
+		U64 v2 = pState->v2;
+		U64 v3 = pState->v3;
+		U64 v4 = pState->v4;
+
+		while (p + 32 <= end)
+		{
+			v1 = xxhRound(v1, xxhRead64(p)); p += 8;
+			v2 = xxhRound(v2, xxhRead64(p)); p += 8;
+			v3 = xxhRound(v3, xxhRead64(p)); p += 8;
+			v4 = xxhRound(v4, xxhRead64(p)); p += 8;
+		}
+
+		pState->v1 = v1;
+		pState->v2 = v2;
+		pState->v3 = v3;
+		pState->v4 = v4;
+	}
+
+	if (p < end)
+	{
+		pState->memSize = (unsigned)(end - p);
+		memcpy(pState->mem, p, pState->memSize);
+	}
+}
+
+static U64 xxhDigest (const XXH64State* pState)
+{
+	const unsigned char* p   = pState->mem;
+	const unsigned char* end = p + pState->memSize;
+	U64 h;
+
+	if (pState->totalLen >= 32)
+	{
+		h = XXH_ROTL64(pState->v1, 1) + XXH_ROTL64(pState->v2, 7) + XXH_ROTL64(pState->v3, 12) + XXH_ROTL64(pState->v4, 18);
+		h = xxhMergeRound(h, pState->v1);
+		h = xxhMergeRound(h, pState->v2);
+		h = xxhMergeRound(h, pState->v3);
+		h = xxhMergeRound(h, pState->v4);
+	}
+	else
+	{
+		h = pState->v3 + XXH_PRIME64_5;	// v3 == seed
+	}
+
+	h += pState->totalLen;
+
+	while (p + 8 <= end)
+	{
+		h ^= xxhRound(0, xxhRead64(p));
+		h  = XXH_ROTL64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		p += 8;
+	}
+
+	if (p + 4 <= end)
+	{
+		h ^= (U64)xxhRead32(p) * XXH_PRIME64_1;
+		h  = XXH_ROTL64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+
+	while (p < end)
+	{
+		h ^= (*p) * XXH_PRIME64_5;
+		h  = XXH_ROTL64(h, 11) * XXH_PRIME64_1;
+		++p;
+	}
+
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+// must not contain anything with a destructor because of __try
+static bool hiHashView (XXH64State* pState, const unsigned char* p, unsigned len)
+{
+	__try
+	{
+		xxhUpdate(pState, p, len);
+	}
+	__except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		return false;
+	}
+	return true;
+}
+
+static bool hiHashHandle (HANDLE fh, U64 size, U64* pHash)
+{
+	XXH64State	state;
+	bool		bOk = false;
+	HANDLE		hMap;
+
+	xxhReset(&state, 0);
+
+	if (size == 0)
+	{
+		*pHash = xxhDigest(&state);
+		return true;
+	}
+
+	hMap = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMap)
+	{
+		U64 offset = 0;
+
+		bOk = true;
+		while (bOk && offset < size)
+		{
+			unsigned viewLen = size - offset > HI_VIEW_SIZE ? HI_VIEW_SIZE : (unsigned)(size - offset);
+			const unsigned char* p = (const unsigned char*)MapViewOfFile(hMap, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), viewLen);
+
+			bOk = p && hiHashView(&state, p, viewLen);
+			if (p) UnmapViewOfFile(p);
+
+			offset += viewLen;
+		}
+		CloseHandle(hMap);
+	}
+
+	if (!bOk)
+	{
+		// could not map it (some network shares) so just read it
+		unsigned char* buffer = (unsigned char*)VirtualAlloc(NULL, HI_STREAM_SIZE, MEM_COMMIT, PAGE_READWRITE);
+
+		if (buffer)
+		{
+			U64 offset = 0;
+
+			xxhReset(&state, 0);
+			SetFilePointer(fh, 0, NULL, FILE_BEGIN);
+
+			bOk = true;
+			while (bOk && offset < size)
+			{
+				DWORD numRead = 0;
+
+				bOk = ReadFile(fh, buffer, HI_STREAM_SIZE, &numRead, NULL) && numRead > 0;
+				if (bOk)
+				{
+					xxhUpdate(&state, buffer, numRead);
+					offset += numRead;
+				}
+			}
+
+			VirtualFree(buffer, 0, MEM_RELEASE);
+		}
+	}
+
+	if (bOk)
+	{
+		*pHash = xxhDigest(&state);
+	}
+
+	return bOk;
+}
+
+static void hiLoad ()
+{
+	FILE* fp = fopen(s_indexFile.c_str(), "rb");
+
+	s_entries.clear();
+	s_bDirty = false;
+
+	if (fp)
+	{
+		unsigned header[3];
+
+		if (fread(header, sizeof(header), 1, fp) == 1 &&
+			header[0] == HI_MAGIC &&
+			header[1] == HI_VERSION)
+		{
+			for (unsigned ii = 0; ii < header[2]; ++ii)
+			{
+				unsigned	pathLen;
+				HashEntry	entry;
+				char		path[MAX_PATH * 4];
+
+				if (fread(&pathLen, sizeof(pathLen), 1, fp) != 1 ||
+					pathLen >= sizeof(path) ||
+					fread(path, pathLen, 1, fp) != 1 ||
+					fread(&entry, sizeof(entry), 1, fp) != 1)
+				{
+					// truncated or corrupt, throw it all away
+					s_entries.clear();
+					s_bDirty = true;
+					break;
+				}
+				path[pathLen] = '\0';
+				s_entries[path] = entry;
+			}
+		}
+		fclose(fp);
+	}
+}
+
+/*************************************************************************
+                              hiSetIndexFile
+ *************************************************************************
+
+   SYNOPSIS
+		void hiSetIndexFile (const char* filename)
+
+   PURPOSE
+		set the file the index is kept in and load it.  Saves the
+		current index first if it changed.  Passing "" turns off
+		the index.
+
+		Must be called from the main thread.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void hiSetIndexFile (const char* filename)
+{
+	if (!s_bInitialized)
+	{
+		InitializeCriticalSection(&s_cs);
+		s_bInitialized = true;
+	}
+
+	hiSave();
+
+	EnterCriticalSection(&s_cs);
+	s_indexFile = filename;
+	s_entries.clear();
+	s_bDirty = false;
+	if (!s_indexFile.empty())
+	{
+		hiLoad();
+	}
+	LeaveCriticalSection(&s_cs);
+}
+
+const char* hiGetIndexFile ()
+{
+	return s_indexFile.c_str();
+}
+
+bool hiIsEnabled ()
+{
+	return !s_indexFile.empty();
+}
+
+// the hash in the index if it's there and the file hasn't changed
+static bool hiLookup (const string& key, const PathInfo& info, U64* pHash)
+{
+	bool bFound = false;
+
+	EnterCriticalSection(&s_cs);
+	HashMap::const_iterator it = s_entries.find(key);
+	if (it != s_entries.end() && it->second.size == info.size && it->second.mtime == info.mtime)
+	{
+		*pHash = it->second.hash;
+		bFound = true;
+		++s_hits;
+	}
+	else
+	{
+		++s_misses;
+	}
+	LeaveCriticalSection(&s_cs);
+	return bFound;
+}
+
+// files written in the last HI_RACY_TIME could change again without
+// their time changing so they aren't remembered
+static bool hiIsRacy (const PathInfo& info)
+{
+	return puGetCurrentFileTime() - info.mtime <= HI_RACY_TIME;
+}
+
+static void hiStore (const string& key, const PathInfo& info, U64 hash)
+{
+	if (hiIsRacy(info))
+	{
+		return;
+	}
+	EnterCriticalSection(&s_cs);
+	HashEntry& entry = s_entries[key];
+
+	entry.size  = info.size;
+	entry.mtime = info.mtime;
+	entry.hash  = hash;
+	s_bDirty    = true;
+	LeaveCriticalSection(&s_cs);
+}
+
+// read the whole file and remember its hash
+static bool hiHashFile (const char* filename, const string& key, const PathInfo& info, U64* pHash)
+{
+	HANDLE	fh;
+	bool	bOk;
+
+	fh = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fh == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	bOk = hiHashHandle(fh, info.size, pHash);
+	CloseHandle(fh);
+
+	if (bOk)
+	{
+		EnterCriticalSection(&s_cs);
+		s_bytesHashed += info.size;
+		LeaveCriticalSection(&s_cs);
+		hiStore(key, info, *pHash);
+	}
+	return bOk;
+}
+
+static bool hiGetHashForInfo (const char* filename, const PathInfo& info, U64* pHash, U64* pBytesRead)
+{
+	string key = puNormalizePath(filename);
+
+	*pBytesRead = 0;
+
+	if (hiLookup(key, info, pHash))
+	{
+		return true;
+	}
+	if (!hiHashFile(filename, key, info, pHash))
+	{
+		return false;
+	}
+	*pBytesRead = info.size;
+	return true;
+}
+
+/*************************************************************************
+                              hiGetFileHash
+ *************************************************************************
+
+   SYNOPSIS
+		bool hiGetFileHash (const char* filename, U64* pHash, U64* pBytesRead)
+
+   PURPOSE
+		get the content hash of a file.  If the index has an entry
+		with the same size and modification time it is used,
+		otherwise the file is hashed and the index updated.
+
+		Works (without the index) even if no index file is set.
+
+   RETURNS
+		false if the file could not be read
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool hiGetFileHash (const char* filename, U64* pHash, U64* pBytesRead)
+{
+	PathInfo	info;
+	U64			bytesRead = 0;
+	bool		bOk = false;
+
+	if (puGetPathInfo(filename, &info) && !info.bIsDir)
+	{
+		if (hiIsEnabled())
+		{
+			bOk = hiGetHashForInfo(filename, info, pHash, &bytesRead);
+		}
+		else
+		{
+			HANDLE fh = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (fh != INVALID_HANDLE_VALUE)
+			{
+				bOk = hiHashHandle(fh, info.size, pHash);
+				bytesRead = info.size;
+				CloseHandle(fh);
+			}
+		}
+	}
+
+	if (pBytesRead)
+	{
+		*pBytesRead = bytesRead;
+	}
+
+	return bOk;
+}
+
+/*************************************************************************
+                              hiCompareFiles
+ *************************************************************************
+
+   SYNOPSIS
+		bool hiCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult)
+
+   PURPOSE
+		same as fcCompareFiles but uses the index if one is set.  If
+		both files are in the index with matching size and
+		modification time no data is read at all.  A file that isn't
+		is hashed and added so the next compare of it reads nothing,
+		which is what makes opening an unchanged project cheap.
+
+		A file written in the last couple of seconds can't go in the
+		index so hashing it buys nothing.  Then it's fcCompareFiles,
+		which stops at the first difference, and if they turn out the
+		same and one hash was known the other file gets it too.
+
+		Safe to call from several threads at once.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool hiCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult)
+{
+	FileCompareResult	dummy;
+	PathInfo			info1;
+	PathInfo			info2;
+	U64					hash1;
+	U64					hash2;
+
+	if (!hiIsEnabled())
+	{
+		return fcCompareFiles(file1, file2, pResult);
+	}
+
+	if (!pResult)
+	{
+		pResult = &dummy;
+	}
+
+	pResult->bSame     = false;
+	pResult->fileSize  = 0;
+	pResult->bytesRead = 0;
+	pResult->pReason   = "could not open";
+
+	if (!puGetPathInfo(file1, &info1) || info1.bIsDir ||
+		!puGetPathInfo(file2, &info2) || info2.bIsDir)
+	{
+		return false;
+	}
+
+	pResult->fileSize = info1.size;
+
+	if (info1.size != info2.size)
+	{
+		pResult->pReason = "size differs";
+		return false;
+	}
+
+	string	key1   = puNormalizePath(file1);
+	string	key2   = puNormalizePath(file2);
+	bool	bHave1 = hiLookup(key1, info1, &hash1);
+	bool	bHave2 = hiLookup(key2, info2, &hash2);
+
+	if (bHave1 && bHave2)
+	{
+		pResult->bSame   = (hash1 == hash2);
+		pResult->pReason = pResult->bSame ? "index same" : "index differs";
+		return pResult->bSame;
+	}
+
+	if ((!bHave1 && hiIsRacy(info1)) || (!bHave2 && hiIsRacy(info2)))
+	{
+		if (fcCompareFiles(file1, file2, pResult) && (bHave1 || bHave2))
+		{
+			// same bytes, same hash
+			if (bHave1)
+			{
+				hiStore(key2, info2, hash1);
+			}
+			else
+			{
+				hiStore(key1, info1, hash2);
+			}
+		}
+		return pResult->bSame;
+	}
+
+	if ((!bHave1 && !hiHashFile(file1, key1, info1, &hash1)) ||
+		(!bHave2 && !hiHashFile(file2, key2, info2, &hash2)))
+	{
+		return false;
+	}
+
+	pResult->bSame     = (hash1 == hash2);
+	pResult->bytesRead = info1.size;
+	pResult->pReason   = pResult->bSame ? "hashed same" : "hashed differs";
+	return pResult->bSame;
+}
+
+/*************************************************************************
+                              hiInvalidate
+ *************************************************************************
+
+   SYNOPSIS
+		void hiInvalidate (const char* filename)
+
+   PURPOSE
+		remove a file from the index.  NULL or "" removes everything.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void hiInvalidate (const char* filename)
+{
+	if (!s_bInitialized)
+	{
+		return;
+	}
+
+	EnterCriticalSection(&s_cs);
+	if (!filename || !*filename)
+	{
+		s_entries.clear();
+		s_bDirty = true;
+	}
+	else
+	{
+		HashMap::iterator it = s_entries.find(puNormalizePath(filename));
+		if (it != s_entries.end())
+		{
+			s_entries.erase(it);
+			s_bDirty = true;
+		}
+	}
+	LeaveCriticalSection(&s_cs);
+}
+
+/*************************************************************************
+                                 hiSave
+ *************************************************************************
+
+   SYNOPSIS
+		bool hiSave ()
+
+   PURPOSE
+		write the index if it changed.  Writes to a temp file and
+		renames it so a crash can't leave a half written index.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool hiSave ()
+{
+	bool bOk = true;
+
+	if (!s_bInitialized || s_indexFile.empty())
+	{
+		return true;
+	}
+
+	EnterCriticalSection(&s_cs);
+	if (s_bDirty)
+	{
+		string tempFile = s_indexFile + ".tmp";
+		FILE* fp = fopen(tempFile.c_str(), "wb");
+
+		bOk = false;
+		if (fp)
+		{
+			unsigned header[3];
+
+			header[0] = HI_MAGIC;
+			header[1] = HI_VERSION;
+			header[2] = (unsigned)s_entries.size();
+
+			bOk = fwrite(header, sizeof(header), 1, fp) == 1;
+			for (HashMap::const_iterator it = s_entries.begin(); bOk && it != s_entries.end(); ++it)
+			{
+				unsigned pathLen = (unsigned)it->first.size();
+
+				bOk = fwrite(&pathLen, sizeof(pathLen), 1, fp) == 1 &&
+					  fwrite(it->first.c_str(), pathLen, 1, fp) == 1 &&
+					  fwrite(&it->second, sizeof(it->second), 1, fp) == 1;
+			}
+			bOk = (fclose(fp) == 0) && bOk;
+
+			if (bOk)
+			{
+				bOk = MoveFileEx(tempFile.c_str(), s_indexFile.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+			}
+			if (!bOk)
+			{
+				DeleteFile(tempFile.c_str());
+			}
+		}
+
+		if (bOk)
+		{
+			s_bDirty = false;
+		}
+	}
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+void hiGetStats (HashIndexStats* pStats)
+{
+	pStats->numEntries  = (unsigned)s_entries.size();
+	pStats->hits        = s_hits;
+	pStats->misses      = s_misses;
+	pStats->bytesHashed = s_bytesHashed;
+	pStats->bDirty      = s_bDirty;
+}
+
+void hiShutdown ()
+{
+	if (s_bInitialized)
+	{
+		hiSave();
+		s_indexFile.erase();
+		s_entries.clear();
+		DeleteCriticalSection(&s_cs);
+		s_bInitialized = false;
+	}
+}
+
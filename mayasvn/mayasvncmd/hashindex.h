@@ -0,0 +1,46 @@
+/*=======================================================================*
+ |   file name : hashindex.h
+ |-----------------------------------------------------------------------*
+ |   function  : persistent index of file content hashes
+ *=======================================================================*/
+
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+/**************************** i n c l u d e s ****************************/
+
+#include "filecompare.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct HashIndexStats
+{
+	unsigned			numEntries;
+	unsigned			hits;			// answered from the index
+	unsigned			misses;			// had to hash the file
+	unsigned __int64	bytesHashed;
+	bool				bDirty;
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern void hiSetIndexFile (const char* filename);
+extern const char* hiGetIndexFile ();
+extern bool hiIsEnabled ();
+extern bool hiGetFileHash (const char* filename, unsigned __int64* pHash, unsigned __int64* pBytesRead);
+extern bool hiCompareFiles (const char* file1, const char* file2, FileCompareResult* pResult);
+extern void hiInvalidate (const char* filename);
+extern bool hiSave ();
+extern void hiGetStats (HashIndexStats* pStats);
+extern void hiShutdown ();
+
+#endif /* HASHINDEX_H */
+
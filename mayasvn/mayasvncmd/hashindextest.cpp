@@ -0,0 +1,123 @@
+/*=======================================================================*
+ |   file name : hashindextest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the file hash index
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <string.h>
+
+#include <string>
+
+#include "coretest.h"
+#include "filecompare.h"
+#include "hashindex.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_OLD_SECS		(60 * 60)	// well past the index's racy window
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+void testHashIndex ()
+{
+	string dir;
+
+	if (!CHECK(ctMakeTempDir("hashindex", &dir)))
+	{
+		return;
+	}
+
+	string	fileA = dir + "\\a.bin";
+	string	fileB = dir + "\\b.bin";
+	string	fileC = dir + "\\c.bin";
+	string	fileD = dir + "\\d.bin";
+	string	fileE = dir + "\\e.bin";
+	string	index = dir + "\\hashindex.dat";
+
+	CHECK(ctWriteFile(fileA, "the same sixteen", CT_OLD_SECS));
+	CHECK(ctWriteFile(fileB, "the same sixteen", CT_OLD_SECS));
+	CHECK(ctWriteFile(fileC, "not same sixteen", CT_OLD_SECS));
+	CHECK(ctWriteFile(fileD, "shorter", CT_OLD_SECS));
+	CHECK(ctWriteFile(fileE, "the same sixteen", 0));
+
+	FileCompareResult	result;
+	HashIndexStats		stats;
+	unsigned __int64	hashA;
+	unsigned __int64	hashB;
+	unsigned __int64	bytesRead;
+	unsigned __int64	bytesHashed;
+
+	hiSetIndexFile(index.c_str());
+	CHECK(hiIsEnabled());
+
+	// sizes differ, nothing to hash
+	CHECK(!hiCompareFiles(fileA.c_str(), fileD.c_str(), &result) && !strcmp(result.pReason, "size differs"));
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 0);
+
+	// a miss hashes both files and keeps them
+	CHECK(!hiCompareFiles(fileA.c_str(), fileC.c_str(), &result) && !strcmp(result.pReason, "hashed differs"));
+	CHECK(result.bytesRead == 16);
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 2);
+
+	// only the side that wasn't known gets read
+	bytesHashed = stats.bytesHashed;
+	CHECK(hiCompareFiles(fileA.c_str(), fileB.c_str(), &result) && !strcmp(result.pReason, "hashed same"));
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 3);
+	CHECK(stats.bytesHashed == bytesHashed + 16);
+
+	// and after that nothing is read
+	bytesHashed = stats.bytesHashed;
+	CHECK(hiCompareFiles(fileB.c_str(), fileA.c_str(), &result) && !strcmp(result.pReason, "index same"));
+	CHECK(result.bytesRead == 0);
+	CHECK(!hiCompareFiles(fileA.c_str(), fileC.c_str(), &result) && !strcmp(result.pReason, "index differs"));
+	CHECK(hiGetFileHash(fileA.c_str(), &hashA, &bytesRead) && bytesRead == 0);
+	CHECK(hiGetFileHash(fileB.c_str(), &hashB, &bytesRead) && bytesRead == 0 && hashB == hashA);
+	hiGetStats(&stats);
+	CHECK(stats.bytesHashed == bytesHashed);
+
+	// a file that was just written is compared but not remembered
+	CHECK(hiCompareFiles(fileA.c_str(), fileE.c_str(), &result));
+	CHECK(strcmp(result.pReason, "index same") && strcmp(result.pReason, "hashed same"));
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 3);
+
+	// saved and loaded back
+	CHECK(hiSave());
+	hiSetIndexFile("");
+	CHECK(!hiIsEnabled());
+	hiSetIndexFile(index.c_str());
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 3);
+	CHECK(hiCompareFiles(fileA.c_str(), fileB.c_str(), &result) && !strcmp(result.pReason, "index same"));
+
+	// a file that changed isn't answered from the index
+	CHECK(ctWriteFile(fileB, "now not sixteen!", 2 * CT_OLD_SECS));
+	CHECK(!hiCompareFiles(fileA.c_str(), fileB.c_str(), &result) && !strcmp(result.pReason, "hashed differs"));
+
+	hiInvalidate(NULL);
+	hiGetStats(&stats);
+	CHECK(stats.numEntries == 0);
+
+	hiSetIndexFile("");
+	hiShutdown();
+	ctRemoveDir(dir);
+}
@@ -0,0 +1,245 @@
+/*=======================================================================*
+ |   file name : lockcache.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : remember who holds svn locks for a little while
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+
+#include <map>
+#include <string>
+
+#include "lockcache.h"
+#include "pathutil.h"
+#include "svnclient.h"
+
+using std::map;
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct LockEntry
+{
+	string	state;
+	DWORD	time;	// GetTickCount when we asked
+};
+
+typedef map<string, LockEntry> LockMap;	// keyed by normalized path
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static volatile LONG	s_csState;		// 0 = no s_cs yet, 1 = being made, 2 = ready
+static CRITICAL_SECTION	s_cs;
+static LockMap			s_entries;
+static unsigned			s_generation;	// bumped by every invalidation
+static unsigned			s_ttl = LC_DEFAULT_TTL;
+static unsigned			s_hits;
+static unsigned			s_misses;
+static unsigned			s_expired;
+static unsigned			s_invalidations;
+static StatusQueryFunc	s_query = scStatus;
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// s_cs is made exactly once, the svn thread's lcInvalidate can get here
+// before the main thread does
+static void lcInit ()
+{
+	if (InterlockedCompareExchange(&s_csState, 1, 0) == 0)
+	{
+		InitializeCriticalSection(&s_cs);
+		InterlockedExchange(&s_csState, 2);
+	}
+	while (s_csState != 2)
+	{
+		Sleep(0);
+	}
+}
+
+static void lcStoreState (const SvnStatus& status, void* pContext)
+{
+	string* pState = (string*)pContext;
+
+	switch (status.status[5])
+	{
+	case 'K':
+		*pState = "mine";
+		break;
+	case 'O':	// someone else
+	case 'T':	// someone else stole ours
+		*pState = "held:" + status.reposLockOwner;
+		break;
+	default:	// ' ' or 'B' (ours was broken)
+		*pState = "unlocked";
+		break;
+	}
+}
+
+/*************************************************************************
+                              lcGetLockState
+ *************************************************************************
+
+   SYNOPSIS
+		bool lcGetLockState (const char* path, string* pState, string* pError)
+
+   PURPOSE
+		get the lock state of a path, asking the server only if we
+		haven't asked in the last lcGetTTL() seconds.  The state is
+
+			"unlocked"     nobody has it
+			"mine"         this working copy has it
+			"held:<user>"  someone else has it
+
+		Answers that could not be gotten are not cached, nor are
+		ones that an lcInvalidate raced while the server was asked.
+
+   RETURNS
+		false if the server could not be asked (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool lcGetLockState (const char* path, string* pState, string* pError)
+{
+	lcInit();
+
+	string key = puNormalizePath(path);
+
+	EnterCriticalSection(&s_cs);
+
+	LockMap::const_iterator it = s_entries.find(key);
+	if (it != s_entries.end())
+	{
+		// unsigned math so GetTickCount wrapping is ok
+		if (GetTickCount() - it->second.time < s_ttl * 1000)
+		{
+			++s_hits;
+			*pState = it->second.state;
+			LeaveCriticalSection(&s_cs);
+			return true;
+		}
+		++s_expired;
+	}
+	++s_misses;
+
+	unsigned generation = s_generation;
+
+	LeaveCriticalSection(&s_cs);
+
+	// don't hold our lock while talking to the server
+	string state;
+	if (!s_query(path, false, lcStoreState, &state, pError))
+	{
+		return false;
+	}
+	if (state.empty())
+	{
+		*pError = "no status for path";
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+	// the lock may have changed while we were asking, the answer
+	// is still the best we have but it's not safe to keep
+	if (s_ttl && generation == s_generation)
+	{
+		LockEntry& entry = s_entries[key];
+		entry.state = state;
+		entry.time  = GetTickCount();
+	}
+	LeaveCriticalSection(&s_cs);
+
+	*pState = state;
+	return true;
+}
+
+/*************************************************************************
+                              lcInvalidate
+ *************************************************************************
+
+   SYNOPSIS
+		void lcInvalidate (const char* path)
+
+   PURPOSE
+		forget what we know about path so the next lcGetLockState
+		asks the server.  "" forgets everything.  Safe to call from
+		any thread.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void lcInvalidate (const char* path)
+{
+	lcInit();
+
+	EnterCriticalSection(&s_cs);
+	if (!*path)
+	{
+		s_entries.clear();
+	}
+	else
+	{
+		s_entries.erase(puNormalizePath(path));
+	}
+	++s_generation;
+	++s_invalidations;
+	LeaveCriticalSection(&s_cs);
+}
+
+void lcSetTTL (unsigned seconds)
+{
+	lcInit();
+
+	EnterCriticalSection(&s_cs);
+	s_ttl = seconds;
+	if (!s_ttl)
+	{
+		s_entries.clear();
+	}
+	LeaveCriticalSection(&s_cs);
+}
+
+unsigned lcGetTTL ()
+{
+	return s_ttl;
+}
+
+void lcGetStats (LockCacheStats* pStats)
+{
+	lcInit();
+
+	EnterCriticalSection(&s_cs);
+	pStats->numEntries    = (unsigned)s_entries.size();
+	pStats->hits          = s_hits;
+	pStats->misses        = s_misses;
+	pStats->expired       = s_expired;
+	pStats->invalidations = s_invalidations;
+	pStats->ttl           = s_ttl;
+	LeaveCriticalSection(&s_cs);
+}
+
+// NULL puts scStatus back.  Main thread, while nothing is asking
+void lcSetStatusQuery (StatusQueryFunc query)
+{
+	s_query = query ? query : scStatus;
+}
+
+void lcShutdown ()
+{
+	if (s_csState == 2)
+	{
+		s_entries.clear();
+		DeleteCriticalSection(&s_cs);
+		s_csState = 0;
+	}
+}
+
@@ -0,0 +1,48 @@
+/*=======================================================================*
+ |   file name : lockcache.h
+ |-----------------------------------------------------------------------*
+ |   function  : remember who holds svn locks for a little while
+ *=======================================================================*/
+
+#ifndef LOCKCACHE_H
+#define LOCKCACHE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+#include "svnclient.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+#define LC_DEFAULT_TTL	30	// seconds
+
+/******************************* t y p e s *******************************/
+
+struct LockCacheStats
+{
+	unsigned	numEntries;
+	unsigned	hits;
+	unsigned	misses;		// had to ask the server
+	unsigned	expired;	// misses because the entry was too old
+	unsigned	invalidations;
+	unsigned	ttl;
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool lcGetLockState (const char* path, std::string* pState, std::string* pError);
+extern void lcInvalidate (const char* path);
+extern void lcSetTTL (unsigned seconds);
+extern unsigned lcGetTTL ();
+extern void lcGetStats (LockCacheStats* pStats);
+extern void lcSetStatusQuery (StatusQueryFunc query);
+extern void lcShutdown ();
+
+#endif /* LOCKCACHE_H */
+
@@ -0,0 +1,144 @@
+/*=======================================================================*
+ |   file name : lockcachetest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the cached lock states
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+
+#include <string>
+
+#include "coretest.h"
+#include "lockcache.h"
+#include "pathnorm.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_FILE_A	"c:\\wc\\a.ma"
+#define CT_FILE_B	"c:\\wc\\b.ma"
+#define CT_FILE_C	"c:\\wc\\c.ma"
+#define CT_FILE_D	"c:\\wc\\d.ma"	// svn says nothing about it
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// the state lcGetLockState gives path, or "error:<why>"
+static string lockState (const char* path)
+{
+	string state;
+	string error;
+
+	if (!lcGetLockState(path, &state, &error))
+	{
+		return "error:" + error;
+	}
+	return state;
+}
+
+// how many status queries since the last call
+static size_t takeNumQueries (FakeSvn* pFake)
+{
+	size_t numQueries = pFake->queries.size();
+
+	pFake->queries.clear();
+	return numQueries;
+}
+
+void testLockCache ()
+{
+	FakeSvn			fake;
+	LockCacheStats	before;
+	LockCacheStats	after;
+
+	lcSetStatusQuery(ctInitFakeSvn(&fake));
+	lcSetTTL(LC_DEFAULT_TTL);
+	lcInvalidate("");
+
+	// column 6 of svn status is the lock
+	ctSetFakeStatus(&fake, CT_FILE_A, "     K ", false);
+	ctSetFakeStatus(&fake, CT_FILE_B, "     O ", false);
+	ctSetFakeStatus(&fake, CT_FILE_C, "       ", false);
+	fake.statuses[puNormalizePath(CT_FILE_B)].reposLockOwner = "bob";
+
+	lcGetStats(&before);
+	CHECK(lockState(CT_FILE_A) == "mine");
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(lockState(CT_FILE_C) == "unlocked");
+	CHECK(takeNumQueries(&fake) == 3);
+
+	// asked again inside the TTL the server isn't
+	CHECK(lockState(CT_FILE_A) == "mine");
+	CHECK(lockState("C:/WC/B.MA") == "held:bob");
+	CHECK(takeNumQueries(&fake) == 0);
+	lcGetStats(&after);
+	CHECK(after.hits - before.hits == 2);
+	CHECK(after.misses - before.misses == 3);
+	CHECK(after.numEntries == 3);
+
+	// a lock changing on the server isn't seen until it's invalidated
+	ctSetFakeStatus(&fake, CT_FILE_A, "       ", false);
+	CHECK(lockState(CT_FILE_A) == "mine");
+	lcInvalidate(CT_FILE_A);
+	CHECK(lockState(CT_FILE_A) == "unlocked");
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(takeNumQueries(&fake) == 1);
+
+	// "" forgets everything
+	lcInvalidate("");
+	lcGetStats(&after);
+	CHECK(after.numEntries == 0);
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(lockState(CT_FILE_C) == "unlocked");
+	CHECK(takeNumQueries(&fake) == 2);
+
+	// answers we didn't get aren't kept
+	CHECK(lockState(CT_FILE_D) == "error:no status for path");
+	CHECK(lockState(CT_FILE_D) == "error:no status for path");
+	CHECK(takeNumQueries(&fake) == 2);
+
+	fake.bFail = true;
+	lcInvalidate(CT_FILE_C);
+	CHECK(lockState(CT_FILE_C) == "error:could not reach \"" CT_FILE_C "\"");
+	fake.bFail = false;
+	CHECK(lockState(CT_FILE_C) == "unlocked");
+	CHECK(takeNumQueries(&fake) == 2);
+
+	// no TTL, nothing is kept
+	lcSetTTL(0);
+	lcGetStats(&after);
+	CHECK(after.numEntries == 0);
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(takeNumQueries(&fake) == 2);
+
+	// an entry older than the TTL is asked for again
+	lcSetTTL(1);
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(takeNumQueries(&fake) == 1);
+	lcGetStats(&before);
+	Sleep(1100);
+	CHECK(lockState(CT_FILE_B) == "held:bob");
+	CHECK(takeNumQueries(&fake) == 1);
+	lcGetStats(&after);
+	CHECK(after.expired - before.expired == 1);
+
+	lcSetTTL(LC_DEFAULT_TTL);
+	lcSetStatusQuery(NULL);
+	lcShutdown();
+}
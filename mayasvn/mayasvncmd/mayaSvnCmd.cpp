@@ -15,32 +15,61 @@
 #include <maya/MGlobal.h>
 #include <maya/MFnPlugin.h>
 #include <maya/MSceneMessage.h>
+#include <maya/MEventMessage.h>
+#include <maya/MDGMessage.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MCallbackIdArray.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MItDependencyNodes.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MPlug.h>
 #include <maya/MStringArray.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MIntArray.h>
 
-#include <fcntl.h>
-#include <io.h>
-#include <sys/stat.h>
-#include <sys/types.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include <algorithm>
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
-using std::map;
+using std::set;
 using std::string;
+using std::vector;
 
-// used for case insensitive maps
-struct ltstr
-{
-  bool operator()(const string& s1, const string& s2) const
-  {
-    return _stricmp(s1.c_str(), s2.c_str()) < 0;
-  }
-};
-
+#include "asynclog.h"
+#include "asyncqueue.h"
 #include "dbgprint.h"
+#include "dircache.h"
+#include "eventdispatch.h"
+#include "eventstats.h"
+#include "filecompare.h"
+#include "filecopy.h"
+#include "hashindex.h"
+#include "lockcache.h"
+#include "mayaSvnHandler.h"
+#include "pathutil.h"
+#include "procrun.h"
+#include "seqscan.h"
+#include "statuscache.h"
+#include "svnclient.h"
+#include "syncplan.h"
+#include "texmanifest.h"
+#include "threadpool.h"
+#include "trace.h"
+#include "wcreader.h"
 
 /*************************** c o n s t a n t s ***************************/
 
+#define BENCH_LOOKUPS		100000	// findMsgInfo calls timed by -benchmark
+#define BENCH_ROUNDS		10		// times every event is dispatched by -benchmark
+
 #undef SCENEMSGOP
 #define SCENEMSGS \
 	SCENEMSGOP( 0, kSceneUpdate ,"called after any operation that changes which files are loaded  ")	\
@@ -75,43 +104,88 @@ struct ltstr
 	SCENEMSGOP( 1, kBeforeOpenCheck ,"called prior to File > Open operation, allows user to cancel action  ")	\
 	SCENEMSGOP( 1, kBeforeSaveCheck ,"called prior to File > Save operation, allows user to cancel action ")	\
 
+// events that don't come from MSceneMessage.  These can fire thousands
+// of times a second so the changed nodes are collected and the scripts
+// run once from idle after nothing has changed for debounceMs.  kIdle
+// runs at most once every debounceMs.
+#undef OTHERMSGOP
+#define OTHERMSGS \
+	OTHERMSGOP( MSGFAMILY_NODE_ADDED, kNodeAdded, 250, "called from idle with the nodes created since the last call  ")	\
+	OTHERMSGOP( MSGFAMILY_NODE_REMOVED, kNodeRemoved, 250, "called from idle with the nodes deleted since the last call  ")	\
+	OTHERMSGOP( MSGFAMILY_FILE_TEXTURE, kFileTextureChanged, 250, "called from idle with the file nodes created, deleted or given a new texture  ")	\
+	OTHERMSGOP( MSGFAMILY_IDLE, kIdle, 1000, "called when Maya is idle, at most once per debounce window  ")	\
+
+// number of entries in SCENEMSGS and OTHERMSGS
+#undef SCENEMSGOP
+#define SCENEMSGOP(check, msg, desc)	+ 1
+#undef OTHERMSGOP
+#define OTHERMSGOP(family, msg, debounceMs, desc)	+ 1
+enum { kNumSceneMsgs = 0 SCENEMSGS };
+enum { kNumMsgs = kNumSceneMsgs OTHERMSGS };
+
 /******************************* t y p e s *******************************/
 
 typedef void (*MayaCallback)(void* clientData);
 typedef void (*MayaCheckCallback)(bool* retCode, void* clientData);
 
-struct MelInfo
+// which Maya API an event comes from
+enum MsgFamily
 {
-	MString	_melScript;
-	bool	_bDisplayEnabled;
-	bool	_bUndoEnabled;
+	MSGFAMILY_SCENE,			// MSceneMessage
+	MSGFAMILY_NODE_ADDED,		// MDGMessage::addNodeAddedCallback
+	MSGFAMILY_NODE_REMOVED,		// MDGMessage::addNodeRemovedCallback
+	MSGFAMILY_FILE_TEXTURE,		// MNodeMessage attribute changes on file nodes
+	MSGFAMILY_IDLE				// MEventMessage "idle"
+};
 
-	MelInfo(const MString& melScript, bool bDisplayEnabled, bool bUndoEnabled)
-	: _melScript(melScript)
-	, _bDisplayEnabled(bDisplayEnabled)
-	, _bUndoEnabled(bUndoEnabled)
-	{ }
+// compile time helpers so the message tables size themselves from SCENEMSGS
+template <unsigned N, unsigned P, bool bDone = (P >= N)>
+struct NextPow2Helper
+{
+	enum { value = NextPow2Helper<N, P * 2>::value };
+};
 
-	MelInfo()
-	{ }
+template <unsigned N, unsigned P>
+struct NextPow2Helper<N, P, true>
+{
+	enum { value = P };
+};
 
-	MelInfo(const MelInfo& rhs)
-		: _melScript(rhs._melScript)
-		, _bDisplayEnabled(rhs._bDisplayEnabled)
-		, _bUndoEnabled(rhs._bDisplayEnabled)
-	{ }
+template <unsigned N>
+struct NextPow2
+{
+	enum { value = NextPow2Helper<N, 1>::value };
+};
 
-	MelInfo& MelInfo::operator=(const MelInfo& rhs)
-	{
-		_melScript       = rhs._melScript;
-		_bDisplayEnabled = rhs._bDisplayEnabled;
-		_bUndoEnabled    = rhs._bDisplayEnabled;
+template <int A, int B>
+struct StaticMax
+{
+	enum { value = A > B ? A : B };
+};
 
-		return *this;
-	}
+// largest MSceneMessage::Message in SCENEMSGS
+// StaticMax<kSceneUpdate, StaticMax<kBeforeNew, ... -1 >::value >::value
+#undef SCENEMSGOP
+#define SCENEMSGOP(check, msg, desc)	StaticMax<MSceneMessage::msg,
+enum { kMaxSceneMsg = SCENEMSGS -1
+#undef SCENEMSGOP
+#define SCENEMSGOP(check, msg, desc)	>::value
+	SCENEMSGS };
+
+// 4 slots per message so a collision free seed turns up in a few tries
+#define MSG_HASH_SIZE	NextPow2<kNumMsgs * 4>::value
+
+// the tables below store index + 1 in a byte, 0 = empty
+typedef char MsgIndexFitsInByte[kNumMsgs < 255 ? 1 : -1];
+
+// the attribute callback on one file node
+struct FileNodeWatch
+{
+	MObjectHandle	node;
+	MCallbackId		callbackId;
 };
 
-typedef map<string, MelInfo, ltstr> MelMap;
+typedef std::multimap<unsigned, FileNodeWatch> FileWatchMap;	// by MObjectHandle::hashCode
 
 class mayaSvn : public MPxCommand
 {
@@ -121,9 +195,25 @@ class mayaSvn : public MPxCommand
 		bool					bCheck;
 		const char*				pLabel;
 		const char*				pDesc;
+		MsgFamily				family;
+		unsigned				debounceMs;	// not used for MSGFAMILY_SCENE
 		MCallbackId				callbackId;
 		bool					bInstalled; // since we don't know what a valid callbackId is
-		MelMap					melScripts;
+		EventScriptList			melScripts;
+		EventStats				stats;		// all the scripts for one event together
+		MCallbackIdArray		nodeCallbacks;	// more callbacks for MSGFAMILY_FILE_TEXTURE
+		FileWatchMap			fileWatches;	// one per file node for MSGFAMILY_FILE_TEXTURE
+		set<string>				pendingNodes;	// changed since the scripts last ran
+		DWORD					lastChange;		// GetTickCount
+		DWORD					lastDelivered;
+	};
+
+	// what the C++ handlers get, see fillHandlerContext
+	struct HandlerContext
+	{
+		const MsgInfo*			pMsgInfo;
+		MString					filename;
+		vector<const char*>		nodes;
 	};
 
 	static MsgInfo msgInfos[];
@@ -138,23 +228,80 @@ public:
 	static void		callbackStub(void* clientdata);
 	static void		callbackCheckStub(bool* retCode, void* clientdata);
 
-	static void		handleCallback(const MsgInfo& msgInfo);
-	static bool		handleCheckCallback(const MsgInfo& msgInfo);
+	static void		handleCallback(MsgInfo& msgInfo);
+	static bool		handleCheckCallback(MsgInfo& msgInfo);
+	static bool		runHandlers(MsgInfo& mi);
+	static bool		runMelScript(const EventScript& script, bool bCheck, void* pContext);
+	static void		fillHandlerContext(MayaSvnEventContext* pCtx, void* pContext);
+	static MString	eventFilename(const MsgInfo& mi);
+	static void		recordEvent(const MsgInfo& mi);
+
+	static void		nodeCallback(MObject& node, void* clientdata);
+	static void		fileNodeAddedCallback(MObject& node, void* clientdata);
+	static void		fileNodeRemovedCallback(MObject& node, void* clientdata);
+	static void		fileSceneClearedCallback(void* clientdata);
+	static void		fileAttrCallback(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientdata);
+	static void		idleEventCallback(void* clientdata);
+	static void		pendingIdleCallback(void* clientdata);
+	static void		queueNode(MsgInfo& mi, const MObject& node);
+	static void		deliverPending();
+	static MStatus	watchFileNode(MsgInfo& mi, MObject& node);
+	static void		unwatchFileNode(MsgInfo& mi, MObject& node);
+	static void		unwatchAllFileNodes(MsgInfo& mi);
 
 	static const char*	msgDescription(MSceneMessage::Message msg);
 	static const char*	msgLabel(MSceneMessage::Message msg);
 	static MsgInfo*		findMsgInfo(MSceneMessage::Message msg);
 	static MsgInfo*		findMsgInfo(const MString& eventLabel);
+	static void			buildMsgTables();
 
 	static void			listEvents(MStringArray& events);
 	static bool			listScripts(const MString& eventLabel, MStringArray& scripts);
 	static void			listAllScripts(MStringArray& scripts);
-	static bool			addEventScript(const MString& eventLabel, const MString& scriptName, const MString& melScript, bool bDisplayEnabled, bool bUndoEnabled);
+	static bool			addEventScript(const MString& eventLabel, const MString& scriptName, const MString& melScript, int priority, int debounceMs, bool bDisplayEnabled, bool bUndoEnabled);
 	static bool			delEventScript(const MString& eventLabel, const MString& scriptName);
+	static bool			addEventHandler(const MString& eventLabel, const MString& name, MayaSvnHandler pHandler, void* pUserData, int priority);
+	static bool			saveRegistry(const MString& filename);
+	static bool			loadRegistry(const MString& filename);
 	static bool			getFilename(const MString& nameType, MString& filename);
-	static bool			compareFiles(const MString& file1, const MString& file2);
+	static bool			compareFiles(const MString& file1, const MString& file2, FileCompareResult* pResult = NULL);
+	static void			compareFileList(const MStringArray& files1, const MStringArray& files2, MIntArray& results);
+	static bool			hashFile(const MString& filename, MString& hash);
+	static void			indexStats(MStringArray& stats);
+	static bool			wcInfo(const MString& path, MStringArray& info);
+	static bool			wcStatus(const MString& path, MString& status);
+	static bool			svnRun(const MString& subcommand, const MStringArray& paths, const MString& message, MStringArray& results);
+	static bool			lockPaths(const MStringArray& paths, const MString& comment, bool bLock, MStringArray& outcomes);
+	static bool			lockOwners(const MStringArray& paths, MStringArray& owners);
+	static void			cachedStatus(const MString& path, MStringArray& info);
+	static bool			findSequence(const MString& path, bool bFrameInfo, MStringArray& results);
+	static void			listTextures(bool bCountOnly, MStringArray& results);
+	static bool			watchRoots(const MStringArray& paths, MStringArray& roots);
+	static bool			listDir(const MString& path, MStringArray& names);
+	static void			fileExists(const MStringArray& paths, MIntArray& results);
+	static void			dirCacheStats(MStringArray& stats);
+	static bool			planSync(const MString& srcDir, const MString& dstDir, const MStringArray& exclusions, MStringArray& results);
+	static bool			copyFiles(const MStringArray& srcs, const MStringArray& dsts, MStringArray& results);
+	static void			statusCacheStats(MStringArray& stats);
+	static void			lockStates(const MStringArray& paths, MStringArray& states);
+	static void			lockCacheStats(MStringArray& stats);
+	static void			eventStats(MStringArray& stats);
+	static void			resetEventStats();
+	static bool			recordEvents(const MString& filename);
+	static bool			replayEvents(const MString& filename, MStringArray& results);
+	static void			benchmark(int scriptsPerEvent, MStringArray& results);
+	static void			execCommands(const MStringArray& cmdLines, unsigned timeoutMs, MStringArray& results);
+	static int			svnRunAsync(const MString& subcommand, const MStringArray& paths, const MString& message, const MString& callback);
+	static void			deliverJobs();
+	static void			asyncIdleCallback(void* clientdata);
+	static void			asyncExitCallback(void* clientdata);
+	static bool			drainJobs();
 	static MString		doFileSaveDialog(const MString& title, const MString& filter, const MString& defExt, const MString& filename);
 
+	static bool		needsCallback(const MsgInfo& mi);
+	static MStatus	installCallback(MsgInfo& mi);
+	static void		removeCallback(MsgInfo& mi);
+	static MStatus	updateCallback(MsgInfo& mi);
 	static MStatus	install();
 	static MStatus	remove();
 };
@@ -166,6 +313,26 @@ public:
 
 bool g_bDebug;
 
+static MCallbackId	s_idleCallbackId;
+static bool			s_bIdleInstalled;	// only while async jobs are outstanding
+static MCallbackId	s_exitCallbackId;
+static bool			s_bExitInstalled;
+static MCallbackId	s_pendingCallbackId;
+static bool			s_bPendingInstalled;	// only while node changes are waiting
+static MStringArray	s_deliveringNodes;		// -getNodes while scripts run
+static FILE*		s_recordFp;				// -recordEvents
+static __int64		s_recordStart;
+static bool			s_bDryRun;				// dispatch everything but don't run the scripts
+static bool			s_bReplaying;
+static MString		s_replayFilename;		// what -getFilename says while replaying
+static int			s_textureChanges;		// -textureChanges, bumped as soon as a file node changes
+
+static bool				s_bMsgTablesBuilt;
+static bool				s_bMsgHashOk;		// false = no seed worked, scan instead
+static unsigned			s_msgHashSeed;
+static unsigned char	s_msgByHash[MSG_HASH_SIZE];	// index + 1 into msgInfos by label
+static unsigned char	s_msgByEnum[kMaxSceneMsg + 1];	// index + 1 into msgInfos by msg
+
 /****************************** m a c r o s ******************************/
 
 #define NUM_TABLE_ELEMENTS(table)	(sizeof(table)/sizeof((table)[0]))
@@ -175,25 +342,107 @@ bool g_bDebug;
 mayaSvn::MsgInfo mayaSvn::msgInfos[] =
 {
 	#undef SCENEMSGOP
-	#define SCENEMSGOP(check, msg,desc)	{ MSceneMessage::msg, check, #msg, desc, },
+	#define SCENEMSGOP(check, msg,desc)	{ MSceneMessage::msg, check, #msg, desc, MSGFAMILY_SCENE, 0, },
 	SCENEMSGS
+	#undef OTHERMSGOP
+	#define OTHERMSGOP(family, msg, debounceMs, desc)	{ MSceneMessage::kLast, 0, #msg, desc, family, debounceMs, },
+	OTHERMSGS
 };
 
-mayaSvn::MsgInfo* mayaSvn::findMsgInfo(MSceneMessage::Message msg)
+// case insensitive FNV-1a
+static unsigned msgHash(const char* pLabel, unsigned seed)
+{
+	unsigned hash = 2166136261u ^ seed;
+
+	for (; *pLabel; ++pLabel)
+	{
+		hash ^= (unsigned char)tolower((unsigned char)*pLabel);
+		hash *= 16777619u;
+	}
+	return hash & (MSG_HASH_SIZE - 1);
+}
+
+/*************************************************************************
+                              buildMsgTables
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::buildMsgTables ()
+
+   PURPOSE
+		fill in the tables findMsgInfo uses.  The sizes come from
+		SCENEMSGS and OTHERMSGS at compile time.  The label table is a perfect hash,
+		we try seeds until every label lands in its own slot so a
+		lookup is one hash and one compare.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::buildMsgTables()
 {
+	if (s_bMsgTablesBuilt)
+	{
+		return;
+	}
+	s_bMsgTablesBuilt = true;
+
 	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
 	{
-		if (msgInfos[ii].msg == msg)
+		if (msgInfos[ii].family == MSGFAMILY_SCENE)
 		{
-			return &msgInfos[ii];
+			s_msgByEnum[msgInfos[ii].msg] = (unsigned char)(ii + 1);
+		}
+	}
+
+	for (unsigned seed = 0; seed < 0x10000; ++seed)
+	{
+		int ii;
+
+		memset(s_msgByHash, 0, sizeof(s_msgByHash));
+		for (ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+		{
+			unsigned char& slot = s_msgByHash[msgHash(msgInfos[ii].pLabel + 1, seed)];
+			if (slot)
+			{
+				break;
+			}
+			slot = (unsigned char)(ii + 1);
+		}
+		if (ii == NUM_TABLE_ELEMENTS(msgInfos))
+		{
+			s_msgHashSeed = seed;
+			s_bMsgHashOk  = true;
+			dbgPrintf ("message hash seed %u, %d slots\n", seed, MSG_HASH_SIZE);
+			return;
 		}
 	}
+	errPrintf ("no perfect hash for event labels, using a linear search\n");
+}
+
+mayaSvn::MsgInfo* mayaSvn::findMsgInfo(MSceneMessage::Message msg)
+{
+	buildMsgTables();
 
+	if ((unsigned)msg <= (unsigned)kMaxSceneMsg && s_msgByEnum[msg])
+	{
+		return &msgInfos[s_msgByEnum[msg] - 1];
+	}
 	return NULL;
 }
 
 mayaSvn::MsgInfo* mayaSvn::findMsgInfo(const MString& eventLabel)
 {
+	buildMsgTables();
+
+	if (s_bMsgHashOk)
+	{
+		int index = s_msgByHash[msgHash(eventLabel.asChar(), s_msgHashSeed)];
+		if (index && !_stricmp(msgInfos[index - 1].pLabel + 1, eventLabel.asChar()))
+		{
+			return &msgInfos[index - 1];
+		}
+		return NULL;
+	}
+
 	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
 	{
 		if (!_stricmp(msgInfos[ii].pLabel + 1, eventLabel.asChar()))
@@ -234,37 +483,321 @@ void mayaSvn::callbackCheckStub(bool* retCode, void* clientdata)
 	*retCode = handleCheckCallback(*(MsgInfo*)clientdata);
 }
 
-void mayaSvn::handleCallback(const MsgInfo& mi)
+void mayaSvn::handleCallback(MsgInfo& mi)
 {
-	dbgPrintf ("executing scripts for event \"%s\"\n", mi.pLabel + 1);
-	for (MelMap::const_iterator it = mi.melScripts.begin(); it != mi.melScripts.end(); ++it)
+	TraceSpan span("callback", mi.pLabel + 1);
+
+	if (s_recordFp)
 	{
-		const MelInfo& mel = it->second;
-		dbgPrintf ("executing script \"%s\" for event \"%s\"\n", it->first.c_str(), mi.pLabel + 1);
-		dbgPrintf ("%s\n", mel._melScript.asChar());
-		MGlobal::executeCommand(mel._melScript, mel._bDisplayEnabled, mel._bUndoEnabled);
+		recordEvent(mi);
 	}
-	fflush(stdout);
+	runHandlers(mi);
+}
+
+bool mayaSvn::handleCheckCallback(MsgInfo& mi)
+{
+	TraceSpan span("callback", mi.pLabel + 1);
+
+	if (s_recordFp)
+	{
+		recordEvent(mi);
+	}
+
+	bool bOk = runHandlers(mi);
+
+	span.setArg("result", bOk ? "ok" : "cancelled");
+	return bOk;
+}
+
+MString mayaSvn::eventFilename(const MsgInfo& mi)
+{
+	if (s_bReplaying)
+	{
+		return s_replayFilename;
+	}
+
+	// the Before* filenames are only right during their event
+	switch (mi.family == MSGFAMILY_SCENE ? mi.msg : MSceneMessage::kLast)
+	{
+	case MSceneMessage::kBeforeOpen:
+	case MSceneMessage::kBeforeOpenCheck:
+		return MFileIO::beforeOpenFilename();
+	case MSceneMessage::kBeforeSave:
+	case MSceneMessage::kBeforeSaveCheck:
+		return MFileIO::beforeSaveFilename();
+	case MSceneMessage::kBeforeImport:
+		return MFileIO::beforeImportFilename();
+	case MSceneMessage::kBeforeExport:
+		return MFileIO::beforeExportFilename();
+	case MSceneMessage::kBeforeReference:
+		return MFileIO::beforeReferenceFilename();
+	default:
+		return MFileIO::currentFile();
+	}
+}
+
+// EventExecutor::fillContext
+void mayaSvn::fillHandlerContext(MayaSvnEventContext* pCtx, void* pContext)
+{
+	HandlerContext& hc = *(HandlerContext*)pContext;
+
+	hc.filename = eventFilename(*hc.pMsgInfo);
+
+	for (unsigned ii = 0; ii < s_deliveringNodes.length(); ++ii)
+	{
+		hc.nodes.push_back(s_deliveringNodes[ii].asChar());
+	}
+
+	pCtx->pFilename = hc.filename.asChar();
+	pCtx->ppNodes   = hc.nodes.empty() ? NULL : &hc.nodes[0];
+	pCtx->numNodes  = (unsigned)hc.nodes.size();
 }
 
-bool mayaSvn::handleCheckCallback(const MsgInfo& mi)
+// EventExecutor::runMel
+bool mayaSvn::runMelScript(const EventScript& script, bool bCheck, void* pContext)
 {
-	dbgPrintf ("executing check scripts for event \"%s\"\n", mi.pLabel + 1);
-	for (MelMap::const_iterator it = mi.melScripts.begin(); it != mi.melScripts.end(); ++it)
+	MString mel(script._melScript.c_str());
+
+	if (bCheck)
 	{
-		const MelInfo& mel = it->second;
 		int result;
-		dbgPrintf ("executing script \"%s\" for event \"%s\"\n", it->first.c_str(), mi.pLabel + 1);
-		dbgPrintf ("%s\n", mel._melScript.asChar());
-		MGlobal::executeCommand(mel._melScript, result, mel._bDisplayEnabled, mel._bUndoEnabled);
-		if (!result)
+		MGlobal::executeCommand(mel, result, script._bDisplayEnabled, script._bUndoEnabled);
+		return result != 0;
+	}
+	MGlobal::executeCommand(mel, script._bDisplayEnabled, script._bUndoEnabled);
+	return true;
+}
+
+/*************************************************************************
+                              runHandlers
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::runHandlers (MsgInfo& mi)
+
+   PURPOSE
+		run the MEL scripts and C++ handlers for an event through
+		edRunScripts, which doesn't know about Maya.  MEL goes to
+		MGlobal, the C++ handlers see eventFilename and the nodes
+		being delivered.
+
+   RETURNS
+		false if a check event should be cancelled
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::runHandlers(MsgInfo& mi)
+{
+	EventExecutor	exec;
+	HandlerContext	hc;
+
+	hc.pMsgInfo      = &mi;
+	exec.runMel      = runMelScript;
+	exec.fillContext = fillHandlerContext;
+	exec.pContext    = &hc;
+	exec.bDryRun     = s_bDryRun;
+
+	return edRunScripts(mi.pLabel + 1, mi.bCheck, &mi.melScripts, &mi.stats, exec);
+}
+
+void mayaSvn::nodeCallback(MObject& node, void* clientdata)
+{
+	queueNode(*(MsgInfo*)clientdata, node);
+}
+
+void mayaSvn::fileNodeAddedCallback(MObject& node, void* clientdata)
+{
+	MsgInfo& mi = *(MsgInfo*)clientdata;
+
+	++s_textureChanges;
+	watchFileNode(mi, node);
+	queueNode(mi, node);
+}
+
+void mayaSvn::fileNodeRemovedCallback(MObject& node, void* clientdata)
+{
+	MsgInfo& mi = *(MsgInfo*)clientdata;
+
+	++s_textureChanges;
+	unwatchFileNode(mi, node);
+	queueNode(mi, node);
+}
+
+// not every node of the old scene says it's going away
+void mayaSvn::fileSceneClearedCallback(void* clientdata)
+{
+	++s_textureChanges;
+	unwatchAllFileNodes(*(MsgInfo*)clientdata);
+}
+
+void mayaSvn::fileAttrCallback(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientdata)
+{
+	if (msg & MNodeMessage::kAttributeSet)
+	{
+		MString name = plug.partialName(false, false, false, false, false, true);
+
+		// the two things that change which textures a file node uses
+		if (name == "fileTextureName" || name == "useFrameExtension")
 		{
-			fflush(stdout);
-			return false;
+			++s_textureChanges;
+			queueNode(*(MsgInfo*)clientdata, plug.node());
 		}
 	}
-	fflush(stdout);
-	return true;
+}
+
+static FileWatchMap::iterator findFileWatch(FileWatchMap& watches, const MObjectHandle& handle)
+{
+	unsigned hash = handle.hashCode();
+
+	for (FileWatchMap::iterator it = watches.lower_bound(hash); it != watches.end() && it->first == hash; ++it)
+	{
+		if (it->second.node == handle)
+		{
+			return it;
+		}
+	}
+	return watches.end();
+}
+
+MStatus mayaSvn::watchFileNode(MsgInfo& mi, MObject& node)
+{
+	MStatus			stat;
+	MObjectHandle	handle(node);
+
+	// undoing a delete adds the same node again
+	if (findFileWatch(mi.fileWatches, handle) != mi.fileWatches.end())
+	{
+		return stat;
+	}
+
+	MCallbackId id = MNodeMessage::addAttributeChangedCallback(node, fileAttrCallback, &mi, &stat);
+	if (!stat)
+	{
+		errPrintf ("could not watch file node \"%s\"\n", MFnDependencyNode(node).name().asChar());
+		return stat;
+	}
+
+	FileNodeWatch watch;
+
+	watch.node       = handle;
+	watch.callbackId = id;
+	mi.fileWatches.insert(std::make_pair(handle.hashCode(), watch));
+	return stat;
+}
+
+void mayaSvn::unwatchFileNode(MsgInfo& mi, MObject& node)
+{
+	FileWatchMap::iterator it = findFileWatch(mi.fileWatches, MObjectHandle(node));
+
+	if (it != mi.fileWatches.end())
+	{
+		MMessage::removeCallback(it->second.callbackId);
+		mi.fileWatches.erase(it);
+	}
+}
+
+void mayaSvn::unwatchAllFileNodes(MsgInfo& mi)
+{
+	for (FileWatchMap::iterator it = mi.fileWatches.begin(); it != mi.fileWatches.end(); ++it)
+	{
+		MMessage::removeCallback(it->second.callbackId);
+	}
+	mi.fileWatches.clear();
+}
+
+void mayaSvn::idleEventCallback(void* clientdata)
+{
+	MsgInfo& mi = *(MsgInfo*)clientdata;
+	DWORD    now = GetTickCount();
+
+	if (now - mi.lastDelivered >= mi.debounceMs)
+	{
+		mi.lastDelivered = now;
+		handleCallback(mi);
+	}
+}
+
+/*************************************************************************
+                              queueNode
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::queueNode (MsgInfo& mi, const MObject& node)
+
+   PURPOSE
+		remember that node changed.  Nothing runs now, the scripts for
+		the event run once from idle with all the nodes that changed.
+		Each change pushes the delivery back another debounceMs so an
+		import that makes 10000 nodes runs the scripts once.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::queueNode(MsgInfo& mi, const MObject& node)
+{
+	mi.pendingNodes.insert(MFnDependencyNode(node).name().asChar());
+	mi.lastChange = GetTickCount();
+
+	// like the async jobs we only sit on idle while there's something to do
+	if (!s_bPendingInstalled)
+	{
+		MStatus stat;
+
+		s_pendingCallbackId = MEventMessage::addEventCallback("idle", pendingIdleCallback, NULL, &stat);
+		if (stat)
+		{
+			s_bPendingInstalled = true;
+		}
+		else
+		{
+			errPrintf ("could not install idle callback, node changes will not be delivered\n");
+		}
+	}
+}
+
+void mayaSvn::deliverPending()
+{
+	DWORD now = GetTickCount();
+
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		MsgInfo& mi = msgInfos[ii];
+
+		if (mi.pendingNodes.empty() || now - mi.lastChange < mi.debounceMs)
+		{
+			continue;
+		}
+
+		// the scripts get them with -getNodes
+		s_deliveringNodes.clear();
+		for (set<string>::const_iterator it = mi.pendingNodes.begin(); it != mi.pendingNodes.end(); ++it)
+		{
+			s_deliveringNodes.append(it->c_str());
+		}
+		mi.pendingNodes.clear();
+		mi.lastDelivered = now;
+
+		dbgPrintf ("delivering %u nodes for event \"%s\"\n", s_deliveringNodes.length(), mi.pLabel + 1);
+		handleCallback(mi);
+		s_deliveringNodes.clear();
+	}
+}
+
+void mayaSvn::pendingIdleCallback(void* clientdata)
+{
+	deliverPending();
+
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		if (!msgInfos[ii].pendingNodes.empty())
+		{
+			return;
+		}
+	}
+	if (s_bPendingInstalled)
+	{
+		MMessage::removeCallback(s_pendingCallbackId);
+		s_bPendingInstalled = false;
+	}
 }
 
 void mayaSvn::listEvents(MStringArray& events)
@@ -325,11 +858,11 @@ bool mayaSvn::listScripts(const MString& eventLabel, MStringArray& scripts)
 		return false;
 	}
 
-	for (MelMap::const_iterator it = pInfo->melScripts.begin(); it != pInfo->melScripts.end(); ++it)
+	for (size_t ii = 0; ii < pInfo->melScripts.size(); ++ii)
 	{
-		const MelInfo& mel = it->second;
+		const EventScript& mel = pInfo->melScripts[ii];
 
-		scripts.append(MString("\"") + MString(it->first.c_str()) + "\" \"" + escape(mel._melScript) + "\"\n");
+		scripts.append(MString("\"") + MString(mel._name.c_str()) + "\" \"" + (mel._pHandler ? MString("<native>") : escape(mel._melScript.c_str())) + "\"\n");
 	}
 
 	return true;
@@ -341,11 +874,11 @@ void mayaSvn::listAllScripts(MStringArray& scripts)
 	{
 		MsgInfo& mi = msgInfos[ii];
 
-		for (MelMap::const_iterator it = mi.melScripts.begin(); it != mi.melScripts.end(); ++it)
+		for (size_t jj = 0; jj < mi.melScripts.size(); ++jj)
 		{
-			const MelInfo& mel = it->second;
+			const EventScript& mel = mi.melScripts[jj];
 
-			scripts.append(MString("\"") + (mi.pLabel + 1) + "\" \"" + MString(it->first.c_str()) + "\" \"" + escape(MString(mel._melScript)) + "\"\n");
+			scripts.append(MString("\"") + (mi.pLabel + 1) + "\" \"" + MString(mel._name.c_str()) + "\" \"" + (mel._pHandler ? MString("<native>") : escape(mel._melScript.c_str())) + "\"\n");
 		}
 	}
 }
@@ -354,6 +887,13 @@ bool mayaSvn::getFilename(const MString& nameType, MString& filename)
 {
 	MStatus stat;
 
+	// replayed scripts see the filename that was recorded
+	if (s_bReplaying && !_strnicmp(nameType.asChar(), "before", 6))
+	{
+		filename = s_replayFilename;
+		return true;
+	}
+
 	#undef NAMEOP
 	#define NAMETYPES	\
 		NAMEOP(beforeOpenFilename)	\
@@ -383,7 +923,7 @@ bool mayaSvn::getFilename(const MString& nameType, MString& filename)
 	return false;
 }
 
-bool mayaSvn::addEventScript(const MString& eventLabel, const MString& scriptName, const MString& melScript, bool bDisplayEnabled, bool bUndoEnabled)
+bool mayaSvn::addEventScript(const MString& eventLabel, const MString& scriptName, const MString& melScript, int priority, int debounceMs, bool bDisplayEnabled, bool bUndoEnabled)
 {
 	MsgInfo* pInfo = findMsgInfo(eventLabel);
 	if (!pInfo)
@@ -392,9 +932,33 @@ bool mayaSvn::addEventScript(const MString& eventLabel, const MString& scriptNam
 		return false;
 	}
 
-	pInfo->melScripts[scriptName.asChar()] = MelInfo(melScript, bDisplayEnabled, bUndoEnabled);
+	// -1 = leave it alone.  Shared by every script on the event
+	if (debounceMs >= 0)
+	{
+		pInfo->debounceMs = (unsigned)debounceMs;
+	}
+
+	// same name replaces, like it always has
+	edAddScript(&pInfo->melScripts, EventScript(scriptName.asChar(), melScript.asChar(), priority, bDisplayEnabled, bUndoEnabled));
 	dbgPrintf ("script \"%s\" added to event \"%s\"\n", scriptName.asChar(), eventLabel.asChar());
-	return true;
+
+	// first script for this event?
+	return updateCallback(*pInfo) == MS::kSuccess;
+}
+
+bool mayaSvn::addEventHandler(const MString& eventLabel, const MString& name, MayaSvnHandler pHandler, void* pUserData, int priority)
+{
+	MsgInfo* pInfo = findMsgInfo(eventLabel);
+	if (!pInfo)
+	{
+		errPrintf ("unknown event \"%s\"\n", eventLabel.asChar());
+		return false;
+	}
+
+	edAddScript(&pInfo->melScripts, EventScript(name.asChar(), pHandler, pUserData, priority));
+	dbgPrintf ("handler \"%s\" added to event \"%s\"\n", name.asChar(), eventLabel.asChar());
+
+	return updateCallback(*pInfo) == MS::kSuccess;
 }
 
 bool mayaSvn::delEventScript(const MString& eventLabel, const MString& scriptName)
@@ -406,356 +970,2541 @@ bool mayaSvn::delEventScript(const MString& eventLabel, const MString& scriptNam
 		return false;
 	}
 
-	MelMap::iterator it = pInfo->melScripts.find(scriptName.asChar());
-	if (it == pInfo->melScripts.end())
+	if (!edRemoveScript(&pInfo->melScripts, scriptName.asChar()))
 	{
 		warnPrintf ("no script \"%s\" attached to event \"%s\"\n", scriptName.asChar(), eventLabel.asChar());
 		return true;
 	}
 
-	pInfo->melScripts.erase(it);
 	dbgPrintf ("script \"%s\" deleted from event \"%s\"\n", scriptName.asChar(), eventLabel.asChar());
-	return true;
+
+	// last script for this event?
+	return updateCallback(*pInfo) == MS::kSuccess;
 }
 
-bool mayaSvn::compareFiles(const MString& file1, const MString& file2)
-{
-	static char buffer1[16386];
-	static char buffer2[16386];
-	bool result = false;
-	int fh1 = -1;
-	int fh2 = -1;
+/*************************************************************************
+                              saveRegistry
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::saveRegistry (const MString& filename)
+
+   PURPOSE
+		write every script attached to every event so -loadRegistry
+		can put them all back with one file read instead of one
+		-addEvent per script.
+
+		header:  magic, version, number of events, number of scripts
+		event:   event (a length + chars), debounceMs
+		script:  event, name, mel (each a length + chars),
+		         priority, flags
+
+		debounceMs belongs to the event, not its scripts, so it's
+		written once for each event that has scripts.
+
+		Writes to a temp file and renames it like the hash index.
+
+   RETURNS
+		false if the file could not be written
 
-	fh1 = _open(file1.asChar(), O_RDONLY | O_BINARY, S_IREAD);
-	if (fh1 < 0) goto cleanup;
-	fh2 = _open(file2.asChar(), O_RDONLY | O_BINARY, S_IREAD);
-	if (fh2 < 0) goto cleanup;
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-	long size1 = _filelength (fh1);
-	long size2 = _filelength (fh2);
+bool mayaSvn::saveRegistry(const MString& filename)
+{
+	vector<RegEvent>	events;
+	vector<RegScript>	scripts;
 
-	if (size1 == size2)
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
 	{
-		while (size1 > 0)
-		{
-			long sizeToRead = size1 > sizeof(buffer1) ? sizeof(buffer1) : size1;
+		const MsgInfo&	mi = msgInfos[ii];
+		size_t			numScripts = scripts.size();
 
-			_read(fh1, buffer1, sizeToRead);
-			_read(fh2, buffer2, sizeToRead);
+		for (size_t jj = 0; jj < mi.melScripts.size(); ++jj)
+		{
+			const EventScript&	mel = mi.melScripts[jj];
+			RegScript			rs;
 
-			if (memcmp(buffer1, buffer2, sizeToRead))
+			// C++ handlers add themselves
+			if (mel._pHandler)
 			{
-				goto cleanup;
+				continue;
 			}
 
-			size1 -= sizeToRead;
+			rs.event     = mi.pLabel + 1;
+			rs.name      = mel._name;
+			rs.mel       = mel._melScript;
+			rs.values[0] = mel._priority;
+			rs.values[1] = (mel._bDisplayEnabled ? REG_DISPLAY_ENABLED : 0) |
+						   (mel._bUndoEnabled    ? REG_UNDO_ENABLED    : 0);
+			scripts.push_back(rs);
 		}
 
-		result = true;
+		if (scripts.size() > numScripts)
+		{
+			RegEvent re;
+
+			re.event      = mi.pLabel + 1;
+			re.debounceMs = (int)mi.debounceMs;
+			events.push_back(re);
+		}
 	}
 
-cleanup:
-	if (fh2 >= 0) _close(fh2);
-	if (fh1 >= 0) _close(fh1);
+	if (!edWriteRegistry(filename.asChar(), events, scripts))
+	{
+		errPrintf ("could not write \"%s\"\n", filename.asChar());
+		return false;
+	}
 
-	return result;
+	dbgPrintf ("saved %u scripts to \"%s\"\n", (unsigned)scripts.size(), filename.asChar());
+	return true;
 }
 
-MString mayaSvn::doFileSaveDialog(const MString& title, const MString& filter, const MString& defExt, const MString& filename)
+/*************************************************************************
+                              loadRegistry
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::loadRegistry (const MString& filename)
+
+   PURPOSE
+		add the scripts saved by -saveRegistry.  Scripts with the same
+		name on the same event are replaced, others are left alone.
+		The whole file is read before anything is added so a bad file
+		changes nothing.
+
+   RETURNS
+		false if the file could not be read or is not a registry
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::loadRegistry(const MString& filename)
 {
-	static OPENFILENAME ofn;
-	static char  filenameBuffer[MAX_PATH];
-	static char  filterBuffer[1024];
+	vector<RegEvent>	events;
+	vector<RegScript>	scripts;
 
-	// setup filter (assume | for separator
-	if (filter.length() > 0)
+	if (!edReadRegistry(filename.asChar(), &events, &scripts))
 	{
-		char* d      = filterBuffer;
+		errPrintf ("could not read \"%s\", or it's not a mayaSvn registry\n", filename.asChar());
+		return false;
+	}
+
+	for (size_t ii = 0; ii < events.size(); ++ii)
+	{
+		MsgInfo* pInfo = findMsgInfo(events[ii].event.c_str());
+
+		// an unknown event's scripts say so below
+		if (pInfo && events[ii].debounceMs >= 0)
+		{
+			pInfo->debounceMs = (unsigned)events[ii].debounceMs;
+		}
+	}
+
+	for (size_t ii = 0; ii < scripts.size(); ++ii)
+	{
+		const RegScript& rs = scripts[ii];
+
+		if (!addEventScript(rs.event.c_str(), rs.name.c_str(), rs.mel.c_str(), rs.values[0], -1,
+							(rs.values[1] & REG_DISPLAY_ENABLED) != 0, (rs.values[1] & REG_UNDO_ENABLED) != 0))
+		{
+			// probably an event this version doesn't have
+			warnPrintf ("skipped script \"%s\" for event \"%s\"\n", rs.name.c_str(), rs.event.c_str());
+		}
+	}
+
+	dbgPrintf ("loaded %u scripts from \"%s\"\n", (unsigned)scripts.size(), filename.asChar());
+	return true;
+}
+
+bool mayaSvn::compareFiles(const MString& file1, const MString& file2, FileCompareResult* pResult)
+{
+	FileCompareResult result;
+	TraceSpan span("compare", "compareFiles");
+
+	hiCompareFiles(file1.asChar(), file2.asChar(), &result);
+	span.setArg("file1", file1.asChar());
+	span.setArg("file2", file2.asChar());
+	span.setArg("result", result.pReason);
+	dbgPrintf ("compared \"%s\" to \"%s\" : %s, read %I64u of %I64u bytes\n", file1.asChar(), file2.asChar(), result.pReason, result.bytesRead, result.fileSize);
+
+	if (pResult)
+	{
+		*pResult = result;
+	}
+
+	return result.bSame;
+}
+
+// MString is not safe to use from other threads so anything headed for
+// one is copied into std::strings first
+static void toStringList (const MStringArray& strs, StringList& list)
+{
+	list.reserve(list.size() + strs.length());
+	for (unsigned ii = 0; ii < strs.length(); ++ii)
+	{
+		list.push_back(strs[ii].asChar());
+	}
+}
+
+struct CompareBatch
+{
+	StringList					files1;
+	StringList					files2;
+	vector<FileCompareResult>	results;
+};
+
+static void compareBatchItem(int index, void* pContext)
+{
+	CompareBatch* pBatch = (CompareBatch*)pContext;
+	TraceSpan span("compare", "compareFiles");
+
+	hiCompareFiles(pBatch->files1[index].c_str(), pBatch->files2[index].c_str(), &pBatch->results[index]);
+	span.setArg("file1", pBatch->files1[index]);
+	span.setArg("file2", pBatch->files2[index]);
+	span.setArg("result", pBatch->results[index].pReason);
+}
+
+void mayaSvn::compareFileList(const MStringArray& files1, const MStringArray& files2, MIntArray& results)
+{
+	CompareBatch batch;
+	unsigned numFiles = files1.length();
+
+	toStringList(files1, batch.files1);
+	toStringList(files2, batch.files2);
+	batch.results.resize(numFiles);
+
+	wpRunParallel(numFiles, compareBatchItem, &batch);
+
+	for (unsigned ii = 0; ii < numFiles; ++ii)
+	{
+		const FileCompareResult& result = batch.results[ii];
+
+		dbgPrintf ("compared \"%s\" to \"%s\" : %s, read %I64u of %I64u bytes\n", batch.files1[ii].c_str(), batch.files2[ii].c_str(), result.pReason, result.bytesRead, result.fileSize);
+		results.append(result.bSame ? 1 : 0);
+	}
+}
+
+bool mayaSvn::hashFile(const MString& filename, MString& hash)
+{
+	unsigned __int64 value;
+	unsigned __int64 bytesRead;
+	char buffer[32];
+
+	if (!hiGetFileHash(filename.asChar(), &value, &bytesRead))
+	{
+		errPrintf ("could not read \"%s\"\n", filename.asChar());
+		return false;
+	}
+
+	dbgPrintf ("hashed \"%s\", read %I64u bytes\n", filename.asChar(), bytesRead);
+	_snprintf (buffer, sizeof(buffer), "%016I64x", value);
+	buffer[sizeof(buffer) - 1] = '\0';
+	hash = buffer;
+	return true;
+}
+
+void mayaSvn::indexStats(MStringArray& stats)
+{
+	HashIndexStats	his;
+	char			buffer[64];
+
+	hiGetStats(&his);
+
+	stats.append(MString("file=") + hiGetIndexFile());
+	stats.append(MString("entries=") + (int)his.numEntries);
+	stats.append(MString("hits=") + (int)his.hits);
+	stats.append(MString("misses=") + (int)his.misses);
+	_snprintf (buffer, sizeof(buffer), "bytesHashed=%I64u", his.bytesHashed);
+	buffer[sizeof(buffer) - 1] = '\0';
+	stats.append(buffer);
+	stats.append(MString("dirty=") + (his.bDirty ? 1 : 0));
+}
+
+bool mayaSvn::wcInfo(const MString& path, MStringArray& info)
+{
+	WcInfo	wi;
+	string	error;
+
+	if (!wcGetInfo(path.asChar(), &wi, &error))
+	{
+		errPrintf ("%s\n", error.c_str());
+		return false;
+	}
+
+	info.append(MString("versioned=") + (wi.bVersioned ? 1 : 0));
+	info.append(MString("kind=") + wi.kind.c_str());
+	info.append(MString("status=") + wi.status.c_str());
+	info.append(MString("revision=") + (int)wi.revision);
+	info.append(MString("lastChangedRev=") + (int)wi.changedRevision);
+	info.append(MString("lastAuthor=") + wi.changedAuthor.c_str());
+	info.append(MString("url=") + wi.url.c_str());
+	info.append(MString("lockToken=") + wi.lockToken.c_str());
+	info.append(MString("lockOwner=") + wi.lockOwner.c_str());
+	info.append(MString("lockComment=") + escape(wi.lockComment.c_str()));
+	info.append(MString("modified=") + (wi.bModified ? 1 : 0));
+	info.append(MString("wcRoot=") + wi.wcRoot.c_str());
+
+	return true;
+}
+
+bool mayaSvn::wcStatus(const MString& path, MString& status)
+{
+	WcInfo	wi;
+	string	error;
+
+	if (!wcGetInfo(path.asChar(), &wi, &error))
+	{
+		errPrintf ("%s\n", error.c_str());
+		return false;
+	}
+
+	status = wi.status.c_str();
+	return true;
+}
+
+bool mayaSvn::svnRun(const MString& subcommand, const MStringArray& paths, const MString& message, MStringArray& results)
+{
+	StringList	pathList;
+	StringList	resultList;
+	string		error;
+
+	toStringList(paths, pathList);
+
+	bool bOk = scRun(subcommand.asChar(), pathList, message.asChar(), resultList, &error);
+
+	// the status cache can't see lock changes on disk so tell it
+	if (subcommand != "info")
+	{
+		for (size_t ii = 0; ii < pathList.size(); ++ii)
+		{
+			stMarkDirty(pathList[ii].c_str());
+			lcInvalidate(pathList[ii].c_str());
+		}
+	}
+
+	if (!bOk)
+	{
+		errPrintf ("svn %s failed: %s\n", subcommand.asChar(), error.c_str());
+		return false;
+	}
+
+	for (size_t ii = 0; ii < resultList.size(); ++ii)
+	{
+		dbgPrintf ("svn %s : %s\n", subcommand.asChar(), resultList[ii].c_str());
+		results.append(resultList[ii].c_str());
+	}
+	return true;
+}
+
+bool mayaSvn::lockPaths(const MStringArray& paths, const MString& comment, bool bLock, MStringArray& outcomes)
+{
+	StringList	pathList;
+	StringList	outcomeList;
+	string		error;
+	const char*	pWhat = bLock ? "lock" : "unlock";
+
+	toStringList(paths, pathList);
+
+	bool bOk = bLock ? scLock(pathList, comment.asChar(), outcomeList, &error)
+					 : scUnlock(pathList, outcomeList, &error);
+
+	for (size_t ii = 0; ii < pathList.size(); ++ii)
+	{
+		stMarkDirty(pathList[ii].c_str());
+		lcInvalidate(pathList[ii].c_str());
+	}
+
+	if (!bOk)
+	{
+		errPrintf ("svn %s failed: %s\n", pWhat, error.c_str());
+		return false;
+	}
+
+	for (size_t ii = 0; ii < outcomeList.size(); ++ii)
+	{
+		dbgPrintf ("%s \"%s\" : %s\n", pWhat, pathList[ii].c_str(), outcomeList[ii].c_str());
+		outcomes.append(outcomeList[ii].c_str());
+	}
+	return true;
+}
+
+bool mayaSvn::lockOwners(const MStringArray& paths, MStringArray& owners)
+{
+	StringList			pathList;
+	vector<SvnLockInfo>	locks;
+	string				error;
+
+	toStringList(paths, pathList);
+
+	if (!scGetLocks(pathList, locks, &error))
+	{
+		errPrintf ("could not get lock owners: %s\n", error.c_str());
+		return false;
+	}
+
+	for (size_t ii = 0; ii < locks.size(); ++ii)
+	{
+		if (!locks[ii].error.empty())
+		{
+			owners.append(MString("error:") + locks[ii].error.c_str());
+		}
+		else
+		{
+			owners.append(locks[ii].owner.c_str());
+		}
+	}
+	return true;
+}
+
+// quote a string for use in a MEL command
+static MString melQuote (const MString& str)
+{
+	MString	newstr("\"");
+	const char* lastOk = str.asChar();
+	const char* s;
+
+	for (s = lastOk; *s; ++s)
+	{
+		const char* pEsc = NULL;
+
+		switch (*s)
+		{
+		case '\\': pEsc = "\\\\"; break;
+		case '"':  pEsc = "\\\""; break;
+		case '\n': pEsc = "\\n";  break;
+		case '\r': pEsc = "\\r";  break;
+		case '\t': pEsc = "\\t";  break;
+		}
+		if (pEsc)
+		{
+			newstr += MString(lastOk, s - lastOk) + pEsc;
+			lastOk  = s + 1;
+		}
+	}
+	return newstr + MString(lastOk, s - lastOk) + "\"";
+}
+
+int mayaSvn::svnRunAsync(const MString& subcommand, const MStringArray& paths, const MString& message, const MString& callback)
+{
+	StringList	pathList;
+	string		error;
+
+	toStringList(paths, pathList);
+
+	int id = aqEnqueue(subcommand.asChar(), pathList, message.asChar(), callback.asChar(), &error);
+	if (!id)
+	{
+		errPrintf ("could not queue svn %s: %s\n", subcommand.asChar(), error.c_str());
+		return 0;
+	}
+	dbgPrintf ("queued svn %s as job %d\n", subcommand.asChar(), id);
+
+	// watch for it finishing.  We don't leave this installed all the
+	// time since maya calls idle callbacks constantly
+	if (!s_bIdleInstalled)
+	{
+		MStatus stat;
+
+		s_idleCallbackId = MEventMessage::addEventCallback("idle", asyncIdleCallback, NULL, &stat);
+		if (stat)
+		{
+			s_bIdleInstalled = true;
+		}
+		else
+		{
+			errPrintf ("could not install idle callback, job results will not be delivered\n");
+		}
+	}
+
+	return id;
+}
+
+void mayaSvn::deliverJobs()
+{
+	vector<JobResult> finished;
+
+	aqTakeFinished(finished);
+	for (size_t ii = 0; ii < finished.size(); ++ii)
+	{
+		const JobResult& jr = finished[ii];
+
+		dbgPrintf ("job %d %s\n", jr.id, aqStateName(jr.state));
+		if (!jr.callback.empty())
+		{
+			// callback(int $jobId, string $state, string $results[])
+			MString cmd = MString(jr.callback.c_str()) + "(" + jr.id + ", \"" + aqStateName(jr.state) + "\", {";
+			for (size_t jj = 0; jj < jr.results.size(); ++jj)
+			{
+				cmd += (jj ? ", " : "") + melQuote(jr.results[jj].c_str());
+			}
+			cmd += "})";
+			dbgPrintf ("%s\n", cmd.asChar());
+			MGlobal::executeCommand(cmd, false, false);
+		}
+	}
+	if (dbgGetDebug())
+	{
+		fflush(stdout);
+	}
+}
+
+void mayaSvn::asyncIdleCallback(void* clientdata)
+{
+	deliverJobs();
+
+	if (!aqNumOutstanding() && s_bIdleInstalled)
+	{
+		MMessage::removeCallback(s_idleCallbackId);
+		s_bIdleInstalled = false;
+	}
+}
+
+// finish anything queued, giving up on it if svn won't finish.  Too
+// late to run MEL callbacks
+bool mayaSvn::drainJobs()
+{
+	StringList abandoned;
+
+	dbgPrintf ("waiting for %d svn jobs\n", aqNumOutstanding());
+	bool bStopped = aqDrain(&abandoned);
+	for (size_t ii = 0; ii < abandoned.size(); ++ii)
+	{
+		errPrintf ("svn did not finish in time, abandoned %s\n", abandoned[ii].c_str());
+	}
+	if (!bStopped)
+	{
+		errPrintf ("the svn thread will not stop\n");
+	}
+	return bStopped;
+}
+
+void mayaSvn::asyncExitCallback(void* clientdata)
+{
+	drainJobs();
+}
+
+struct ExecBatch
+{
+	vector<string>		cmdLines;
+	unsigned			timeoutMs;
+	vector<ProcResult>	results;
+	vector<string>		errors;
+};
+
+static void execBatchItem(int index, void* pContext)
+{
+	ExecBatch* pBatch = (ExecBatch*)pContext;
+
+	if (!prRun(pBatch->cmdLines[index].c_str(), pBatch->timeoutMs, &pBatch->results[index], &pBatch->errors[index]))
+	{
+		pBatch->results[index].err = pBatch->errors[index];
+	}
+}
+
+void mayaSvn::execCommands(const MStringArray& cmdLines, unsigned timeoutMs, MStringArray& results)
+{
+	ExecBatch batch;
+	unsigned numCmds = cmdLines.length();
+
+	for (unsigned ii = 0; ii < numCmds; ++ii)
+	{
+		batch.cmdLines.push_back(cmdLines[ii].asChar());
+	}
+	batch.timeoutMs = timeoutMs;
+	batch.results.resize(numCmds);
+	batch.errors.resize(numCmds);
+
+	// prRun limits how many run at once itself, this just keeps us
+	// from starting threads that would only wait
+	wpRunParallel(numCmds, execBatchItem, &batch, prGetMaxProcs());
+
+	for (unsigned ii = 0; ii < numCmds; ++ii)
+	{
+		const ProcResult& pr = batch.results[ii];
+		char buffer[64];
+
+		dbgPrintf ("ran \"%s\" : exit %d, %.3f seconds%s\n", batch.cmdLines[ii].c_str(), pr.exitCode, pr.wallSeconds, pr.bTimedOut ? ", timed out" : "");
+		_snprintf (buffer, sizeof(buffer), "wallSeconds=%.3f", pr.wallSeconds);
+		buffer[sizeof(buffer) - 1] = '\0';
+
+		results.append(MString("exitCode=") + pr.exitCode);
+		results.append(buffer);
+		results.append(MString("timedOut=") + (pr.bTimedOut ? 1 : 0));
+		results.append(MString("stdout=") + pr.out.c_str());
+		results.append(MString("stderr=") + pr.err.c_str());
+	}
+}
+
+void mayaSvn::cachedStatus(const MString& path, MStringArray& info)
+{
+	StatusEntry	entry;
+
+	if (!stLookup(path.asChar(), &entry))
+	{
+		dbgPrintf ("no cached status for \"%s\"\n", path.asChar());
+		return;
+	}
+
+	info.append(MString("status=") + entry.status);
+	info.append(MString("versioned=") + (entry.bVersioned ? 1 : 0));
+	info.append(MString("kind=") + (entry.bIsDir ? "dir" : "file"));
+	info.append(MString("outOfDate=") + (entry.bOutOfDate ? 1 : 0));
+	info.append(MString("revision=") + (int)entry.revision);
+	info.append(MString("lastChangedRev=") + (int)entry.changedRevision);
+	info.append(MString("lastAuthor=") + entry.changedAuthor.c_str());
+	info.append(MString("lockOwner=") + entry.lockOwner.c_str());
+	info.append(MString("reposLockOwner=") + entry.reposLockOwner.c_str());
+}
+
+/*************************************************************************
+                              findSequence
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::findSequence (const MString& path, bool bFrameInfo, MStringArray& results)
+
+   PURPOSE
+		every file on disk in path's frame sequence, sorted by frame.
+		With bFrameInfo key=value lines about the sequence instead:
+		prefix, suffix, padding (0 = not padded), count, first, last
+		and frames ("1-20,25").
+
+   RETURNS
+		false if path has no frame number or its directory can't be read
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::findSequence(const MString& path, bool bFrameInfo, MStringArray& results)
+{
+	SeqInfo	info;
+	string	error;
+
+	if (!ssFindSequence(path.asChar(), &g_diskFs, &info, &error))
+	{
+		errPrintf ("%s\n", error.c_str());
+		return false;
+	}
+	dbgPrintf ("found %u frames for \"%s\"\n", (unsigned)info.frames.size(), path.asChar());
+
+	if (!bFrameInfo)
+	{
+		for (size_t ii = 0; ii < info.frames.size(); ++ii)
+		{
+			results.append(info.frames[ii].path.c_str());
+		}
+		return true;
+	}
+
+	results.append(MString("prefix=") + info.prefix.c_str());
+	results.append(MString("suffix=") + info.suffix.c_str());
+	results.append(MString("padding=") + info.padding);
+	results.append(MString("count=") + (int)info.frames.size());
+	if (!info.frames.empty())
+	{
+		results.append(MString("first=") + info.frames.front().frame);
+		results.append(MString("last=") + info.frames.back().frame);
+	}
+	results.append(MString("frames=") + ssFrameRanges(info).c_str());
+	return true;
+}
+
+/*************************************************************************
+                              listTextures
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::listTextures (bool bCountOnly, MStringArray& results)
+
+   PURPOSE
+		fileNodes=N and animated=N followed by texture=<path> for
+		every texture the file nodes in the scene could use, each once.
+		Animated ones (useFrameExtension) become every frame on disk,
+		see ssFindSequence.  bCountOnly leaves off the textures, which
+		doesn't touch the disk.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::listTextures(bool bCountOnly, MStringArray& results)
+{
+	TexManifest	manifest;
+	int			numNodes = 0;
+	int			numAnimated = 0;
+
+	tmInit(&manifest, &g_diskFs);
+
+	for (MItDependencyNodes it(MFn::kFileTexture); !it.isDone(); it.next())
+	{
+		MFnDependencyNode	fn(it.item());
+		MString				filename;
+		bool				bAnimated = false;
+
+		fn.findPlug("fileTextureName").getValue(filename);
+		fn.findPlug("useFrameExtension").getValue(bAnimated);
+
+		++numNodes;
+		if (bAnimated)
+		{
+			++numAnimated;
+		}
+		if (bCountOnly)
+		{
+			continue;
+		}
+
+		if (bAnimated)
+		{
+			tmAddSequence(&manifest, filename.asChar());
+		}
+		else
+		{
+			tmAddTexture(&manifest, filename.asChar());
+		}
+	}
+
+	results.append(MString("fileNodes=") + numNodes);
+	results.append(MString("animated=") + numAnimated);
+	if (bCountOnly)
+	{
+		return;
+	}
+
+	dbgPrintf ("%d file nodes, %u textures, %u sequences, %u duplicates\n", numNodes, (unsigned)manifest.textures.size(), manifest.numSequences, manifest.numDuplicates);
+	for (size_t ii = 0; ii < manifest.textures.size(); ++ii)
+	{
+		results.append(MString("texture=") + manifest.textures[ii].c_str());
+	}
+}
+
+/*************************************************************************
+                               watchRoots
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::watchRoots (const MStringArray& paths, MStringArray& roots)
+
+   PURPOSE
+		keep listings of everything under paths in memory, see
+		dircache.cpp.  No paths leaves things alone.  roots is set to
+		what's being watched after.
+
+   RETURNS
+		false if some path could not be watched
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::watchRoots(const MStringArray& paths, MStringArray& roots)
+{
+	bool			bOk = true;
+	vector<string>	rootList;
+
+	if (paths.length())
+	{
+		StringList	pathList;
+		string		error;
+
+		toStringList(paths, pathList);
+		if (!dcSetRoots(pathList, &error))
+		{
+			errPrintf ("%s", error.c_str());
+			bOk = false;
+		}
+	}
+
+	dcGetRoots(rootList);
+	for (size_t ii = 0; ii < rootList.size(); ++ii)
+	{
+		dbgPrintf ("watching \"%s\"\n", rootList[ii].c_str());
+		roots.append(rootList[ii].c_str());
+	}
+	return bOk;
+}
+
+// folders end in "/".  Like getFileList a folder that isn't there is empty
+bool mayaSvn::listDir(const MString& path, MStringArray& names)
+{
+	vector<DirItem>	items;
+	bool			bExists;
+	string			error;
+
+	if (!dcListDir(path.asChar(), items, &bExists, &error))
+	{
+		errPrintf ("%s\n", error.c_str());
+		return false;
+	}
+	if (!bExists)
+	{
+		dbgPrintf ("no folder \"%s\"\n", path.asChar());
+	}
+	for (size_t ii = 0; ii < items.size(); ++ii)
+	{
+		names.append(items[ii].bIsDir ? MString((items[ii].name + "/").c_str()) : MString(items[ii].name.c_str()));
+	}
+	return true;
+}
+
+void mayaSvn::fileExists(const MStringArray& paths, MIntArray& results)
+{
+	for (unsigned ii = 0; ii < paths.length(); ++ii)
+	{
+		PathInfo info;
+
+		results.append(dcGetPathInfo(paths[ii].asChar(), &info) ? 1 : 0);
+	}
+}
+
+void mayaSvn::dirCacheStats(MStringArray& stats)
+{
+	DirCacheStats dcs;
+
+	dcGetStats(&dcs);
+
+	stats.append(MString("roots=") + (int)dcs.numRoots);
+	stats.append(MString("dirs=") + (int)dcs.numDirs);
+	stats.append(MString("hits=") + (int)dcs.hits);
+	stats.append(MString("misses=") + (int)dcs.misses);
+	stats.append(MString("uncached=") + (int)dcs.uncached);
+	stats.append(MString("invalidations=") + (int)dcs.invalidations);
+	stats.append(MString("overflows=") + (int)dcs.overflows);
+}
+
+/*************************************************************************
+                                planSync
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::planSync (const MString& srcDir, const MString& dstDir, const MStringArray& exclusions, MStringArray& results)
+
+   PURPOSE
+		what it would take to make the textures in dstDir match srcDir,
+		see syncplan.cpp.  exclusions are gmatch patterns checked
+		against paths relative to srcDir.  Each result is one of
+
+		  copy|src|dst|reason
+		  overwrite|src|dst|reason
+		  skip|src|dst|reason
+
+		copies first, then overwrites, then skips.
+
+   RETURNS
+		false if a folder could not be read
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::planSync(const MString& srcDir, const MString& dstDir, const MStringArray& exclusions, MStringArray& results)
+{
+	StringList	exclusionList;
+	SyncMatcher	matcher;
+	SyncPlan	plan;
+	string		error;
+
+	toStringList(exclusions, exclusionList);
+	spCompileMatcher(exclusionList, &matcher);
+	if (!spPlanSync(srcDir.asChar(), dstDir.asChar(), matcher, &plan, &error))
+	{
+		errPrintf ("%s\n", error.c_str());
+		return false;
+	}
+	// the compares filled the hash index, keep it for next time
+	hiSave();
+
+	const vector<SyncItem>*	lists[] = { &plan.copies, &plan.overwrites, &plan.skips, };
+	const char*				kinds[] = { "copy|", "overwrite|", "skip|", };
+
+	for (int ll = 0; ll < 3; ++ll)
+	{
+		for (size_t ii = 0; ii < lists[ll]->size(); ++ii)
+		{
+			const SyncItem& item = (*lists[ll])[ii];
+
+			results.append((kinds[ll] + item.src + "|" + item.dst + "|" + item.reason).c_str());
+		}
+	}
+
+	dbgPrintf ("planned sync of \"%s\" in %u folders: %u to copy, %u to overwrite, %u skipped\n",
+			   srcDir.asChar(), plan.numDirs, (unsigned)plan.copies.size(), (unsigned)plan.overwrites.size(), (unsigned)plan.skips.size());
+	return true;
+}
+
+/*************************************************************************
+                                copyFiles
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::copyFiles (const MStringArray& srcs, const MStringArray& dsts, MStringArray& results)
+
+   PURPOSE
+		copy srcs[n] to dsts[n] for every n, several at a time, see
+		filecopy.cpp.  4 results per file
+
+		  copied=1/0
+		  bytes=size
+		  bytesPerSecond=rate
+		  error=why not, "" if it was copied
+
+		then for the whole batch
+
+		  totalBytes=bytes copied
+		  wallSeconds=start to finish
+		  bytesPerSecond=totalBytes / wallSeconds
+
+   RETURNS
+		false if any file was not copied
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::copyFiles(const MStringArray& srcs, const MStringArray& dsts, MStringArray& results)
+{
+	StringList				srcList;
+	StringList				dstList;
+	vector<FileCopyResult>	copies;
+	unsigned __int64		totalBytes = 0;
+	bool					bOk = true;
+	char					buffer[64];
+
+	toStringList(srcs, srcList);
+	toStringList(dsts, dstList);
+
+	__int64 start = esNow();
+	cpCopyFiles(srcList, dstList, copies);
+	double wallSeconds = esElapsedMs(start) / 1000.0;
+
+	for (size_t ii = 0; ii < copies.size(); ++ii)
+	{
+		const FileCopyResult& copy = copies[ii];
+
+		if (copy.bOk)
+		{
+			// CopyFile keeps the source's time so neither cache can
+			// tell it changed by looking
+			hiInvalidate(dstList[ii].c_str());
+			stMarkDirty(dstList[ii].c_str());
+			totalBytes += copy.bytes;
+			dbgPrintf ("copied \"%s\" to \"%s\" : %I64u bytes, %.3f seconds\n", srcList[ii].c_str(), dstList[ii].c_str(), copy.bytes, copy.seconds);
+		}
+		else
+		{
+			errPrintf ("%s\n", copy.error.c_str());
+			bOk = false;
+		}
+
+		results.append(MString("copied=") + (copy.bOk ? 1 : 0));
+		_snprintf (buffer, sizeof(buffer), "bytes=%I64u", copy.bytes);
+		buffer[sizeof(buffer) - 1] = '\0';
+		results.append(buffer);
+		_snprintf (buffer, sizeof(buffer), "bytesPerSecond=%.0f", copy.seconds > 0.0 ? (double)(__int64)copy.bytes / copy.seconds : 0.0);
+		buffer[sizeof(buffer) - 1] = '\0';
+		results.append(buffer);
+		results.append(MString("error=") + copy.error.c_str());
+	}
+	hiSave();
+
+	_snprintf (buffer, sizeof(buffer), "totalBytes=%I64u", totalBytes);
+	buffer[sizeof(buffer) - 1] = '\0';
+	results.append(buffer);
+	_snprintf (buffer, sizeof(buffer), "wallSeconds=%.3f", wallSeconds);
+	buffer[sizeof(buffer) - 1] = '\0';
+	results.append(buffer);
+	_snprintf (buffer, sizeof(buffer), "bytesPerSecond=%.0f", wallSeconds > 0.0 ? (double)(__int64)totalBytes / wallSeconds : 0.0);
+	buffer[sizeof(buffer) - 1] = '\0';
+	results.append(buffer);
+
+	dbgPrintf ("copied %u files, %I64u bytes in %.3f seconds\n", (unsigned)copies.size(), totalBytes, wallSeconds);
+	return bOk;
+}
+
+void mayaSvn::statusCacheStats(MStringArray& stats)
+{
+	StatusCacheStats scs;
+
+	stGetStats(&scs);
+
+	stats.append(MString("entries=") + (int)scs.numEntries);
+	stats.append(MString("roots=") + (int)scs.numRoots);
+	stats.append(MString("fullQueries=") + (int)scs.fullQueries);
+	stats.append(MString("treeQueries=") + (int)scs.treeQueries);
+	stats.append(MString("fileQueries=") + (int)scs.fileQueries);
+}
+
+/*************************************************************************
+                              lockStates
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::lockStates (const MStringArray& paths, MStringArray& states)
+
+   PURPOSE
+		one result per path: "unlocked", "mine", "held:<user>" or
+		"error:<msg>".  Answers come from the lock cache if they are
+		less than -lockCacheTTL seconds old.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::lockStates(const MStringArray& paths, MStringArray& states)
+{
+	for (unsigned ii = 0; ii < paths.length(); ++ii)
+	{
+		string state;
+		string error;
+
+		if (lcGetLockState(paths[ii].asChar(), &state, &error))
+		{
+			states.append(state.c_str());
+		}
+		else
+		{
+			dbgPrintf ("no lock state for \"%s\": %s\n", paths[ii].asChar(), error.c_str());
+			states.append(MString("error:") + error.c_str());
+		}
+	}
+}
+
+static void appendEventStats(MStringArray& stats, const char* pEvent, const char* pScript, const EventStats& es)
+{
+	char buf[64];
+
+	stats.append(MString("event=") + pEvent);
+	stats.append(MString("script=") + pScript);
+	stats.append(MString("calls=") + (int)es.calls);
+	stats.append(MString("failures=") + (int)es.failures);
+	sprintf(buf, "totalMs=%.3f", es.totalMs);
+	stats.append(buf);
+	sprintf(buf, "minMs=%.3f", es.minMs);
+	stats.append(buf);
+	sprintf(buf, "maxMs=%.3f", es.maxMs);
+	stats.append(buf);
+	sprintf(buf, "p95Ms=%.3f", esPercentile(&es, 95.0));
+	stats.append(buf);
+}
+
+/*************************************************************************
+                              eventStats
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::eventStats (MStringArray& stats)
+
+   PURPOSE
+		timing for every event and script that has run since the last
+		-resetStats.  Each record starts with "event=".  The record for
+		the whole event has "script=" empty, then there's one record per
+		script in the order they run.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::eventStats(MStringArray& stats)
+{
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		const MsgInfo& mi = msgInfos[ii];
+
+		if (!mi.stats.calls)
+		{
+			continue;
+		}
+		appendEventStats(stats, mi.pLabel + 1, "", mi.stats);
+		for (size_t jj = 0; jj < mi.melScripts.size(); ++jj)
+		{
+			const EventScript& mel = mi.melScripts[jj];
+
+			if (mel._stats.calls)
+			{
+				appendEventStats(stats, mi.pLabel + 1, mel._name.c_str(), mel._stats);
+			}
+		}
+	}
+}
+
+void mayaSvn::resetEventStats()
+{
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		MsgInfo& mi = msgInfos[ii];
+
+		esReset(&mi.stats);
+		for (size_t jj = 0; jj < mi.melScripts.size(); ++jj)
+		{
+			esReset(&mi.melScripts[jj]._stats);
+		}
+	}
+}
+
+// see edWriteRecord
+void mayaSvn::recordEvent(const MsgInfo& mi)
+{
+	MString				filename = eventFilename(mi);
+	vector<const char*>	nodes;
+
+	for (unsigned ii = 0; ii < s_deliveringNodes.length(); ++ii)
+	{
+		nodes.push_back(s_deliveringNodes[ii].asChar());
+	}
+	edWriteRecord(s_recordFp, esElapsedMs(s_recordStart), mi.pLabel + 1, filename.asChar(), nodes.empty() ? NULL : &nodes[0], (unsigned)nodes.size());
+}
+
+/*************************************************************************
+                              recordEvents
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::recordEvents (const MString& filename)
+
+   PURPOSE
+		start writing every event Maya sends us to filename so it can
+		be fed back through -replayEvents.  "" stops.
+
+   RETURNS
+		false if the file could not be opened
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::recordEvents(const MString& filename)
+{
+	if (s_recordFp)
+	{
+		fclose(s_recordFp);
+		s_recordFp = NULL;
+	}
+
+	if (filename.length())
+	{
+		s_recordFp = fopen(filename.asChar(), "w");
+		if (!s_recordFp)
+		{
+			errPrintf ("could not open \"%s\"\n", filename.asChar());
+			return false;
+		}
+		fprintf(s_recordFp, "%s\n", REC_HEADER);
+		s_recordStart = esNow();
+	}
+
+	// start or stop listening to the events without scripts
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		updateCallback(msgInfos[ii]);
+	}
+	return true;
+}
+
+static void appendValue(MStringArray& results, const char* pKey, double value)
+{
+	char buf[64];
+
+	sprintf(buf, "%s=%.3f", pKey, value);
+	results.append(buf);
+}
+
+static void appendTimings(MStringArray& results, const char* pPrefix, vector<double>& times)
+{
+	if (times.empty())
+	{
+		return;
+	}
+
+	double total = 0.0;
+
+	std::sort(times.begin(), times.end());
+	for (size_t ii = 0; ii < times.size(); ++ii)
+	{
+		total += times[ii];
+	}
+	string prefix = pPrefix;
+
+	appendValue(results, (prefix + "MeanUs").c_str(), total * 1000.0 / (double)times.size());
+	appendValue(results, (prefix + "P50Us").c_str(), times[times.size() / 2] * 1000.0);
+	appendValue(results, (prefix + "P99Us").c_str(), times[(times.size() * 99) / 100] * 1000.0);
+	appendValue(results, (prefix + "MaxUs").c_str(), times.back() * 1000.0);
+}
+
+/*************************************************************************
+                              replayEvents
+ *************************************************************************
+
+   SYNOPSIS
+		bool mayaSvn::replayEvents (const MString& filename, MStringArray& results)
+
+   PURPOSE
+		send the events in a -recordEvents file through the same
+		dispatch a live event goes through, as fast as they'll go,
+		and time it.  -getFilename and the C++ handlers see the
+		recorded filename, -getNodes the recorded nodes.  With
+		-dryRun the scripts aren't run.
+
+   RETURNS
+		false if the file could not be read.  results are key=value.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool mayaSvn::replayEvents(const MString& filename, MStringArray& results)
+{
+	FILE* fp = fopen(filename.asChar(), "r");
+	if (!fp)
+	{
+		errPrintf ("could not open \"%s\"\n", filename.asChar());
+		return false;
+	}
+
+	vector<double>	times;
+	int				unknown = 0;
+	int				cancelled = 0;
+	__int64			start = esNow();
+	EventRecord		record;
+
+	s_bReplaying = true;
+	while (edReadRecord(fp, &record))
+	{
+		s_replayFilename = record.filename.c_str();
+		s_deliveringNodes.clear();
+		for (size_t ii = 0; ii < record.nodes.size(); ++ii)
+		{
+			s_deliveringNodes.append(record.nodes[ii].c_str());
+		}
+
+		__int64 eventStart = esNow();
+
+		MsgInfo* pInfo = findMsgInfo(MString(record.event.c_str()));
+		if (!pInfo)
+		{
+			++unknown;
+			continue;
+		}
+		if (!runHandlers(*pInfo))
+		{
+			++cancelled;
+		}
+		times.push_back(esElapsedMs(eventStart));
+	}
+	s_bReplaying = false;
+	s_deliveringNodes.clear();
+	fclose(fp);
+
+	double totalMs = esElapsedMs(start);
+
+	results.append(MString("events=") + (int)times.size());
+	results.append(MString("unknown=") + unknown);
+	results.append(MString("cancelled=") + cancelled);
+	appendValue(results, "totalMs", totalMs);
+	appendValue(results, "eventsPerSec", totalMs > 0.0 ? (double)times.size() * 1000.0 / totalMs : 0.0);
+	appendTimings(results, "event", times);
+	return true;
+}
+
+/*************************************************************************
+                                benchmark
+ *************************************************************************
+
+   SYNOPSIS
+		void mayaSvn::benchmark (int scriptsPerEvent, MStringArray& results)
+
+   PURPOSE
+		time the parts of event handling that grow with the number of
+		scripts: adding them, looking up events by name, dispatching
+		and listing (which escapes every script).  Every event gets
+		scriptsPerEvent do nothing scripts and is dispatched dry.  The
+		real scripts and their stats are put back after.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void mayaSvn::benchmark(int scriptsPerEvent, MStringArray& results)
+{
+	vector<EventScriptList>	savedScripts(NUM_TABLE_ELEMENTS(msgInfos));
+	vector<EventStats>	savedStats(NUM_TABLE_ELEMENTS(msgInfos));
+	MStringArray		labels;
+	bool				bDryRun = s_bDryRun;
+	int					debug = dbgGetDebug();
+	__int64				start;
+
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		savedScripts[ii].swap(msgInfos[ii].melScripts);
+		savedStats[ii] = msgInfos[ii].stats;
+		labels.append(msgInfos[ii].pLabel + 1);
+	}
+
+	// adding prints a line per script
+	dbgSetDebug(0);
+	s_bDryRun = true;
+
+	// scene messages only, the others would start watching nodes
+	start = esNow();
+	for (int ii = 0; ii < kNumSceneMsgs; ++ii)
+	{
+		for (int jj = 0; jj < scriptsPerEvent; ++jj)
+		{
+			char name[32];
+
+			// shuffled priorities so the sorted insert does some work
+			sprintf(name, "bench%d", jj);
+			addEventScript(labels[ii], name, "// \"benchmark\"\tscript", (jj * 7919) % 101, -1, false, false);
+		}
+	}
+	double addMs = esElapsedMs(start);
+
+	// mixed case like people type them
+	MStringArray lookups;
+	for (unsigned ii = 0; ii < labels.length(); ++ii)
+	{
+		string label = labels[ii].asChar();
+
+		if (ii & 1)
+		{
+			for (size_t jj = 0; jj < label.size(); ++jj)
+			{
+				label[jj] = (char)tolower((unsigned char)label[jj]);
+			}
+		}
+		lookups.append(label.c_str());
+	}
+	int found = 0;
+	start = esNow();
+	for (int ii = 0; ii < BENCH_LOOKUPS; ++ii)
+	{
+		if (findMsgInfo(lookups[ii % lookups.length()]))
+		{
+			++found;
+		}
+	}
+	double lookupMs = esElapsedMs(start);
+
+	// dispatch the scene messages, the others only differ in how they're delivered
+	vector<double> times;
+	start = esNow();
+	for (int round = 0; round < BENCH_ROUNDS; ++round)
+	{
+		for (int ii = 0; ii < kNumSceneMsgs; ++ii)
+		{
+			__int64 eventStart = esNow();
+
+			runHandlers(msgInfos[ii]);
+			times.push_back(esElapsedMs(eventStart));
+		}
+	}
+	double dispatchMs = esElapsedMs(start);
+
+	MStringArray scripts;
+	start = esNow();
+	listAllScripts(scripts);
+	double listMs = esElapsedMs(start);
+
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		msgInfos[ii].melScripts.swap(savedScripts[ii]);
+		msgInfos[ii].stats = savedStats[ii];
+		updateCallback(msgInfos[ii]);
+	}
+	s_bDryRun = bDryRun;
+	dbgSetDebug(debug);
+
+	double numScripts = (double)scriptsPerEvent * (double)kNumSceneMsgs * BENCH_ROUNDS;
+
+	results.append(MString("scriptsPerEvent=") + scriptsPerEvent);
+	appendValue(results, "addMs", addMs);
+	appendValue(results, "lookupNs", lookupMs * 1000000.0 / BENCH_LOOKUPS);
+	results.append(MString("lookupsFound=") + found);
+	appendValue(results, "dispatchMs", dispatchMs);
+	appendValue(results, "dispatchNsPerScript", numScripts > 0.0 ? dispatchMs * 1000000.0 / numScripts : 0.0);
+	appendTimings(results, "event", times);
+	appendValue(results, "listMs", listMs);
+	results.append(MString("listedScripts=") + (int)scripts.length());
+}
+
+void mayaSvn::lockCacheStats(MStringArray& stats)
+{
+	LockCacheStats lcs;
+
+	lcGetStats(&lcs);
+
+	stats.append(MString("entries=") + (int)lcs.numEntries);
+	stats.append(MString("hits=") + (int)lcs.hits);
+	stats.append(MString("misses=") + (int)lcs.misses);
+	stats.append(MString("expired=") + (int)lcs.expired);
+	stats.append(MString("invalidations=") + (int)lcs.invalidations);
+	stats.append(MString("ttl=") + (int)lcs.ttl);
+}
+
+MString mayaSvn::doFileSaveDialog(const MString& title, const MString& filter, const MString& defExt, const MString& filename)
+{
+	static OPENFILENAME ofn;
+	static char  filenameBuffer[MAX_PATH];
+	static char  filterBuffer[1024];
+
+	// setup filter (assume | for separator
+	if (filter.length() > 0)
+	{
+		char* d      = filterBuffer;
 		char* e      = filterBuffer + sizeof(filterBuffer) / sizeof(filterBuffer[0]);
 		const char *s = filter.asChar();
 
-		while (*s && d < e - 2)
+		while (*s && d < e - 2)
+		{
+			if (*s == '|')
+			{
+				*d = '\0';
+			}
+			else
+			{
+				*d = *s;
+			}
+			++d;
+			++s;
+		}
+		*d++ = '\0';
+		*d++ = '\0';
+	}
+
+	if (filename.length() < MAX_PATH - 1)
+	{
+		const char* s = filename.asChar();
+		char* d = filenameBuffer;
+
+		while (*s)
+		{
+			if (*s == '/')
+			{
+				*d++ = '\\';
+			}
+			else
+			{
+				*d++ = *s;
+			}
+			++s;
+		}
+		*d = '\0';
+	}
+
+	memset(&ofn, 0, sizeof(ofn));
+	ofn.lStructSize = sizeof(OPENFILENAME);
+	ofn.lpstrFilter = filter.length() > 0 ? filterBuffer : NULL;
+	ofn.lpstrFile   = filenameBuffer;
+	ofn.nMaxFile    = MAX_PATH;
+	ofn.lpstrTitle  = title.asChar();
+	ofn.Flags       = OFN_NOCHANGEDIR | OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+	ofn.lpstrDefExt = defExt.length() > 0 ? defExt.asChar() : NULL;
+
+	MString result;
+
+	if (GetSaveFileName(&ofn))
+	{
+		result = ofn.lpstrFile;
+	}
+
+	return result;
+}
+
+bool mayaSvn::needsCallback(const MsgInfo& mi)
+{
+	// while recording every scene message gets a callback so the
+	// recording has all of them, not just the ones with scripts
+	return !mi.melScripts.empty() || (s_recordFp && mi.family == MSGFAMILY_SCENE);
+}
+
+/*************************************************************************
+                              updateCallback
+ *************************************************************************
+
+   SYNOPSIS
+		MStatus mayaSvn::updateCallback (MsgInfo& mi)
+
+   PURPOSE
+		install the Maya callback for an event if it has something to
+		do, remove it if not.  Events nobody is listening to cost
+		nothing, the frame render ones in particular.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+MStatus mayaSvn::installCallback(MsgInfo& mi)
+{
+	MStatus		stat;
+	MCallbackId	id;
+
+	switch (mi.family)
+	{
+	case MSGFAMILY_SCENE:
+		if (mi.bCheck)
+		{
+			mi.callbackId = MSceneMessage::addCallback(mi.msg, callbackCheckStub, &mi, &stat);
+		}
+		else
+		{
+			mi.callbackId = MSceneMessage::addCallback(mi.msg, callbackStub, &mi, &stat);
+		}
+		break;
+	case MSGFAMILY_NODE_ADDED:
+		mi.callbackId = MDGMessage::addNodeAddedCallback(nodeCallback, "dependNode", &mi, &stat);
+		break;
+	case MSGFAMILY_NODE_REMOVED:
+		mi.callbackId = MDGMessage::addNodeRemovedCallback(nodeCallback, "dependNode", &mi, &stat);
+		break;
+	case MSGFAMILY_FILE_TEXTURE:
+		// every file node there is now and every one made later
+		mi.callbackId = MDGMessage::addNodeAddedCallback(fileNodeAddedCallback, "file", &mi, &stat);
+		if (!stat)
+		{
+			break;
+		}
+		id = MDGMessage::addNodeRemovedCallback(fileNodeRemovedCallback, "file", &mi, &stat);
+		if (stat)
+		{
+			mi.nodeCallbacks.append(id);
+			id = MSceneMessage::addCallback(MSceneMessage::kBeforeNew, fileSceneClearedCallback, &mi, &stat);
+		}
+		if (stat)
+		{
+			mi.nodeCallbacks.append(id);
+			id = MSceneMessage::addCallback(MSceneMessage::kBeforeOpen, fileSceneClearedCallback, &mi, &stat);
+		}
+		if (stat)
+		{
+			mi.nodeCallbacks.append(id);
+			for (MItDependencyNodes it(MFn::kFileTexture); stat && !it.isDone(); it.next())
+			{
+				MObject node = it.item();
+				stat = watchFileNode(mi, node);
+			}
+		}
+		if (!stat)
+		{
+			// half a watch would miss changes, take back what did go in
+			removeCallback(mi);
+		}
+		break;
+	case MSGFAMILY_IDLE:
+		mi.callbackId = MEventMessage::addEventCallback("idle", idleEventCallback, &mi, &stat);
+		break;
+	}
+	if (!stat)
+	{
+		errPrintf ("could not install callback for %s\n", mi.pLabel);
+		return stat;
+	}
+	mi.bInstalled = true;
+
+	dbgPrintf ("installed callback for %s\n", mi.pLabel);
+	return stat;
+}
+
+void mayaSvn::removeCallback(MsgInfo& mi)
+{
+	MMessage::removeCallback(mi.callbackId);
+	if (mi.nodeCallbacks.length())
+	{
+		MMessage::removeCallbacks(mi.nodeCallbacks);
+		mi.nodeCallbacks.clear();
+	}
+	unwatchAllFileNodes(mi);
+	mi.pendingNodes.clear();
+	mi.bInstalled = false;
+
+	dbgPrintf ("removed callback for %s\n", mi.pLabel);
+}
+
+MStatus mayaSvn::updateCallback(MsgInfo& mi)
+{
+	MStatus stat;
+	bool    bNeeded = needsCallback(mi);
+
+	if (bNeeded && !mi.bInstalled)
+	{
+		stat = installCallback(mi);
+	}
+	else if (!bNeeded && mi.bInstalled)
+	{
+		removeCallback(mi);
+	}
+	return stat;
+}
+
+// anything we remember about locks may be stale once a scene changes
+static void lockCacheHandler(MayaSvnEventContext* pContext, void* pUserData)
+{
+	if (!strcmp(pContext->pEvent, "AfterOpen"))
+	{
+		lcInvalidate("");
+	}
+	else
+	{
+		lcInvalidate(pContext->pFilename);
+	}
+}
+
+MStatus mayaSvn::install()
+{
+	MStatus stat;
+
+	buildMsgTables();
+
+	// our own checks run before anyone else's
+	addEventHandler("AfterOpen", "_mayaSvnLockCache", lockCacheHandler, NULL, INT_MIN);
+	addEventHandler("AfterSave", "_mayaSvnLockCache", lockCacheHandler, NULL, INT_MIN);
+
+	// most events get their callback when their first script is added
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		stat = updateCallback(msgInfos[ii]);
+		if (!stat)
+		{
+			return stat;
+		}
+	}
+
+	// our own, separate from any MEL scripts registered for kMayaExiting
+	if (!s_bExitInstalled)
+	{
+		s_exitCallbackId = MSceneMessage::addCallback(MSceneMessage::kMayaExiting, asyncExitCallback, NULL, &stat);
+		if (!stat)
+		{
+			errPrintf ("could not install exit callback\n");
+			return stat;
+		}
+		s_bExitInstalled = true;
+	}
+
+	statPrintf ("installed mayaSvn\n");
+
+	return stat;
+}
+
+MStatus mayaSvn::remove()
+{
+	MStatus stat;
+
+	statPrintf ("mayaSvn: removing all callbacks\n");
+
+	if (s_recordFp)
+	{
+		fclose(s_recordFp);
+		s_recordFp = NULL;
+	}
+
+	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+	{
+		MsgInfo& mi = msgInfos[ii];
+
+		if (mi.bInstalled)
+		{
+			removeCallback(mi);
+		}
+	}
+
+	if (s_bExitInstalled)
+	{
+		MSceneMessage::removeCallback(s_exitCallbackId);
+		s_bExitInstalled = false;
+	}
+	if (s_bIdleInstalled)
+	{
+		MMessage::removeCallback(s_idleCallbackId);
+		s_bIdleInstalled = false;
+	}
+	if (s_bPendingInstalled)
+	{
+		MMessage::removeCallback(s_pendingCallbackId);
+		s_bPendingInstalled = false;
+	}
+
+	return stat;
+}
+
+#define kDebugFlag				"-d"
+#define kDebugFlagLong			"-debug"
+#define kListEventsFlag			"-le"
+#define kListEventsFlagLong		"-listEvents"
+#define kListScriptsFlag		"-ls"
+#define kListScriptsFlagLong	"-listScripts"
+#define kListAllScriptsFlag		"-las"
+#define kListAllScriptsFlagLong	"-listAllScripts"
+#define kAddEventFlag			"-ae"
+#define kAddEventFlagLong		"-addEvent"
+#define kDelEventFlag			"-de"
+#define kDelEventFlagLong		"-delEvent"
+#define kScriptNameFlag			"-sn"
+#define kScriptNameFlagLong		"-scriptName"
+#define kMelFlag				"-mel"
+#define kMelFlagLong			"-melScript"
+#define kDisplayEnabledFlag		"-ds"
+#define kDisplayEnabledFlagLong	"-displayEnabled"
+#define kUndoEnabledFlag		"-ue"
+#define kUndoEnabledFlagLong	"-undoEnabled"
+#define kPriorityFlag			"-pri"
+#define kPriorityFlagLong		"-priority"
+#define kDebounceFlag			"-db"
+#define kDebounceFlagLong		"-debounce"
+#define kGetNodesFlag			"-gn"
+#define kGetNodesFlagLong		"-getNodes"
+#define kSaveRegistryFlag		"-sr"
+#define kSaveRegistryFlagLong	"-saveRegistry"
+#define kLoadRegistryFlag		"-lr"
+#define kLoadRegistryFlagLong	"-loadRegistry"
+#define kGetFilenameFlag		"-gf"
+#define kGetFilenameFlagLong	"-getFilename"
+#define kCompareFilesFlag		"-cf"
+#define kCompareFilesFlagLong	"-compareFiles"
+#define kCompareInfoFlag		"-ci"
+#define kCompareInfoFlagLong	"-compareInfo"
+#define kBatchFlag				"-b"
+#define kBatchFlagLong			"-batch"
+#define kFile2Flag				"-f2"
+#define kFile2FlagLong			"-file2"
+#define kIndexFileFlag			"-if"
+#define kIndexFileFlagLong		"-indexFile"
+#define kHashFileFlag			"-hf"
+#define kHashFileFlagLong		"-hashFile"
+#define kIndexStatsFlag			"-is"
+#define kIndexStatsFlagLong		"-indexStats"
+#define kInvalidateIndexFlag	"-ii"
+#define kInvalidateIndexFlagLong	"-invalidateIndex"
+#define kWcInfoFlag				"-wci"
+#define kWcInfoFlagLong			"-wcInfo"
+#define kWcStatusFlag			"-wcs"
+#define kWcStatusFlagLong		"-wcStatus"
+#define kSvnFlag				"-svn"
+#define kSvnFlagLong			"-svnCommand"
+#define kMessageFlag			"-msg"
+#define kMessageFlagLong		"-message"
+#define kExecFlag				"-ex"
+#define kExecFlagLong			"-exec"
+#define kTimeoutFlag			"-to"
+#define kTimeoutFlagLong		"-timeout"
+#define kMaxProcsFlag			"-mp"
+#define kMaxProcsFlagLong		"-maxProcs"
+#define kLockFlag				"-lk"
+#define kLockFlagLong			"-lock"
+#define kUnlockFlag				"-ulk"
+#define kUnlockFlagLong			"-unlock"
+#define kLockOwnerFlag			"-lo"
+#define kLockOwnerFlagLong		"-lockOwner"
+#define kAsyncFlag				"-as"
+#define kAsyncFlagLong			"-async"
+#define kCallbackFlag			"-cb"
+#define kCallbackFlagLong		"-callback"
+#define kJobStatusFlag			"-js"
+#define kJobStatusFlagLong		"-jobStatus"
+#define kCancelFlag				"-cn"
+#define kCancelFlagLong			"-cancel"
+#define kRefreshStatusFlag		"-rs"
+#define kRefreshStatusFlagLong	"-refreshStatus"
+#define kFullRefreshFlag		"-fr"
+#define kFullRefreshFlagLong	"-fullRefresh"
+#define kCachedStatusFlag		"-cs"
+#define kCachedStatusFlagLong	"-cachedStatus"
+#define kStatusCacheStatsFlag		"-scs"
+#define kStatusCacheStatsFlagLong	"-statusCacheStats"
+#define kLockStatusFlag			"-lst"
+#define kLockStatusFlagLong		"-lockStatus"
+#define kLockCacheTTLFlag		"-lct"
+#define kLockCacheTTLFlagLong	"-lockCacheTTL"
+#define kLockCacheStatsFlag		"-lcs"
+#define kLockCacheStatsFlagLong	"-lockCacheStats"
+#define kStatsFlag				"-sts"
+#define kStatsFlagLong			"-stats"
+#define kResetStatsFlag			"-rst"
+#define kResetStatsFlagLong		"-resetStats"
+#define kStatsEnabledFlag		"-ste"
+#define kStatsEnabledFlagLong	"-statsEnabled"
+#define kLogFileFlag			"-lf"
+#define kLogFileFlagLong		"-logFile"
+#define kLogLevelFlag			"-ll"
+#define kLogLevelFlagLong		"-logLevel"
+#define kTraceStartFlag			"-trs"
+#define kTraceStartFlagLong		"-traceStart"
+#define kTraceStopFlag			"-trp"
+#define kTraceStopFlagLong		"-traceStop"
+#define kRecordEventsFlag		"-rec"
+#define kRecordEventsFlagLong	"-recordEvents"
+#define kReplayEventsFlag		"-rpe"
+#define kReplayEventsFlagLong	"-replayEvents"
+#define kBenchmarkFlag			"-bm"
+#define kBenchmarkFlagLong		"-benchmark"
+#define kDryRunFlag				"-dry"
+#define kDryRunFlagLong			"-dryRun"
+#define kFindSequenceFlag		"-fsq"
+#define kFindSequenceFlagLong	"-findSequence"
+#define kFrameInfoFlag			"-fri"
+#define kFrameInfoFlagLong		"-frameInfo"
+#define kListTexturesFlag		"-ltx"
+#define kListTexturesFlagLong	"-listTextures"
+#define kCountOnlyFlag			"-co"
+#define kCountOnlyFlagLong		"-countOnly"
+#define kTextureChangesFlag		"-tch"
+#define kTextureChangesFlagLong	"-textureChanges"
+#define kWatchRootsFlag			"-wr"
+#define kWatchRootsFlagLong		"-watchRoots"
+#define kListDirFlag			"-lsd"
+#define kListDirFlagLong		"-listDir"
+#define kFileExistsFlag			"-fex"
+#define kFileExistsFlagLong		"-fileExists"
+#define kDirCacheStatsFlag		"-dcs"
+#define kDirCacheStatsFlagLong	"-dirCacheStats"
+#define kDirChangedFlag			"-dch"
+#define kDirChangedFlagLong		"-dirChanged"
+#define kPlanSyncFlag			"-ps"
+#define kPlanSyncFlagLong		"-planSync"
+#define kCopyFilesFlag			"-cpf"
+#define kCopyFilesFlagLong		"-copyFiles"
+#define kFileSaveDialogFlag		"-fsd"
+#define kFileSaveDialogFlagLong	"-fileSaveDialog"
+#define kTitleFlag				"-t"
+#define kTitleFlagLong			"-title"
+#define kFilenameFlag			"-fn"
+#define kFilenameFlagLong		"-fileName"
+#define kDefExtFlag				"-ext"
+#define kDefExtFlagLong			"-extension"
+#define kFilterFlag				"-ft"
+#define kFilterFlagLong			"-filter"
+
+
+MStatus mayaSvn::doIt( const MArgList& args )
+//
+//	Description:
+//		implements the MEL mayaSvn command.
+//
+//	Arguments:
+//		args - the argument list that was passes to the command from MEL
+//
+//	Return Value:
+//		MS::kSuccess - command succeeded
+//		MS::kFailure - command failed (returning this value will cause the
+//                     MEL script that is being run to terminate unless the
+//                     error is caught using a "catch" statement.
+//
+{
+	MStatus stat;
+	MArgDatabase	argData(syntax(), args);
+
+	dbgReset();
+
+	g_bDebug = argData.isFlagSet(kDebugFlag);
+	dbgSetDebug(g_bDebug);
+
+    if (argData.isFlagSet(kListEventsFlag))
+	{
+		MStringArray eventList;
+
+		listEvents(eventList);
+		clearResult();
+		setResult(eventList);
+	}
+	else if (argData.isFlagSet(kListAllScriptsFlag))
+	{
+		MStringArray scriptList;
+
+		listAllScripts(scriptList);
+		clearResult();
+		setResult(scriptList);
+	}
+	else if (argData.isFlagSet(kGetFilenameFlag))
+	{
+		MString	nameType;
+		MString	filename;
+
+		argData.getFlagArgument(kGetFilenameFlag, 0, nameType);
+		if (!getFilename(nameType, filename))
 		{
-			if (*s == '|')
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(filename);
+	}
+	else if (argData.isFlagSet(kListScriptsFlag))
+	{
+		MString	eventLabel;
+		MStringArray scriptList;
+
+		argData.getFlagArgument(kListScriptsFlag, 0, eventLabel);
+
+		if (!listScripts(eventLabel,scriptList))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(scriptList);
+	}
+	else if (argData.isFlagSet(kAddEventFlag))
+	{
+		MString	eventLabel;
+		MString	scriptName;
+		MString	melScript;
+		int		priority = 0;
+		int		debounceMs = -1;
+		bool	bDisplayEnabled;
+		bool	bUndoEnabled;
+
+		if (!argData.isFlagSet(kScriptNameFlag))
+		{
+			errPrintf ("no -scriptName specified\n");
+			return MStatus::kFailure;
+		}
+		if (!argData.isFlagSet(kMelFlag))
+		{
+			errPrintf ("no -mel specified\n");
+			return MStatus::kFailure;
+		}
+
+		argData.getFlagArgument(kAddEventFlag, 0, eventLabel);
+		argData.getFlagArgument(kScriptNameFlag, 0, scriptName);
+		argData.getFlagArgument(kMelFlag, 0, melScript);
+
+		bDisplayEnabled = argData.isFlagSet(kDisplayEnabledFlag);
+		bUndoEnabled    = argData.isFlagSet(kUndoEnabledFlag);
+		if (argData.isFlagSet(kPriorityFlag))
+		{
+			argData.getFlagArgument(kPriorityFlag, 0, priority);
+		}
+		if (argData.isFlagSet(kDebounceFlag))
+		{
+			argData.getFlagArgument(kDebounceFlag, 0, debounceMs);
+		}
+
+		if (!addEventScript(eventLabel, scriptName, melScript, priority, debounceMs, bDisplayEnabled, bUndoEnabled))
+		{
+			return MStatus::kFailure;
+		}
+	}
+	else if (argData.isFlagSet(kSaveRegistryFlag))
+	{
+		MString filename;
+
+		argData.getFlagArgument(kSaveRegistryFlag, 0, filename);
+		if (!saveRegistry(filename))
+		{
+			return MStatus::kFailure;
+		}
+	}
+	else if (argData.isFlagSet(kLoadRegistryFlag))
+	{
+		MString filename;
+
+		argData.getFlagArgument(kLoadRegistryFlag, 0, filename);
+		if (!loadRegistry(filename))
+		{
+			return MStatus::kFailure;
+		}
+	}
+	else if (argData.isFlagSet(kGetNodesFlag))
+	{
+		// only has something while a node event's scripts are running
+		clearResult();
+		setResult(s_deliveringNodes);
+	}
+	else if (argData.isFlagSet(kDelEventFlag))
+	{
+		MString	eventLabel;
+		MString	scriptName;
+
+		if (!argData.isFlagSet(kScriptNameFlag))
+		{
+			errPrintf ("no -scriptName specified\n");
+			return MStatus::kFailure;
+		}
+
+		argData.getFlagArgument(kDelEventFlag, 0, eventLabel);
+		argData.getFlagArgument(kScriptNameFlag, 0, scriptName);
+
+		if (!delEventScript(eventLabel, scriptName))
+		{
+			return MStatus::kFailure;
+		}
+	}
+	else if (argData.isFlagSet(kCompareFilesFlag))
+	{
+		MString file1;
+		MString file2;
+
+		if (!argData.isFlagSet(kFile2Flag))
+		{
+			errPrintf ("no -file2 specified\n");
+			return MStatus::kFailure;
+		}
+
+		if (argData.isFlagSet(kBatchFlag))
+		{
+			// mayaSvn -batch -cf a1 -f2 b1 -cf a2 -f2 b2 ...
+			unsigned numFiles = argData.numberOfFlagUses(kCompareFilesFlag);
+			MStringArray files1;
+			MStringArray files2;
+			MIntArray results;
+
+			if (argData.numberOfFlagUses(kFile2Flag) != numFiles)
 			{
-				*d = '\0';
+				errPrintf ("need the same number of -compareFiles and -file2 flags\n");
+				return MStatus::kFailure;
 			}
-			else
+
+			for (unsigned ii = 0; ii < numFiles; ++ii)
 			{
-				*d = *s;
+				MArgList args1;
+				MArgList args2;
+
+				argData.getFlagArgumentList(kCompareFilesFlag, ii, args1);
+				argData.getFlagArgumentList(kFile2Flag, ii, args2);
+				files1.append(args1.asString(0));
+				files2.append(args2.asString(0));
 			}
-			++d;
-			++s;
+
+			compareFileList(files1, files2, results);
+			hiSave();
+			clearResult();
+			setResult(results);
+		}
+		else if (argData.isFlagSet(kCompareInfoFlag))
+		{
+			// [0] = 1 same, 0 different, [1] = bytes read from each file, [2] = file size
+			FileCompareResult result;
+			MDoubleArray info;
+
+			argData.getFlagArgument(kCompareFilesFlag, 0, file1);
+			argData.getFlagArgument(kFile2Flag, 0, file2);
+
+			compareFiles(file1, file2, &result);
+			hiSave();
+			info.append(result.bSame ? 1.0 : 0.0);
+			info.append((double)(__int64)result.bytesRead);
+			info.append((double)(__int64)result.fileSize);
+			clearResult();
+			setResult(info);
+		}
+		else
+		{
+			argData.getFlagArgument(kCompareFilesFlag, 0, file1);
+			argData.getFlagArgument(kFile2Flag, 0, file2);
+
+			bool bSame = compareFiles(file1, file2);
+			hiSave();
+			clearResult();
+			setResult(bSame);
 		}
-		*d++ = '\0';
-		*d++ = '\0';
 	}
+	else if (argData.isFlagSet(kIndexFileFlag))
+	{
+		MString filename;
 
-	if (filename.length() < MAX_PATH - 1)
+		argData.getFlagArgument(kIndexFileFlag, 0, filename);
+		hiSetIndexFile(filename.asChar());
+	}
+	else if (argData.isFlagSet(kHashFileFlag))
 	{
-		const char* s = filename.asChar();
-		char* d = filenameBuffer;
+		MString filename;
+		MString hash;
 
-		while (*s)
+		argData.getFlagArgument(kHashFileFlag, 0, filename);
+		if (!hashFile(filename, hash))
 		{
-			if (*s == '/')
+			return MStatus::kFailure;
+		}
+		hiSave();
+		clearResult();
+		setResult(hash);
+	}
+	else if (argData.isFlagSet(kIndexStatsFlag))
+	{
+		MStringArray stats;
+
+		indexStats(stats);
+		clearResult();
+		setResult(stats);
+	}
+	else if (argData.isFlagSet(kInvalidateIndexFlag))
+	{
+		MString filename;
+
+		// "" = everything
+		argData.getFlagArgument(kInvalidateIndexFlag, 0, filename);
+		hiInvalidate(filename.asChar());
+		hiSave();
+	}
+	else if (argData.isFlagSet(kWcInfoFlag))
+	{
+		MString path;
+		MStringArray info;
+
+		argData.getFlagArgument(kWcInfoFlag, 0, path);
+		if (!wcInfo(path, info))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(info);
+	}
+	else if (argData.isFlagSet(kWcStatusFlag))
+	{
+		MString path;
+		MString status;
+
+		argData.getFlagArgument(kWcStatusFlag, 0, path);
+		if (!wcStatus(path, status))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(status);
+	}
+	else if (argData.isFlagSet(kSvnFlag))
+	{
+		MString subcommand;
+		MString message;
+		MStringArray paths;
+		MStringArray results;
+
+		argData.getFlagArgument(kSvnFlag, 0, subcommand);
+		if (argData.isFlagSet(kMessageFlag)) { argData.getFlagArgument(kMessageFlag, 0, message); }
+		argData.getObjects(paths);
+
+		if (!scIsSubcommand(subcommand.asChar()))
+		{
+			errPrintf ("unknown svn subcommand (%s)\n", subcommand.asChar());
+			return MStatus::kFailure;
+		}
+		if (paths.length() == 0)
+		{
+			errPrintf ("no paths given for svn %s\n", subcommand.asChar());
+			return MStatus::kFailure;
+		}
+		if (argData.isFlagSet(kAsyncFlag))
+		{
+			MString callback;
+
+			if (argData.isFlagSet(kCallbackFlag)) { argData.getFlagArgument(kCallbackFlag, 0, callback); }
+
+			int id = svnRunAsync(subcommand, paths, message, callback);
+			if (!id)
 			{
-				*d++ = '\\';
+				return MStatus::kFailure;
 			}
-			else
+			clearResult();
+			setResult(id);
+		}
+		else
+		{
+			if (!svnRun(subcommand, paths, message, results))
 			{
-				*d++ = *s;
+				return MStatus::kFailure;
 			}
-			++s;
+			clearResult();
+			setResult(results);
 		}
-		*d = '\0';
 	}
-
-	memset(&ofn, 0, sizeof(ofn));
-	ofn.lStructSize = sizeof(OPENFILENAME);
-	ofn.lpstrFilter = filter.length() > 0 ? filterBuffer : NULL;
-	ofn.lpstrFile   = filenameBuffer;
-	ofn.nMaxFile    = MAX_PATH;
-	ofn.lpstrTitle  = title.asChar();
-	ofn.Flags       = OFN_NOCHANGEDIR | OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
-	ofn.lpstrDefExt = defExt.length() > 0 ? defExt.asChar() : NULL;
-
-	MString result;
-
-	if (GetSaveFileName(&ofn))
+	else if (argData.isFlagSet(kLockFlag) || argData.isFlagSet(kUnlockFlag))
 	{
-		result = ofn.lpstrFile;
+		// mayaSvn -lock [-message "comment"] path1 path2 ...
+		// one result per path: "acquired", "held:<user>", "error:<msg>"
+		// mayaSvn -unlock path1 path2 ...
+		// one result per path: "released", "error:<msg>"
+		bool bLock = argData.isFlagSet(kLockFlag);
+		MString comment;
+		MStringArray paths;
+		MStringArray outcomes;
+
+		if (argData.isFlagSet(kMessageFlag)) { argData.getFlagArgument(kMessageFlag, 0, comment); }
+		argData.getObjects(paths);
+		if (paths.length() == 0)
+		{
+			errPrintf ("no paths given to %s\n", bLock ? "lock" : "unlock");
+			return MStatus::kFailure;
+		}
+		if (!lockPaths(paths, comment, bLock, outcomes))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(outcomes);
 	}
+	else if (argData.isFlagSet(kLockOwnerFlag))
+	{
+		// one result per path: owner, "" if unlocked or "error:<msg>"
+		MStringArray paths;
+		MStringArray owners;
 
-	return result;
-}
+		argData.getObjects(paths);
+		if (!lockOwners(paths, owners))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(owners);
+	}
+	else if (argData.isFlagSet(kExecFlag))
+	{
+		// 5 results per command, see execCommands.  A command that
+		// can't be started gets exitCode=-1 and the reason in stderr
+		// mayaSvn -exec "cmd" [-timeout secs]
+		// mayaSvn -batch -exec "cmd1" -exec "cmd2" ... runs them at the same time
+		unsigned numCmds = argData.isFlagSet(kBatchFlag) ? argData.numberOfFlagUses(kExecFlag) : 1;
+		double timeout = 0.0;
+		MStringArray cmdLines;
+		MStringArray results;
+
+		if (argData.isFlagSet(kTimeoutFlag)) { argData.getFlagArgument(kTimeoutFlag, 0, timeout); }
+		for (unsigned ii = 0; ii < numCmds; ++ii)
+		{
+			MArgList cmdArgs;
 
-MStatus mayaSvn::install()
-{
-	MStatus stat;
+			argData.getFlagArgumentList(kExecFlag, ii, cmdArgs);
+			cmdLines.append(cmdArgs.asString(0));
+		}
 
-	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+		execCommands(cmdLines, timeout > 0.0 ? (unsigned)(timeout * 1000.0) : 0, results);
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kMaxProcsFlag))
 	{
-		MsgInfo& mi = msgInfos[ii];
+		int maxProcs;
 
-		if (!mi.bInstalled)
+		argData.getFlagArgument(kMaxProcsFlag, 0, maxProcs);
+		if (maxProcs > 0)
 		{
-			if (mi.bCheck)
-			{
-				mi.callbackId = MSceneMessage::addCallback(mi.msg, callbackCheckStub, &mi, &stat);
-			}
-			else
-			{
-				mi.callbackId = MSceneMessage::addCallback(mi.msg, callbackStub, &mi, &stat);
-			}
-			if (!stat)
-			{
-				errPrintf ("could not install callback for MSceneMessage::%s\n", mi.pLabel);
-				return stat;
-			}
-			mi.bInstalled = true;
-
-			dbgPrintf ("installed callback for MSceneMessage::%s\n", mi.pLabel);
+			prSetMaxProcs(maxProcs);
+		}
+		clearResult();
+		setResult(prGetMaxProcs());
+	}
+	else if (argData.isFlagSet(kJobStatusFlag))
+	{
+		int id;
+		StringList jobResults;
+		MStringArray results;
+
+		// [0] = state, the rest are the results once it's finished
+		argData.getFlagArgument(kJobStatusFlag, 0, id);
+		results.append(aqStateName(aqGetStatus(id, &jobResults)));
+		for (size_t ii = 0; ii < jobResults.size(); ++ii)
+		{
+			results.append(jobResults[ii].c_str());
 		}
+		clearResult();
+		setResult(results);
 	}
+	else if (argData.isFlagSet(kCancelFlag))
+	{
+		int id;
 
-	statPrintf ("installed mayaSvn\n");
+		argData.getFlagArgument(kCancelFlag, 0, id);
+		clearResult();
+		setResult(aqCancel(id) ? 1 : 0);
+	}
+	else if (argData.isFlagSet(kRefreshStatusFlag))
+	{
+		MString root;
+		string error;
 
-	return stat;
-}
+		argData.getFlagArgument(kRefreshStatusFlag, 0, root);
+		if (!stRefresh(root.asChar(), argData.isFlagSet(kFullRefreshFlag), &error))
+		{
+			errPrintf ("could not get status of \"%s\": %s\n", root.asChar(), error.c_str());
+			return MStatus::kFailure;
+		}
+	}
+	else if (argData.isFlagSet(kCachedStatusFlag))
+	{
+		MString path;
+		MStringArray info;
 
-MStatus mayaSvn::remove()
-{
-	MStatus stat;
+		argData.getFlagArgument(kCachedStatusFlag, 0, path);
+		cachedStatus(path, info);
+		clearResult();
+		setResult(info);
+	}
+	else if (argData.isFlagSet(kStatusCacheStatsFlag))
+	{
+		MStringArray stats;
 
-	statPrintf ("mayaSvn: removing all callbacks\n");
+		statusCacheStats(stats);
+		clearResult();
+		setResult(stats);
+	}
+	else if (argData.isFlagSet(kLockStatusFlag))
+	{
+		MStringArray paths;
+		MStringArray states;
 
-	for (int ii = 0; ii < NUM_TABLE_ELEMENTS(msgInfos); ++ii)
+		argData.getObjects(paths);
+		lockStates(paths, states);
+		clearResult();
+		setResult(states);
+	}
+	else if (argData.isFlagSet(kLockCacheTTLFlag))
 	{
-		MsgInfo& mi = msgInfos[ii];
+		// -lockCacheTTL -1 just asks
+		int seconds;
 
-		if (mi.bInstalled)
+		argData.getFlagArgument(kLockCacheTTLFlag, 0, seconds);
+		if (seconds >= 0)
 		{
-			MSceneMessage::removeCallback(mi.callbackId);
-			mi.bInstalled = false;
-
-			dbgPrintf ("removed callback for MSceneMessage::%s\n", mi.pLabel);
+			lcSetTTL((unsigned)seconds);
 		}
+		clearResult();
+		setResult((int)lcGetTTL());
 	}
+	else if (argData.isFlagSet(kLockCacheStatsFlag))
+	{
+		MStringArray stats;
 
-	return stat;
-}
-
-#define kDebugFlag				"-d"
-#define kDebugFlagLong			"-debug"
-#define kListEventsFlag			"-le"
-#define kListEventsFlagLong		"-listEvents"
-#define kListScriptsFlag		"-ls"
-#define kListScriptsFlagLong	"-listScripts"
-#define kListAllScriptsFlag		"-las"
-#define kListAllScriptsFlagLong	"-listAllScripts"
-#define kAddEventFlag			"-ae"
-#define kAddEventFlagLong		"-addEvent"
-#define kDelEventFlag			"-de"
-#define kDelEventFlagLong		"-delEvent"
-#define kScriptNameFlag			"-sn"
-#define kScriptNameFlagLong		"-scriptName"
-#define kMelFlag				"-mel"
-#define kMelFlagLong			"-melScript"
-#define kDisplayEnabledFlag		"-ds"
-#define kDisplayEnabledFlagLong	"-displayEnabled"
-#define kUndoEnabledFlag		"-ue"
-#define kUndoEnabledFlagLong	"-undoEnabled"
-#define kGetFilenameFlag		"-gf"
-#define kGetFilenameFlagLong	"-getFilename"
-#define kCompareFilesFlag		"-cf"
-#define kCompareFilesFlagLong	"-compareFiles"
-#define kFile2Flag				"-f2"
-#define kFile2FlagLong			"-file2"
-#define kFileSaveDialogFlag		"-fsd"
-#define kFileSaveDialogFlagLong	"-fileSaveDialog"
-#define kTitleFlag				"-t"
-#define kTitleFlagLong			"-title"
-#define kFilenameFlag			"-fn"
-#define kFilenameFlagLong		"-fileName"
-#define kDefExtFlag				"-ext"
-#define kDefExtFlagLong			"-extension"
-#define kFilterFlag				"-ft"
-#define kFilterFlagLong			"-filter"
-
+		lockCacheStats(stats);
+		clearResult();
+		setResult(stats);
+	}
+	else if (argData.isFlagSet(kStatsFlag))
+	{
+		MStringArray stats;
 
-MStatus mayaSvn::doIt( const MArgList& args )
-//
-//	Description:
-//		implements the MEL mayaSvn command.
-//
-//	Arguments:
-//		args - the argument list that was passes to the command from MEL
-//
-//	Return Value:
-//		MS::kSuccess - command succeeded
-//		MS::kFailure - command failed (returning this value will cause the
-//                     MEL script that is being run to terminate unless the
-//                     error is caught using a "catch" statement.
-//
-{
-	MStatus stat;
-	MArgDatabase	argData(syntax(), args);
+		eventStats(stats);
+		clearResult();
+		setResult(stats);
+	}
+	else if (argData.isFlagSet(kResetStatsFlag))
+	{
+		resetEventStats();
+	}
+	else if (argData.isFlagSet(kLogFileFlag))
+	{
+		// -logFile "" closes the log
+		MString filename;
+		string error;
 
-	dbgReset();
+		argData.getFlagArgument(kLogFileFlag, 0, filename);
+		if (argData.isFlagSet(kLogLevelFlag))
+		{
+			int level;
 
-	g_bDebug = argData.isFlagSet(kDebugFlag);
-	dbgSetDebug(g_bDebug);
+			argData.getFlagArgument(kLogLevelFlag, 0, level);
+			alSetLevel(level);
+		}
+		if (!alSetLogFile(filename.asChar(), &error))
+		{
+			errPrintf ("could not log to \"%s\": %s\n", filename.asChar(), error.c_str());
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(MString(alGetLogFile().c_str()));
+	}
+	else if (argData.isFlagSet(kFindSequenceFlag))
+	{
+		MString path;
+		MStringArray results;
 
-    if (argData.isFlagSet(kListEventsFlag))
+		argData.getFlagArgument(kFindSequenceFlag, 0, path);
+		if (!findSequence(path, argData.isFlagSet(kFrameInfoFlag), results))
+		{
+			return MStatus::kFailure;
+		}
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kListTexturesFlag))
 	{
-		MStringArray eventList;
+		MStringArray results;
 
-		listEvents(eventList);
+		listTextures(argData.isFlagSet(kCountOnlyFlag), results);
 		clearResult();
-		setResult(eventList);
+		setResult(results);
 	}
-	else if (argData.isFlagSet(kListAllScriptsFlag))
+	else if (argData.isFlagSet(kTextureChangesFlag))
 	{
-		MStringArray scriptList;
+		// goes up the moment a file node is made, deleted or pointed
+		// somewhere else, not when FileTextureChanged gets around to it
+		clearResult();
+		setResult(s_textureChanges);
+	}
+	else if (argData.isFlagSet(kWatchRootsFlag))
+	{
+		// no paths just asks, "" stops watching
+		MStringArray paths;
+		MStringArray roots;
 
-		listAllScripts(scriptList);
+		argData.getObjects(paths);
+		bool bOk = watchRoots(paths, roots);
 		clearResult();
-		setResult(scriptList);
+		setResult(roots);
+		if (!bOk)
+		{
+			return MStatus::kFailure;
+		}
 	}
-	else if (argData.isFlagSet(kGetFilenameFlag))
+	else if (argData.isFlagSet(kListDirFlag))
 	{
-		MString	nameType;
-		MString	filename;
+		MString path;
+		MStringArray names;
 
-		argData.getFlagArgument(kGetFilenameFlag, 0, nameType);
-		if (!getFilename(nameType, filename))
+		argData.getFlagArgument(kListDirFlag, 0, path);
+		if (!listDir(path, names))
 		{
 			return MStatus::kFailure;
 		}
 		clearResult();
-		setResult(filename);
+		setResult(names);
 	}
-	else if (argData.isFlagSet(kListScriptsFlag))
+	else if (argData.isFlagSet(kFileExistsFlag))
 	{
-		MString	eventLabel;
-		MStringArray scriptList;
+		MStringArray paths;
+		MIntArray results;
 
-		argData.getFlagArgument(kListScriptsFlag, 0, eventLabel);
+		argData.getObjects(paths);
+		fileExists(paths, results);
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kDirChangedFlag))
+	{
+		// for folders MEL made itself, sysFile doesn't tell us
+		MStringArray paths;
 
-		if (!listScripts(eventLabel,scriptList))
+		argData.getObjects(paths);
+		for (unsigned ii = 0; ii < paths.length(); ++ii)
 		{
-			return MStatus::kFailure;
+			dcInvalidate(paths[ii].asChar());
 		}
 		clearResult();
-		setResult(scriptList);
+		setResult((int)paths.length());
 	}
-	else if (argData.isFlagSet(kAddEventFlag))
+	else if (argData.isFlagSet(kDirCacheStatsFlag))
 	{
-		MString	eventLabel;
-		MString	scriptName;
-		MString	melScript;
-		bool	bDisplayEnabled;
-		bool	bUndoEnabled;
+		MStringArray stats;
 
-		if (!argData.isFlagSet(kScriptNameFlag))
+		dirCacheStats(stats);
+		clearResult();
+		setResult(stats);
+	}
+	else if (argData.isFlagSet(kPlanSyncFlag))
+	{
+		// the objects are exclusion patterns
+		MString srcDir;
+		MString dstDir;
+		MStringArray exclusions;
+		MStringArray results;
+
+		argData.getFlagArgument(kPlanSyncFlag, 0, srcDir);
+		argData.getFlagArgument(kPlanSyncFlag, 1, dstDir);
+		argData.getObjects(exclusions);
+		if (!planSync(srcDir, dstDir, exclusions, results))
 		{
-			errPrintf ("no -scriptName specified\n");
 			return MStatus::kFailure;
 		}
-		if (!argData.isFlagSet(kMelFlag))
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kCopyFilesFlag))
+	{
+		// mayaSvn -cpf src1 -f2 dst1 -cpf src2 -f2 dst2 ...
+		unsigned numFiles = argData.numberOfFlagUses(kCopyFilesFlag);
+		MStringArray srcs;
+		MStringArray dsts;
+		MStringArray results;
+
+		if (argData.numberOfFlagUses(kFile2Flag) != numFiles)
 		{
-			errPrintf ("no -mel specified\n");
+			errPrintf ("need the same number of -copyFiles and -file2 flags\n");
 			return MStatus::kFailure;
 		}
 
-		argData.getFlagArgument(kAddEventFlag, 0, eventLabel);
-		argData.getFlagArgument(kScriptNameFlag, 0, scriptName);
-		argData.getFlagArgument(kMelFlag, 0, melScript);
+		for (unsigned ii = 0; ii < numFiles; ++ii)
+		{
+			MArgList args1;
+			MArgList args2;
 
-		bDisplayEnabled = argData.isFlagSet(kDisplayEnabledFlag);
-		bUndoEnabled    = argData.isFlagSet(kUndoEnabledFlag);
+			argData.getFlagArgumentList(kCopyFilesFlag, ii, args1);
+			argData.getFlagArgumentList(kFile2Flag, ii, args2);
+			srcs.append(args1.asString(0));
+			dsts.append(args2.asString(0));
+		}
+
+		// failed copies are in the results, it's up to the caller
+		copyFiles(srcs, dsts, results);
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kRecordEventsFlag))
+	{
+		// -recordEvents "" stops
+		MString filename;
 
-		if (!addEventScript(eventLabel, scriptName, melScript, bDisplayEnabled, bUndoEnabled))
+		argData.getFlagArgument(kRecordEventsFlag, 0, filename);
+		if (!recordEvents(filename))
 		{
 			return MStatus::kFailure;
 		}
 	}
-	else if (argData.isFlagSet(kDelEventFlag))
+	else if (argData.isFlagSet(kReplayEventsFlag))
 	{
-		MString	eventLabel;
-		MString	scriptName;
+		MString filename;
+		MStringArray results;
 
-		if (!argData.isFlagSet(kScriptNameFlag))
+		argData.getFlagArgument(kReplayEventsFlag, 0, filename);
+		s_bDryRun = argData.isFlagSet(kDryRunFlag);
+		bool bOk = replayEvents(filename, results);
+		s_bDryRun = false;
+		if (!bOk)
 		{
-			errPrintf ("no -scriptName specified\n");
 			return MStatus::kFailure;
 		}
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kBenchmarkFlag))
+	{
+		int scriptsPerEvent;
+		MStringArray results;
 
-		argData.getFlagArgument(kAddEventFlag, 0, eventLabel);
-		argData.getFlagArgument(kScriptNameFlag, 0, scriptName);
+		argData.getFlagArgument(kBenchmarkFlag, 0, scriptsPerEvent);
+		if (scriptsPerEvent < 0)
+		{
+			errPrintf ("-benchmark needs 0 or more scripts per event\n");
+			return MStatus::kFailure;
+		}
+		benchmark(scriptsPerEvent, results);
+		clearResult();
+		setResult(results);
+	}
+	else if (argData.isFlagSet(kTraceStartFlag))
+	{
+		MString filename;
+		string error;
 
-		if (!delEventScript(eventLabel, scriptName))
+		argData.getFlagArgument(kTraceStartFlag, 0, filename);
+		if (!trStart(filename.asChar(), &error))
 		{
+			errPrintf ("could not start trace: %s\n", error.c_str());
 			return MStatus::kFailure;
 		}
 	}
-	else if (argData.isFlagSet(kCompareFilesFlag))
+	else if (argData.isFlagSet(kTraceStopFlag))
 	{
-		MString file1;
-		MString file2;
+		// returns the file so it can be handed straight to a viewer
+		string filename = trGetFile();
+		string error;
+		int numEvents;
 
-		if (!argData.isFlagSet(kFile2Flag))
+		if (!trStop(&numEvents, &error))
 		{
-			errPrintf ("no -file2 specified\n");
+			errPrintf ("could not write trace: %s\n", error.c_str());
 			return MStatus::kFailure;
 		}
+		dbgPrintf ("wrote %d spans to \"%s\"\n", numEvents, filename.c_str());
+		clearResult();
+		setResult(MString(filename.c_str()));
+	}
+	else if (argData.isFlagSet(kLogLevelFlag))
+	{
+		// 0 errors, 1 +warnings, 2 +status, 3 +debug.  -1 just asks
+		int level;
 
-		argData.getFlagArgument(kCompareFilesFlag, 0, file1);
-		argData.getFlagArgument(kFile2Flag, 0, file2);
+		argData.getFlagArgument(kLogLevelFlag, 0, level);
+		if (level >= 0)
+		{
+			alSetLevel(level);
+		}
+		clearResult();
+		setResult(alGetLevel());
+	}
+	else if (argData.isFlagSet(kStatsEnabledFlag))
+	{
+		// -statsEnabled -1 just asks
+		int on;
 
+		argData.getFlagArgument(kStatsEnabledFlag, 0, on);
+		if (on >= 0)
+		{
+			esSetEnabled(on != 0);
+		}
 		clearResult();
-		setResult(compareFiles(file1, file2));
+		setResult(esGetEnabled() ? 1 : 0);
 	}
 	else if (argData.isFlagSet(kFileSaveDialogFlag))
 	{
@@ -796,6 +3545,61 @@ MSyntax mayaSvn::newSyntax()
 
 	syntax.addFlag(kCompareFilesFlag, kCompareFilesFlagLong, MSyntax::kString);
 	syntax.addFlag(kFile2Flag, kFile2FlagLong, MSyntax::kString);
+	syntax.addFlag(kCompareInfoFlag, kCompareInfoFlagLong);
+	syntax.addFlag(kBatchFlag, kBatchFlagLong);
+	syntax.makeFlagMultiUse(kCompareFilesFlag);
+	syntax.makeFlagMultiUse(kFile2Flag);
+	syntax.addFlag(kIndexFileFlag, kIndexFileFlagLong, MSyntax::kString);
+	syntax.addFlag(kHashFileFlag, kHashFileFlagLong, MSyntax::kString);
+	syntax.addFlag(kIndexStatsFlag, kIndexStatsFlagLong);
+	syntax.addFlag(kInvalidateIndexFlag, kInvalidateIndexFlagLong, MSyntax::kString);
+	syntax.addFlag(kWcInfoFlag, kWcInfoFlagLong, MSyntax::kString);
+	syntax.addFlag(kWcStatusFlag, kWcStatusFlagLong, MSyntax::kString);
+	syntax.addFlag(kSvnFlag, kSvnFlagLong, MSyntax::kString);
+	syntax.addFlag(kMessageFlag, kMessageFlagLong, MSyntax::kString);
+	syntax.addFlag(kExecFlag, kExecFlagLong, MSyntax::kString);
+	syntax.makeFlagMultiUse(kExecFlag);
+	syntax.addFlag(kTimeoutFlag, kTimeoutFlagLong, MSyntax::kDouble);
+	syntax.addFlag(kMaxProcsFlag, kMaxProcsFlagLong, MSyntax::kLong);
+	syntax.addFlag(kLockFlag, kLockFlagLong);
+	syntax.addFlag(kUnlockFlag, kUnlockFlagLong);
+	syntax.addFlag(kLockOwnerFlag, kLockOwnerFlagLong);
+	syntax.addFlag(kAsyncFlag, kAsyncFlagLong);
+	syntax.addFlag(kCallbackFlag, kCallbackFlagLong, MSyntax::kString);
+	syntax.addFlag(kJobStatusFlag, kJobStatusFlagLong, MSyntax::kLong);
+	syntax.addFlag(kCancelFlag, kCancelFlagLong, MSyntax::kLong);
+	syntax.setObjectType(MSyntax::kStringObjects);
+	syntax.addFlag(kRefreshStatusFlag, kRefreshStatusFlagLong, MSyntax::kString);
+	syntax.addFlag(kFullRefreshFlag, kFullRefreshFlagLong);
+	syntax.addFlag(kCachedStatusFlag, kCachedStatusFlagLong, MSyntax::kString);
+	syntax.addFlag(kStatusCacheStatsFlag, kStatusCacheStatsFlagLong);
+	syntax.addFlag(kLockStatusFlag, kLockStatusFlagLong);
+	syntax.addFlag(kLockCacheTTLFlag, kLockCacheTTLFlagLong, MSyntax::kLong);
+	syntax.addFlag(kLockCacheStatsFlag, kLockCacheStatsFlagLong);
+	syntax.addFlag(kStatsFlag, kStatsFlagLong);
+	syntax.addFlag(kResetStatsFlag, kResetStatsFlagLong);
+	syntax.addFlag(kStatsEnabledFlag, kStatsEnabledFlagLong, MSyntax::kLong);
+	syntax.addFlag(kLogFileFlag, kLogFileFlagLong, MSyntax::kString);
+	syntax.addFlag(kLogLevelFlag, kLogLevelFlagLong, MSyntax::kLong);
+	syntax.addFlag(kTraceStartFlag, kTraceStartFlagLong, MSyntax::kString);
+	syntax.addFlag(kTraceStopFlag, kTraceStopFlagLong);
+	syntax.addFlag(kRecordEventsFlag, kRecordEventsFlagLong, MSyntax::kString);
+	syntax.addFlag(kReplayEventsFlag, kReplayEventsFlagLong, MSyntax::kString);
+	syntax.addFlag(kBenchmarkFlag, kBenchmarkFlagLong, MSyntax::kLong);
+	syntax.addFlag(kDryRunFlag, kDryRunFlagLong);
+	syntax.addFlag(kFindSequenceFlag, kFindSequenceFlagLong, MSyntax::kString);
+	syntax.addFlag(kFrameInfoFlag, kFrameInfoFlagLong);
+	syntax.addFlag(kListTexturesFlag, kListTexturesFlagLong);
+	syntax.addFlag(kCountOnlyFlag, kCountOnlyFlagLong);
+	syntax.addFlag(kTextureChangesFlag, kTextureChangesFlagLong);
+	syntax.addFlag(kWatchRootsFlag, kWatchRootsFlagLong);
+	syntax.addFlag(kListDirFlag, kListDirFlagLong, MSyntax::kString);
+	syntax.addFlag(kFileExistsFlag, kFileExistsFlagLong);
+	syntax.addFlag(kDirCacheStatsFlag, kDirCacheStatsFlagLong);
+	syntax.addFlag(kDirChangedFlag, kDirChangedFlagLong);
+	syntax.addFlag(kPlanSyncFlag, kPlanSyncFlagLong, MSyntax::kString, MSyntax::kString);
+	syntax.addFlag(kCopyFilesFlag, kCopyFilesFlagLong, MSyntax::kString);
+	syntax.makeFlagMultiUse(kCopyFilesFlag);
 	syntax.addFlag(kFileSaveDialogFlag, kFileSaveDialogFlagLong);
 	syntax.addFlag(kTitleFlag, kTitleFlagLong, MSyntax::kString);
 	syntax.addFlag(kFilenameFlag, kFilenameFlagLong, MSyntax::kString);
@@ -804,6 +3608,11 @@ MSyntax mayaSvn::newSyntax()
 
 	syntax.addFlag(kDisplayEnabledFlag, kDisplayEnabledFlagLong);
 	syntax.addFlag(kUndoEnabledFlag, kUndoEnabledFlagLong);
+	syntax.addFlag(kPriorityFlag, kPriorityFlagLong, MSyntax::kLong);
+	syntax.addFlag(kDebounceFlag, kDebounceFlagLong, MSyntax::kLong);
+	syntax.addFlag(kGetNodesFlag, kGetNodesFlagLong);
+	syntax.addFlag(kSaveRegistryFlag, kSaveRegistryFlagLong, MSyntax::kString);
+	syntax.addFlag(kLoadRegistryFlag, kLoadRegistryFlagLong, MSyntax::kString);
 	syntax.addFlag(kListAllScriptsFlag, kListAllScriptsFlagLong);
 	syntax.addFlag(kDebugFlag, kDebugFlagLong);
 	syntax.addFlag(kListEventsFlag, kListEventsFlagLong);
@@ -834,19 +3643,65 @@ void* mayaSvn::creator()
 //
 //////////////////////////////////////////////////////////////////////////
 
+MAYASVN_API bool mayaSvnAddHandler(const char* pEvent, const char* pName, MayaSvnHandler pHandler, void* pUserData, int priority)
+{
+	if (!pHandler)
+	{
+		return false;
+	}
+	return mayaSvn::addEventHandler(pEvent, pName, pHandler, pUserData, priority);
+}
+
+MAYASVN_API bool mayaSvnRemoveHandler(const char* pEvent, const char* pName)
+{
+	return mayaSvn::delEventScript(pEvent, pName);
+}
+
 MStatus initializePlugin( MObject obj )
 {
 	MFnPlugin plugin( obj, "Greggman.com", "0.01");
 
 	mayaSvn::install();
+
+	// farm machines can skip the MEL that adds every script
+	const char* pRegistry = getenv("MAYASVN_REGISTRY");
+	if (pRegistry && *pRegistry)
+	{
+		mayaSvn::loadRegistry(pRegistry);
+	}
+
 	return plugin.registerCommand( "mayaSvn", mayaSvn::creator, mayaSvn::newSyntax);
 }
 
 MStatus uninitializePlugin( MObject obj)
 {
+	// the svn thread has to be stopped before our code goes away.  If
+	// it won't stop stay loaded rather than pull the code out from
+	// under it
+	if (!mayaSvn::drainJobs() || !aqShutdown())
+	{
+		errPrintf ("mayaSvn can not be unloaded while svn is still running\n");
+		return MStatus::kFailure;
+	}
+
 	// remove all the callbacks
 	mayaSvn::remove();
 
+	prShutdown();
+
+	// write out anything we learned
+	hiShutdown();
+	wcCloseAll();
+	stShutdown();
+	lcShutdown();
+	dcShutdown();
+	scShutdown();
+
+	trShutdown();
+
+	// last so everything above can still log
+	alShutdown();
+
 	MFnPlugin plugin( obj );
 	return plugin.deregisterCommand( "mayaSvn" );
 }
@@ -0,0 +1,66 @@
+/*=======================================================================*
+ |   file name : mayaSvnHandler.h
+ |-----------------------------------------------------------------------*
+ |   function  : C++ event handlers for mayaSvn
+ *=======================================================================*/
+
+/*
+   Other plugins can handle the same events as the MEL scripts added with
+   "mayaSvn -addEvent" without going through the MEL interpreter.
+   Handlers and MEL scripts on an event run together in priority order.
+
+   Link with mayaSvn.lib, or if mayaSvn might not be loaded
+
+	   MayaSvnAddHandlerFunc pAdd = (MayaSvnAddHandlerFunc)GetProcAddress(
+	   		GetModuleHandle("mayaSvn.mll"), "mayaSvnAddHandler");
+
+   Remove your handlers before your plugin unloads.
+*/
+
+#ifndef MAYASVNHANDLER_H
+#define MAYASVNHANDLER_H
+/**************************** i n c l u d e s ****************************/
+
+
+/*************************** c o n s t a n t s ***************************/
+
+#define MAYASVN_HANDLER_VERSION	1
+
+/******************************* t y p e s *******************************/
+
+struct MayaSvnEventContext
+{
+	int					version;	// MAYASVN_HANDLER_VERSION
+	const char*			pEvent;		// same names as "mayaSvn -listEvents"
+	const char*			pFilename;	// the file being opened, saved etc. "" if none
+	const char* const*	ppNodes;	// the nodes for NodeAdded etc, like -getNodes
+	unsigned			numNodes;
+	bool				bCheck;		// a *Check event, bCancel means something
+	bool				bCancel;	// set to stop the open/save/new
+};
+
+typedef void (*MayaSvnHandler)(MayaSvnEventContext* pContext, void* pUserData);
+
+typedef bool (*MayaSvnAddHandlerFunc)(const char* pEvent, const char* pName, MayaSvnHandler pHandler, void* pUserData, int priority);
+typedef bool (*MayaSvnRemoveHandlerFunc)(const char* pEvent, const char* pName);
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+#ifdef MAYASVN_EXPORTS
+#define MAYASVN_API	extern "C" __declspec(dllexport)
+#else
+#define MAYASVN_API	extern "C" __declspec(dllimport)
+#endif
+
+/************************** p r o t o t y p e s **************************/
+
+// a handler with the same name on the same event is replaced.  Lower
+// priorities run first, MEL scripts default to 0.
+MAYASVN_API bool mayaSvnAddHandler (const char* pEvent, const char* pName, MayaSvnHandler pHandler, void* pUserData, int priority);
+MAYASVN_API bool mayaSvnRemoveHandler (const char* pEvent, const char* pName);
+
+#endif /* MAYASVNHANDLER_H */
+
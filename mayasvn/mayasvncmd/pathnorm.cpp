@@ -0,0 +1,71 @@
+/*=======================================================================*
+ |   file name : pathnorm.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : turn paths into keys, doesn't touch the disk
+ *=======================================================================*/
+
+/*
+   Kept apart from pathutil.cpp so the code that only needs keys
+   (texmanifest, seqscan) builds without windows.h.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <ctype.h>
+#include <string.h>
+#include "pathnorm.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+/*************************************************************************
+                             puNormalizePath
+ *************************************************************************
+
+   SYNOPSIS
+		std::string puNormalizePath (const char* path)
+
+   PURPOSE
+		make a path we can use as a key.  Windows paths are case
+		insensitive and Maya hands us both / and \ so lowercase
+		everything, use / and remove any trailing /
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+std::string puNormalizePath (const char* path)
+{
+	std::string result;
+
+	result.reserve(strlen(path));
+	for (const char* s = path; *s; ++s)
+	{
+		char c = *s;
+		if (c == '\\')
+		{
+			c = '/';
+		}
+		result += (char)tolower((unsigned char)c);
+	}
+
+	while (result.size() > 1 && result[result.size() - 1] == '/')
+	{
+		result.erase(result.size() - 1);
+	}
+
+	return result;
+}
+
@@ -0,0 +1,30 @@
+/*=======================================================================*
+ |   file name : pathnorm.h
+ |-----------------------------------------------------------------------*
+ |   function  : turn paths into keys, doesn't touch the disk
+ *=======================================================================*/
+
+#ifndef PATHNORM_H
+#define PATHNORM_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern std::string puNormalizePath (const char* path);
+
+#endif /* PATHNORM_H */
+
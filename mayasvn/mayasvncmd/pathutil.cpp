@@ -0,0 +1,115 @@
+/*=======================================================================*
+ |   file name : pathutil.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : path and file info helpers
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "pathutil.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+static bool puListFiles (const char* dir, const char* namePrefix, std::vector<std::string>* pNames, std::string* pError, void* pContext);
+
+/***************************** g l o b a l s *****************************/
+
+const FsInterface g_diskFs = { puListFiles, NULL };
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+/*************************************************************************
+                             puGetPathInfo
+ *************************************************************************
+
+   SYNOPSIS
+		bool puGetPathInfo (const char* path, PathInfo* pInfo)
+
+   PURPOSE
+		get size, modification time and type of a file without
+		opening it.
+
+   RETURNS
+		true if the path exists
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool puGetPathInfo (const char* path, PathInfo* pInfo)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	pInfo->bExists = false;
+	pInfo->bIsDir  = false;
+	pInfo->size    = 0;
+	pInfo->mtime   = 0;
+
+	if (!GetFileAttributesEx(path, GetFileExInfoStandard, &data))
+	{
+		return false;
+	}
+
+	pInfo->bExists = true;
+	pInfo->bIsDir  = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	pInfo->size    = ((unsigned __int64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	pInfo->mtime   = FILETIME_TO_U64(data.ftLastWriteTime);
+
+	return true;
+}
+
+unsigned __int64 puGetCurrentFileTime ()
+{
+	FILETIME ft;
+
+	GetSystemTimeAsFileTime(&ft);
+	return FILETIME_TO_U64(ft);
+}
+
+// FsListFilesFunc for the real disk, one FindFirstFile for prefix*
+static bool puListFiles (const char* dir, const char* namePrefix, std::vector<std::string>* pNames, std::string* pError, void* pContext)
+{
+	WIN32_FIND_DATA	fd;
+	std::string		pattern = std::string(dir) + namePrefix + "*";
+	HANDLE			hFind = FindFirstFile(pattern.c_str(), &fd);
+
+	pNames->clear();
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		DWORD err = GetLastError();
+
+		if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND || err == ERROR_NO_MORE_FILES)
+		{
+			return true;
+		}
+		char buf[64];
+		sprintf(buf, "could not list directory (error %lu)", (unsigned long)err);
+		*pError = buf;
+		return false;
+	}
+	do
+	{
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			pNames->push_back(fd.cFileName);
+		}
+	} while (FindNextFile(hFind, &fd));
+
+	FindClose(hFind);
+	return true;
+}
+
@@ -0,0 +1,43 @@
+/*=======================================================================*
+ |   file name : pathutil.h
+ |-----------------------------------------------------------------------*
+ |   function  : path and file info helpers
+ *=======================================================================*/
+
+#ifndef PATHUTIL_H
+#define PATHUTIL_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+#include "fsiface.h"
+#include "pathnorm.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct PathInfo
+{
+	bool				bExists;
+	bool				bIsDir;
+	unsigned __int64	size;
+	unsigned __int64	mtime;	// FILETIME as 100ns ticks
+};
+
+/***************************** g l o b a l s *****************************/
+
+extern const FsInterface g_diskFs;	// the real disk
+
+/****************************** m a c r o s ******************************/
+
+#define FILETIME_TO_U64(ft)	(((unsigned __int64)(ft).dwHighDateTime << 32) | (ft).dwLowDateTime)
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool puGetPathInfo (const char* path, PathInfo* pInfo);
+extern unsigned __int64 puGetCurrentFileTime ();
+
+#endif /* PATHUTIL_H */
+
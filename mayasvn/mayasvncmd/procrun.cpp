@@ -0,0 +1,346 @@
+/*=======================================================================*
+ |   file name : procrun.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : run a child process and capture its output
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+// job objects need win2k or better
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0500
+#endif
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "procrun.h"
+#include "trace.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define PR_READ_SIZE	(64 * 1024)
+#define PR_POLL_MS		10
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static bool				s_bInitialized;
+static CRITICAL_SECTION	s_cs;
+static HANDLE			s_slotFreed;	// set whenever a child finishes
+static int				s_maxProcs = PR_DEFAULT_MAX_PROCS;
+static int				s_numRunning;
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static void prInit ()
+{
+	if (!s_bInitialized)
+	{
+		InitializeCriticalSection(&s_cs);
+		s_slotFreed    = CreateEvent(NULL, FALSE, FALSE, NULL);
+		s_bInitialized = true;
+	}
+}
+
+// wait until fewer than s_maxProcs children are running
+static void prTakeSlot ()
+{
+	for (;;)
+	{
+		EnterCriticalSection(&s_cs);
+		if (s_numRunning < s_maxProcs)
+		{
+			++s_numRunning;
+			LeaveCriticalSection(&s_cs);
+			return;
+		}
+		LeaveCriticalSection(&s_cs);
+
+		// the timeout covers the case where 2 waiters get 1 SetEvent
+		WaitForSingleObject(s_slotFreed, 100);
+	}
+}
+
+static void prGiveSlot ()
+{
+	EnterCriticalSection(&s_cs);
+	--s_numRunning;
+	LeaveCriticalSection(&s_cs);
+	SetEvent(s_slotFreed);
+}
+
+static string prErrorText (const char* pWhat)
+{
+	char buf[256];
+
+	_snprintf (buf, sizeof(buf), "%s failed (error %lu)", pWhat, GetLastError());
+	buf[sizeof(buf) - 1] = '\0';
+	return string(buf);
+}
+
+// read whatever is waiting in a pipe without blocking.
+// returns false once the pipe is closed and empty
+static bool prDrainPipe (HANDLE pipe, string& buffer, vector<char>& chunk)
+{
+	for (;;)
+	{
+		DWORD avail = 0;
+
+		if (!PeekNamedPipe(pipe, NULL, 0, NULL, &avail, NULL))
+		{
+			return false;	// broken pipe, the child closed its end
+		}
+		if (!avail)
+		{
+			return true;
+		}
+
+		DWORD bytesRead = 0;
+		DWORD toRead    = avail < chunk.size() ? avail : (DWORD)chunk.size();
+		if (!ReadFile(pipe, &chunk[0], toRead, &bytesRead, NULL) || !bytesRead)
+		{
+			return false;
+		}
+		buffer.append(&chunk[0], bytesRead);
+	}
+}
+
+/*************************************************************************
+                              prRun
+ *************************************************************************
+
+   SYNOPSIS
+		bool prRun (const char* cmdLine, unsigned timeoutMs,
+					ProcResult* pResult, string* pError)
+
+   PURPOSE
+		run a command line and collect its stdout and stderr
+		separately.  Output is read as it is written so a chatty child
+		can't fill the pipe and stall.
+
+		The child gets NUL for stdin so it can't sit waiting for a
+		password.  It runs in a job object so if it times out it and
+		anything it started (ssh etc) are killed.
+
+		At most prGetMaxProcs children run at once.  Extra callers
+		wait for a slot.  The timeout starts once the child starts.
+
+		Safe to call from several threads.
+
+   INPUT
+		cmdLine   : like typed at a command prompt (no shell features)
+		timeoutMs : 0 = wait forever
+
+   RETURNS
+		false if the process could not be started (pError says why).
+		A child that runs and fails still returns true, check
+		exitCode and bTimedOut.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool prRun (const char* cmdLine, unsigned timeoutMs, ProcResult* pResult, string* pError)
+{
+	TraceSpan span("exec", "prRun");
+
+	span.setArg("cmdLine", cmdLine);
+	prInit();
+
+	pResult->exitCode    = -1;
+	pResult->wallSeconds = 0.0;
+	pResult->bTimedOut   = false;
+	pResult->out.erase();
+	pResult->err.erase();
+
+	SECURITY_ATTRIBUTES	sa;
+	HANDLE				outRead  = NULL;
+	HANDLE				outWrite = NULL;
+	HANDLE				errRead  = NULL;
+	HANDLE				errWrite = NULL;
+	HANDLE				nulIn    = INVALID_HANDLE_VALUE;
+	HANDLE				job      = NULL;
+	bool				bOk      = false;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nLength        = sizeof(sa);
+	sa.bInheritHandle = TRUE;
+
+	if (!CreatePipe(&outRead, &outWrite, &sa, 0) ||
+		!CreatePipe(&errRead, &errWrite, &sa, 0))
+	{
+		*pError = prErrorText("CreatePipe");
+		goto cleanup;
+	}
+
+	// our ends must not be inherited or the pipes never report closed
+	SetHandleInformation(outRead, HANDLE_FLAG_INHERIT, 0);
+	SetHandleInformation(errRead, HANDLE_FLAG_INHERIT, 0);
+
+	nulIn = CreateFile("NUL", GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, 0, NULL);
+
+	job = CreateJobObject(NULL, NULL);
+	if (job)
+	{
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli;
+
+		memset(&jeli, 0, sizeof(jeli));
+		jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+		SetInformationJobObject(job, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli));
+	}
+
+	{
+		STARTUPINFO			si;
+		PROCESS_INFORMATION	pi;
+		vector<char>		cmdBuf(cmdLine, cmdLine + strlen(cmdLine) + 1);	// CreateProcess wants it writable
+		vector<char>		chunk(PR_READ_SIZE);
+		LARGE_INTEGER		freq;
+		LARGE_INTEGER		start;
+		LARGE_INTEGER		now;
+
+		memset(&si, 0, sizeof(si));
+		si.cb         = sizeof(si);
+		si.dwFlags    = STARTF_USESTDHANDLES;
+		si.hStdInput  = nulIn;
+		si.hStdOutput = outWrite;
+		si.hStdError  = errWrite;
+
+		prTakeSlot();
+
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&start);
+
+		if (!CreateProcess(NULL, &cmdBuf[0], NULL, NULL, TRUE, CREATE_NO_WINDOW | CREATE_SUSPENDED, NULL, NULL, &si, &pi))
+		{
+			*pError = prErrorText("CreateProcess");
+			prGiveSlot();
+			goto cleanup;
+		}
+
+		if (job)
+		{
+			AssignProcessToJobObject(job, pi.hProcess);
+		}
+		ResumeThread(pi.hThread);
+		CloseHandle(pi.hThread);
+
+		// only the child has the write ends now
+		CloseHandle(outWrite);
+		CloseHandle(errWrite);
+		outWrite = NULL;
+		errWrite = NULL;
+
+		bool bOutOpen = true;
+		bool bErrOpen = true;
+		bool bExited  = false;
+
+		for (;;)
+		{
+			if (bOutOpen) { bOutOpen = prDrainPipe(outRead, pResult->out, chunk); }
+			if (bErrOpen) { bErrOpen = prDrainPipe(errRead, pResult->err, chunk); }
+
+			if (bExited)
+			{
+				// one last drain after exit picks up anything still
+				// in the pipes.  A grandchild could hold them open so
+				// we don't wait for them to close.
+				break;
+			}
+
+			bExited = WaitForSingleObject(pi.hProcess, PR_POLL_MS) == WAIT_OBJECT_0;
+			if (!bExited && timeoutMs)
+			{
+				QueryPerformanceCounter(&now);
+				if ((now.QuadPart - start.QuadPart) * 1000 / freq.QuadPart >= timeoutMs)
+				{
+					pResult->bTimedOut = true;
+					if (job)
+					{
+						TerminateJobObject(job, (UINT)-1);
+					}
+					else
+					{
+						TerminateProcess(pi.hProcess, (UINT)-1);
+					}
+					WaitForSingleObject(pi.hProcess, INFINITE);
+					bExited = true;
+				}
+			}
+		}
+
+		QueryPerformanceCounter(&now);
+		pResult->wallSeconds = (double)(now.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+
+		DWORD exitCode;
+		if (!pResult->bTimedOut && GetExitCodeProcess(pi.hProcess, &exitCode))
+		{
+			pResult->exitCode = (int)exitCode;
+		}
+		CloseHandle(pi.hProcess);
+
+		prGiveSlot();
+		bOk = true;
+	}
+
+cleanup:
+	if (outRead)  { CloseHandle(outRead); }
+	if (outWrite) { CloseHandle(outWrite); }
+	if (errRead)  { CloseHandle(errRead); }
+	if (errWrite) { CloseHandle(errWrite); }
+	if (nulIn != INVALID_HANDLE_VALUE) { CloseHandle(nulIn); }
+	if (job)      { CloseHandle(job); }
+
+	return bOk;
+}
+
+/*************************************************************************
+                              prSetMaxProcs
+ *************************************************************************
+
+   SYNOPSIS
+		void prSetMaxProcs (int maxProcs)
+
+   PURPOSE
+		set how many children prRun will let run at once.  Children
+		already running are not affected.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void prSetMaxProcs (int maxProcs)
+{
+	prInit();
+
+	EnterCriticalSection(&s_cs);
+	s_maxProcs = maxProcs < 1 ? 1 : maxProcs;
+	LeaveCriticalSection(&s_cs);
+	SetEvent(s_slotFreed);
+}
+
+int prGetMaxProcs ()
+{
+	return s_maxProcs;
+}
+
+void prShutdown ()
+{
+	if (s_bInitialized)
+	{
+		CloseHandle(s_slotFreed);
+		DeleteCriticalSection(&s_cs);
+		s_bInitialized = false;
+	}
+}
+
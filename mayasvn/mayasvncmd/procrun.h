@@ -0,0 +1,42 @@
+/*=======================================================================*
+ |   file name : procrun.h
+ |-----------------------------------------------------------------------*
+ |   function  : run a child process and capture its output
+ *=======================================================================*/
+
+#ifndef PROCRUN_H
+#define PROCRUN_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+/*************************** c o n s t a n t s ***************************/
+
+#define PR_DEFAULT_MAX_PROCS	4
+
+/******************************* t y p e s *******************************/
+
+struct ProcResult
+{
+	int			exitCode;		// -1 if it never ran or was killed
+	double		wallSeconds;
+	bool		bTimedOut;
+	std::string	out;			// everything written to stdout
+	std::string	err;			// everything written to stderr
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool prRun (const char* cmdLine, unsigned timeoutMs, ProcResult* pResult, std::string* pError);
+extern void prSetMaxProcs (int maxProcs);
+extern int  prGetMaxProcs ();
+extern void prShutdown ();
+
+#endif /* PROCRUN_H */
+
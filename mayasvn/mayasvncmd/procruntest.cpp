@@ -0,0 +1,94 @@
+/*=======================================================================*
+ |   file name : procruntest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the process runner
+ *=======================================================================*/
+
+/*
+   The children are all cmd.exe (and ping for something that takes a
+   while) so these run on any machine.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+
+#include "coretest.h"
+#include "procrun.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_NUM_LINES	5000	// enough to fill the pipe many times over
+#define CT_TIMEOUT_MS	200
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+void testProcRun ()
+{
+	ProcResult	result;
+	string		error;
+
+	// stdout and stderr come back separately
+	CHECK(prRun("cmd /c echo hello", 0, &result, &error));
+	CHECK(result.exitCode == 0);
+	CHECK(!result.bTimedOut);
+	CHECK(result.out == "hello\r\n");
+	CHECK(result.err.empty());
+
+	CHECK(prRun("cmd /c echo oops>&2", 0, &result, &error));
+	CHECK(result.out.empty());
+	CHECK(result.err == "oops\r\n");
+
+	CHECK(prRun("cmd /c exit 3", 0, &result, &error));
+	CHECK(result.exitCode == 3);
+
+	// a child that writes more than the pipe holds doesn't stall
+	char cmdLine[128];
+
+	_snprintf (cmdLine, sizeof(cmdLine), "cmd /c for /l %%i in (1,1,%d) do @echo line %%i", CT_NUM_LINES);
+	cmdLine[sizeof(cmdLine) - 1] = '\0';
+	CHECK(prRun(cmdLine, 0, &result, &error));
+	CHECK(result.exitCode == 0);
+	CHECK(std::count(result.out.begin(), result.out.end(), '\n') == CT_NUM_LINES);
+
+	// a timeout kills the child and anything it started
+	CHECK(prRun("cmd /c ping -n 30 127.0.0.1", CT_TIMEOUT_MS, &result, &error));
+	CHECK(result.bTimedOut);
+	CHECK(result.exitCode == -1);
+	CHECK(result.wallSeconds < 10.0);
+
+	// nothing to run
+	error.erase();
+	CHECK(!prRun("coretest_no_such_program", 0, &result, &error));
+	CHECK(!error.compare(0, 13, "CreateProcess"));
+	CHECK(result.exitCode == -1);
+
+	int maxProcs = prGetMaxProcs();
+
+	prSetMaxProcs(0);
+	CHECK(prGetMaxProcs() == 1);
+	CHECK(prRun("cmd /c echo one at a time", 0, &result, &error));
+	CHECK(result.out == "one at a time\r\n");
+	prSetMaxProcs(maxProcs);
+	CHECK(prGetMaxProcs() == maxProcs);
+
+	prShutdown();
+}
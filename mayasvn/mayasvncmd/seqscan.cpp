@@ -0,0 +1,285 @@
+/*=======================================================================*
+ |   file name : seqscan.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : find every frame of a numbered file sequence
+ *=======================================================================*/
+
+/*
+   Maya numbers file textures these ways
+
+     name#.ext   name.#.ext   name####.ext   name.####.ext
+     name.ext.#  name.ext.####
+     name.#      name.####
+
+   which comes down to: the frame is the digits right before the last
+   ".ext", or the last ".ext" is all digits and is the frame.  We split
+   the path we're given there into a prefix and a suffix and then list
+   the directory once, keeping every file that is prefix + digits +
+   suffix.  Padded and unpadded frames both match.
+
+   The listing goes through an FsInterface so none of this needs
+   windows.h.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "seqscan.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define SS_MAX_DIGITS	9	// more won't fit in an int
+
+/******************************* t y p e s *******************************/
+
+struct ltframe
+{
+	bool operator()(const SeqFrame& f1, const SeqFrame& f2) const
+	{
+		if (f1.frame != f2.frame)
+		{
+			return f1.frame < f2.frame;
+		}
+		return f1.digits < f2.digits;
+	}
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static bool ssAllDigits (const char* p, size_t len)
+{
+	if (!len)
+	{
+		return false;
+	}
+	for (size_t ii = 0; ii < len; ++ii)
+	{
+		if (p[ii] < '0' || p[ii] > '9')
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// windows file names don't care about case
+static bool ssSameNoCase (const char* p1, const char* p2, size_t len)
+{
+	for (size_t ii = 0; ii < len; ++ii)
+	{
+		if (tolower((unsigned char)p1[ii]) != tolower((unsigned char)p2[ii]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*************************************************************************
+                               ssSplitPath
+ *************************************************************************
+
+   SYNOPSIS
+		bool ssSplitPath (const char* path, string* pPrefix, string* pSuffix)
+
+   PURPOSE
+		split path around its frame number.  "x:/a/b.0010.tga" is
+		"x:/a/b." and ".tga".  Doesn't touch the disk.
+
+   RETURNS
+		false if path has no frame number
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool ssSplitPath (const char* path, string* pPrefix, string* pSuffix)
+{
+	string	full = path;
+	size_t	slash = full.find_last_of("/\\");
+	size_t	nameStart = slash == string::npos ? 0 : slash + 1;
+	size_t	dot  = full.rfind('.');
+	size_t	digitsStart;
+	size_t	digitsEnd;
+
+	if (dot != string::npos && dot < nameStart)
+	{
+		dot = string::npos;	// a dot in a folder name
+	}
+
+	if (dot != string::npos && ssAllDigits(full.c_str() + dot + 1, full.size() - dot - 1))
+	{
+		// name.#  name.ext.#
+		digitsStart = dot + 1;
+		digitsEnd   = full.size();
+	}
+	else
+	{
+		// name#.ext  name.#.ext
+		digitsEnd   = dot == string::npos ? full.size() : dot;
+		digitsStart = digitsEnd;
+		while (digitsStart > nameStart && full[digitsStart - 1] >= '0' && full[digitsStart - 1] <= '9')
+		{
+			--digitsStart;
+		}
+		if (digitsStart == digitsEnd)
+		{
+			return false;
+		}
+	}
+
+	*pPrefix = full.substr(0, digitsStart);
+	*pSuffix = full.substr(digitsEnd);
+	return true;
+}
+
+/*************************************************************************
+                             ssFindSequence
+ *************************************************************************
+
+   SYNOPSIS
+		bool ssFindSequence (const char* path, const FsInterface* pFs, SeqInfo* pInfo, string* pError)
+
+   PURPOSE
+		find every file in path's sequence.  path is any one frame, it
+		doesn't have to exist.  Lists the directory once through pFs,
+		usually &g_diskFs.
+
+   RETURNS
+		false if path has no frame number or the directory can't be
+		read.  No frames on disk is not an error.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool ssFindSequence (const char* path, const FsInterface* pFs, SeqInfo* pInfo, string* pError)
+{
+	pInfo->frames.clear();
+	pInfo->padding = 0;
+
+	if (!ssSplitPath(path, &pInfo->prefix, &pInfo->suffix))
+	{
+		*pError = string("no frame number in \"") + path + "\"";
+		return false;
+	}
+
+	size_t			slash      = pInfo->prefix.find_last_of("/\\");
+	string			dir        = slash == string::npos ? string() : pInfo->prefix.substr(0, slash + 1);
+	string			namePrefix = pInfo->prefix.substr(dir.size());
+	string			suffix     = pInfo->suffix;
+	vector<string>	names;
+
+	if (!pFs->listFiles(dir.c_str(), namePrefix.c_str(), &names, pError, pFs->pContext))
+	{
+		return false;
+	}
+
+	int numPadded = 0;
+
+	for (size_t ii = 0; ii < names.size(); ++ii)
+	{
+		const char*	entry  = names[ii].c_str();
+		size_t		len    = names[ii].size();
+
+		if (len <= namePrefix.size() + suffix.size() ||
+			!ssSameNoCase(entry, namePrefix.c_str(), namePrefix.size()) ||
+			!ssSameNoCase(entry + len - suffix.size(), suffix.c_str(), suffix.size()))
+		{
+			continue;
+		}
+
+		const char*	pDigits   = entry + namePrefix.size();
+		size_t		numDigits = len - namePrefix.size() - suffix.size();
+
+		if (numDigits > SS_MAX_DIGITS || !ssAllDigits(pDigits, numDigits))
+		{
+			continue;
+		}
+
+		SeqFrame frame;
+
+		frame.frame  = atoi(string(pDigits, numDigits).c_str());
+		frame.digits = (int)numDigits;
+		frame.path   = dir + entry;
+		pInfo->frames.push_back(frame);
+
+		if (numDigits > 1 && pDigits[0] == '0')
+		{
+			pInfo->padding = (int)numDigits;
+			++numPadded;
+		}
+	}
+
+	std::sort(pInfo->frames.begin(), pInfo->frames.end(), ltframe());
+
+	// only call it padded if every frame is the same width
+	for (size_t ii = 0; numPadded && ii < pInfo->frames.size(); ++ii)
+	{
+		if (pInfo->frames[ii].digits != pInfo->padding)
+		{
+			pInfo->padding = 0;
+			break;
+		}
+	}
+	return true;
+}
+
+/*************************************************************************
+                              ssFrameRanges
+ *************************************************************************
+
+   SYNOPSIS
+		string ssFrameRanges (const SeqInfo& info)
+
+   PURPOSE
+		the frames as "1-20,25,30-31"
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+string ssFrameRanges (const SeqInfo& info)
+{
+	string	ranges;
+	size_t	ii = 0;
+	char	buf[32];
+
+	while (ii < info.frames.size())
+	{
+		int		first = info.frames[ii].frame;
+		int		last  = first;
+
+		// same frame twice (padded and not) counts once
+		while (ii < info.frames.size() && info.frames[ii].frame <= last + 1)
+		{
+			last = info.frames[ii].frame;
+			++ii;
+		}
+
+		if (first == last)
+		{
+			sprintf(buf, "%s%d", ranges.empty() ? "" : ",", first);
+		}
+		else
+		{
+			sprintf(buf, "%s%d-%d", ranges.empty() ? "" : ",", first, last);
+		}
+		ranges += buf;
+	}
+	return ranges;
+}
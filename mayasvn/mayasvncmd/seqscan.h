@@ -0,0 +1,49 @@
+/*=======================================================================*
+ |   file name : seqscan.h
+ |-----------------------------------------------------------------------*
+ |   function  : find every frame of a numbered file sequence
+ *=======================================================================*/
+
+#ifndef SEQSCAN_H
+#define SEQSCAN_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+#include "fsiface.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct SeqFrame
+{
+	int				frame;
+	int				digits;		// how many digits the name used
+	std::string		path;		// same form as the path passed in
+};
+
+struct SeqInfo
+{
+	std::string				prefix;		// everything before the frame number
+	std::string				suffix;		// everything after it
+	int						padding;	// 0 = frames aren't zero padded
+	std::vector<SeqFrame>	frames;		// sorted by frame
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool ssSplitPath (const char* path, std::string* pPrefix, std::string* pSuffix);
+extern bool ssFindSequence (const char* path, const FsInterface* pFs, SeqInfo* pInfo, std::string* pError);
+extern std::string ssFrameRanges (const SeqInfo& info);
+
+#endif /* SEQSCAN_H */
+
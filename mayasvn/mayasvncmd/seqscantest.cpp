@@ -0,0 +1,105 @@
+/*=======================================================================*
+ |   file name : seqscantest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for finding texture frame sequences
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+#include "coretest.h"
+#include "seqscan.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static void testSplitPath ()
+{
+	string prefix;
+	string suffix;
+
+	CHECK(ssSplitPath("x:/a/b.0010.tga", &prefix, &suffix) && prefix == "x:/a/b." && suffix == ".tga");
+	CHECK(ssSplitPath("x:/a/b12.tga", &prefix, &suffix) && prefix == "x:/a/b" && suffix == ".tga");
+	CHECK(ssSplitPath("x:\\a\\b.tga.7", &prefix, &suffix) && prefix == "x:\\a\\b.tga." && suffix == "");
+	CHECK(ssSplitPath("b42", &prefix, &suffix) && prefix == "b" && suffix == "");
+	CHECK(!ssSplitPath("x:/a/b.tga", &prefix, &suffix));
+	CHECK(!ssSplitPath("x:/a.12/b.tga", &prefix, &suffix));
+}
+
+static void testFindSequence ()
+{
+	static const char* texNames[] =
+	{
+		"wood.0001.tga", "wood.0002.tga", "wood.0003.tga", "wood.0010.tga",
+		"WOOD.0011.TGA", "wood.0012.tif", "wood.tga", "wood.abcd.tga",
+		"woodgrain.0004.tga", "rock.tga",
+	};
+	static const char* seqNames[] =
+	{
+		"f1.iff", "f2.iff", "f10.iff",
+	};
+	static const char* dupNames[] =
+	{
+		"a.1.tga", "a.01.tga", "a.2.tga",
+	};
+
+	FakeFs		fake;
+	FsInterface	fs;
+	SeqInfo		info;
+	string		error;
+
+	ctInitFakeFs(&fake, &fs);
+	ctAddFakeFiles(&fake, "x:/tex", texNames, sizeof(texNames) / sizeof(texNames[0]));
+	ctAddFakeFiles(&fake, "x:/seq", seqNames, sizeof(seqNames) / sizeof(seqNames[0]));
+	ctAddFakeFiles(&fake, "x:/dup", dupNames, sizeof(dupNames) / sizeof(dupNames[0]));
+	fake.badDir = "x:/unreadable/";
+
+	// the frame asked for doesn't have to be there, the case of the
+	// names doesn't matter and other extensions aren't part of it
+	CHECK(ssFindSequence("x:/tex/wood.0005.tga", &fs, &info, &error));
+	CHECK(fake.numListings == 1);
+	CHECK(info.prefix == "x:/tex/wood." && info.suffix == ".tga");
+	CHECK(info.frames.size() == 5);
+	CHECK(info.padding == 4);
+	CHECK(ssFrameRanges(info) == "1-3,10-11");
+	CHECK(info.frames.size() == 5 && info.frames[4].path == "x:/tex/WOOD.0011.TGA");
+
+	// different widths, not padded
+	CHECK(ssFindSequence("x:/seq/f3.iff", &fs, &info, &error));
+	CHECK(info.padding == 0);
+	CHECK(ssFrameRanges(info) == "1-2,10");
+
+	// the same frame padded and not is still one frame in the ranges
+	CHECK(ssFindSequence("x:\\dup\\a.5.tga", &fs, &info, &error));
+	CHECK(info.frames.size() == 3);
+	CHECK(ssFrameRanges(info) == "1-2");
+
+	// nothing on disk is fine, a folder we can't read isn't
+	CHECK(ssFindSequence("x:/none/a.0001.tga", &fs, &info, &error) && info.frames.empty());
+	CHECK(ssFrameRanges(info) == "");
+	CHECK(!ssFindSequence("x:/unreadable/a.0001.tga", &fs, &info, &error) && !error.empty());
+	CHECK(!ssFindSequence("x:/tex/rock.tga", &fs, &info, &error));
+}
+
+void testSeqScan ()
+{
+	testSplitPath();
+	testFindSequence();
+}
@@ -0,0 +1,358 @@
+/*=======================================================================*
+ |   file name : statuscache.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : cached "svn status" of whole project folders
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <string.h>
+
+#include <hash_map>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "statuscache.h"
+#include "pathutil.h"
+#include "svnclient.h"
+
+using std::map;
+using std::string;
+using std::vector;
+using stdext::hash_map;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// keyed by normalized path
+typedef hash_map<string, StatusEntry> StatusMap;
+typedef map<string, string> DirtyMap;	// normalized path -> path
+typedef map<string, DWORD> RootMap;		// normalized root -> GetTickCount of its last full status
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static volatile LONG	s_csState;		// 0 = no s_cs yet, 1 = being made, 2 = ready
+static CRITICAL_SECTION	s_cs;
+static StatusMap		s_entries;
+static RootMap			s_roots;	// roots that have had a full status
+static DirtyMap			s_dirty;	// paths our own commands changed
+static unsigned			s_fullQueries;
+static unsigned			s_treeQueries;
+static unsigned			s_fileQueries;
+static StatusQueryFunc	s_query = scStatus;
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// stMarkDirty is called from the svn thread so the first call could
+// come from either thread
+static void stInit ()
+{
+	if (InterlockedCompareExchange(&s_csState, 1, 0) == 0)
+	{
+		InitializeCriticalSection(&s_cs);
+		InterlockedExchange(&s_csState, 2);
+	}
+	while (s_csState != 2)
+	{
+		Sleep(0);
+	}
+}
+
+// both paths normalized
+static bool stIsUnder (const string& path, const string& root)
+{
+	return path.size() >= root.size() &&
+		   !path.compare(0, root.size(), root) &&
+		   (path.size() == root.size() || path[root.size()] == '/');
+}
+
+static void stStoreStatus (const SvnStatus& status, void* pContext)
+{
+	StatusEntry&	entry = s_entries[puNormalizePath(status.path.c_str())];
+	PathInfo		info;
+
+	entry.path            = status.path;
+	strncpy(entry.status, status.status.c_str(), sizeof(entry.status) - 1);
+	entry.status[sizeof(entry.status) - 1] = '\0';
+	entry.bVersioned      = status.bVersioned;
+	entry.bIsDir          = status.bIsDir;
+	entry.bOutOfDate      = status.bOutOfDate;
+	entry.revision        = status.revision;
+	entry.changedRevision = status.changedRevision;
+	entry.changedAuthor   = status.changedAuthor;
+	entry.lockOwner       = status.lockOwner;
+	entry.reposLockOwner  = status.reposLockOwner;
+
+	puGetPathInfo(status.path.c_str(), &info);
+	entry.mtime = info.bExists ? info.mtime : 0;
+	entry.size  = info.bExists ? info.size  : 0;
+}
+
+static void stEraseUnder (const string& root)
+{
+	vector<string> keys;
+
+	for (StatusMap::const_iterator it = s_entries.begin(); it != s_entries.end(); ++it)
+	{
+		if (stIsUnder(it->first, root))
+		{
+			keys.push_back(it->first);
+		}
+	}
+	for (size_t ii = 0; ii < keys.size(); ++ii)
+	{
+		s_entries.erase(keys[ii]);
+	}
+}
+
+static void stClearDirtyUnder (const string& root)
+{
+	DirtyMap::iterator it = s_dirty.lower_bound(root);
+	while (it != s_dirty.end() && stIsUnder(it->first, root))
+	{
+		s_dirty.erase(it++);
+	}
+}
+
+/*************************************************************************
+                              stRefresh
+ *************************************************************************
+
+   SYNOPSIS
+		bool stRefresh (const char* root, bool bFull, string* pError)
+
+   PURPOSE
+		bring the cached status for everything under root up to date.
+
+		The first time (or if bFull) we ask svn for the status of the
+		whole tree in one call.  After that we only ask about folders
+		whose mtime changed (files added or removed), files whose
+		mtime or size changed and paths our own svn commands touched.
+		Everything else is assumed to still be correct.
+
+		Locks other people take and their commits don't change
+		anything on our disk so they only show up on a full refresh.
+		A root whose last full refresh is more than
+		ST_FULL_REFRESH_SECS old gets one even if bFull is false.
+
+   INPUT
+		root  : project folder
+		bFull : true = throw away what we have and start over
+
+   RETURNS
+		false if any part of the status failed (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool stRefresh (const char* root, bool bFull, string* pError)
+{
+	stInit();
+
+	EnterCriticalSection(&s_cs);
+
+	string				rootKey = puNormalizePath(root);
+	RootMap::iterator	it      = s_roots.find(rootKey);
+	bool				bOk     = true;
+
+	// unsigned math so GetTickCount wrapping is ok
+	if (bFull || it == s_roots.end() || GetTickCount() - it->second >= ST_FULL_REFRESH_SECS * 1000)
+	{
+		stEraseUnder(rootKey);
+		stClearDirtyUnder(rootKey);
+		++s_fullQueries;
+		bOk = s_query(root, true, stStoreStatus, NULL, pError);
+		if (bOk)
+		{
+			s_roots[rootKey] = GetTickCount();
+		}
+	}
+	else
+	{
+		DirtyMap	trees;
+		DirtyMap	files;
+
+		// find what changed on disk since we last looked
+		for (StatusMap::const_iterator it = s_entries.begin(); it != s_entries.end(); ++it)
+		{
+			const StatusEntry& entry = it->second;
+
+			if (stIsUnder(it->first, rootKey))
+			{
+				PathInfo info;
+
+				if (!puGetPathInfo(entry.path.c_str(), &info))
+				{
+					info.mtime = 0;
+					info.size  = 0;
+				}
+				if (entry.bIsDir)
+				{
+					if (info.mtime != entry.mtime)
+					{
+						trees[it->first] = entry.path;
+					}
+				}
+				else if (info.mtime != entry.mtime || info.size != entry.size)
+				{
+					files[it->first] = entry.path;
+				}
+			}
+		}
+
+		// and what we changed ourselves
+		for (DirtyMap::const_iterator it = s_dirty.lower_bound(rootKey); it != s_dirty.end() && stIsUnder(it->first, rootKey); ++it)
+		{
+			StatusMap::const_iterator found = s_entries.find(it->first);
+			if (found != s_entries.end() && found->second.bIsDir)
+			{
+				trees[it->first] = it->second;
+			}
+			else
+			{
+				files[it->first] = it->second;
+			}
+		}
+		stClearDirtyUnder(rootKey);
+
+		// a tree covers anything below it.  The maps are sorted so a
+		// parent always comes before its children.
+		string lastTree;
+		for (DirtyMap::iterator it = trees.begin(); it != trees.end(); )
+		{
+			if (!lastTree.empty() && stIsUnder(it->first, lastTree))
+			{
+				trees.erase(it++);
+			}
+			else
+			{
+				lastTree = it->first;
+				++it;
+			}
+		}
+
+		for (DirtyMap::const_iterator it = trees.begin(); it != trees.end(); ++it)
+		{
+			stEraseUnder(it->first);
+			++s_treeQueries;
+			if (!s_query(it->second.c_str(), true, stStoreStatus, NULL, pError))
+			{
+				bOk = false;
+			}
+		}
+		for (DirtyMap::const_iterator it = files.begin(); it != files.end(); ++it)
+		{
+			DirtyMap::const_iterator tree = trees.upper_bound(it->first);
+			if (tree != trees.begin() && stIsUnder(it->first, (--tree)->first))
+			{
+				continue;
+			}
+			++s_fileQueries;
+			if (!s_query(it->second.c_str(), false, stStoreStatus, NULL, pError))
+			{
+				bOk = false;
+			}
+		}
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+/*************************************************************************
+                              stLookup
+ *************************************************************************
+
+   SYNOPSIS
+		bool stLookup (const char* path, StatusEntry* pEntry)
+
+   PURPOSE
+		get the cached status of a path.  Does not touch the disk
+		or the server.
+
+   RETURNS
+		false if the path is not in the cache
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool stLookup (const char* path, StatusEntry* pEntry)
+{
+	stInit();
+
+	EnterCriticalSection(&s_cs);
+
+	StatusMap::const_iterator it = s_entries.find(puNormalizePath(path));
+	bool bFound = it != s_entries.end();
+	if (bFound)
+	{
+		*pEntry = it->second;
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return bFound;
+}
+
+/*************************************************************************
+                              stMarkDirty
+ *************************************************************************
+
+   SYNOPSIS
+		void stMarkDirty (const char* path)
+
+   PURPOSE
+		tell the cache a path changed in a way its mtime might not
+		show (lock, unlock, commit) so the next refresh asks again.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void stMarkDirty (const char* path)
+{
+	stInit();
+
+	EnterCriticalSection(&s_cs);
+	s_dirty[puNormalizePath(path)] = path;
+	LeaveCriticalSection(&s_cs);
+}
+
+void stGetStats (StatusCacheStats* pStats)
+{
+	stInit();
+
+	EnterCriticalSection(&s_cs);
+	pStats->numEntries  = (unsigned)s_entries.size();
+	pStats->numRoots    = (unsigned)s_roots.size();
+	pStats->fullQueries = s_fullQueries;
+	pStats->treeQueries = s_treeQueries;
+	pStats->fileQueries = s_fileQueries;
+	LeaveCriticalSection(&s_cs);
+}
+
+// NULL puts scStatus back.  Main thread, while nothing is refreshing
+void stSetStatusQuery (StatusQueryFunc query)
+{
+	s_query = query ? query : scStatus;
+}
+
+void stShutdown ()
+{
+	if (s_csState == 2)
+	{
+		s_entries.clear();
+		s_roots.clear();
+		s_dirty.clear();
+		DeleteCriticalSection(&s_cs);
+		s_csState = 0;
+	}
+}
+
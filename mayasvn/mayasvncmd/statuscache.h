@@ -0,0 +1,62 @@
+/*=======================================================================*
+ |   file name : statuscache.h
+ |-----------------------------------------------------------------------*
+ |   function  : cached "svn status" of whole project folders
+ *=======================================================================*/
+
+#ifndef STATUSCACHE_H
+#define STATUSCACHE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+#include "svnclient.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+#define ST_FULL_REFRESH_SECS	300	// a root this old gets a full status anyway
+
+/******************************* t y p e s *******************************/
+
+struct StatusEntry
+{
+	std::string			path;			// as svn reported it, not normalized
+	char				status[8];		// 7 columns like svn status
+	bool				bVersioned;
+	bool				bIsDir;
+	bool				bOutOfDate;
+	long				revision;
+	long				changedRevision;
+	std::string			changedAuthor;
+	std::string			lockOwner;
+	std::string			reposLockOwner;
+	unsigned __int64	mtime;			// when the status was gotten
+	unsigned __int64	size;
+};
+
+struct StatusCacheStats
+{
+	unsigned	numEntries;
+	unsigned	numRoots;
+	unsigned	fullQueries;	// whole roots asked for
+	unsigned	treeQueries;	// changed folders asked for
+	unsigned	fileQueries;	// changed files asked for
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool stRefresh (const char* root, bool bFull, std::string* pError);
+extern bool stLookup (const char* path, StatusEntry* pEntry);
+extern void stMarkDirty (const char* path);
+extern void stGetStats (StatusCacheStats* pStats);
+extern void stSetStatusQuery (StatusQueryFunc query);
+extern void stShutdown ();
+
+#endif /* STATUSCACHE_H */
+
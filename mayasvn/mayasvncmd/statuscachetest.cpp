@@ -0,0 +1,133 @@
+/*=======================================================================*
+ |   file name : statuscachetest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the cached svn status
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+
+#include <string>
+
+#include "coretest.h"
+#include "statuscache.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_OLD_SECS		(60 * 60)
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// what the next refresh asked the server, then forget it
+static string takeQueries (FakeSvn* pFake)
+{
+	string queries;
+
+	for (size_t ii = 0; ii < pFake->queries.size(); ++ii)
+	{
+		queries += (ii ? "|" : "") + pFake->queries[ii];
+	}
+	pFake->queries.clear();
+	return queries;
+}
+
+void testStatusCache ()
+{
+	string dir;
+
+	if (!CHECK(ctMakeTempDir("statuscache", &dir)))
+	{
+		return;
+	}
+
+	string	sub   = dir + "\\sub";
+	string	fileA = dir + "\\a.txt";
+	string	fileB = sub + "\\b.txt";
+	string	fileC = sub + "\\c.txt";
+
+	CHECK(CreateDirectory(sub.c_str(), NULL) != 0);
+	CHECK(ctWriteFile(fileA, "a", CT_OLD_SECS));
+	CHECK(ctWriteFile(fileB, "b", CT_OLD_SECS));
+
+	FakeSvn				fake;
+	StatusEntry			entry;
+	StatusCacheStats	before;
+	StatusCacheStats	stats;
+	string				error;
+
+	stSetStatusQuery(ctInitFakeSvn(&fake));
+	ctSetFakeStatus(&fake, dir,   "       ", true);
+	ctSetFakeStatus(&fake, sub,   "       ", true);
+	ctSetFakeStatus(&fake, fileA, "       ", false);
+	ctSetFakeStatus(&fake, fileB, "       ", false);
+
+	// the first time is the whole tree
+	stGetStats(&before);
+	CHECK(stRefresh(dir.c_str(), false, &error));
+	CHECK(takeQueries(&fake) == dir + " -R");
+	stGetStats(&stats);
+	CHECK(stats.fullQueries == before.fullQueries + 1);
+	CHECK(stLookup(fileB.c_str(), &entry) && entry.path == fileB && entry.bVersioned);
+	CHECK(!stLookup(fileC.c_str(), &entry));
+
+	// nothing changed, nothing asked
+	CHECK(stRefresh(dir.c_str(), false, &error));
+	CHECK(takeQueries(&fake).empty());
+
+	// a file that changed size is asked about by itself
+	CHECK(ctWriteFile(fileA, "a changed", CT_OLD_SECS));
+	ctSetFakeStatus(&fake, fileA, "M      ", false);
+	CHECK(stRefresh(dir.c_str(), false, &error));
+	CHECK(takeQueries(&fake) == fileA);
+	CHECK(stLookup(fileA.c_str(), &entry) && entry.status[0] == 'M');
+
+	// one we changed without touching the disk, say by locking it
+	ctSetFakeStatus(&fake, fileB, "     K ", false);
+	stMarkDirty(fileB.c_str());
+	CHECK(stRefresh(dir.c_str(), false, &error));
+	CHECK(takeQueries(&fake) == fileB);
+	CHECK(stLookup(fileB.c_str(), &entry) && entry.status[5] == 'K');
+
+	// a new file changes its folder, the folder is asked about and that
+	// covers a dirty file in it
+	CHECK(ctWriteFile(fileC, "c", 0));
+	ctSetFakeStatus(&fake, fileC, "?      ", false);
+	stMarkDirty(fileB.c_str());
+	CHECK(stRefresh(dir.c_str(), false, &error));
+	CHECK(takeQueries(&fake) == sub + " -R");
+	CHECK(stLookup(fileC.c_str(), &entry) && !entry.bVersioned);
+
+	// a failed refresh says so
+	fake.bFail = true;
+	CHECK(ctWriteFile(fileA, "a changed again", CT_OLD_SECS));
+	CHECK(!stRefresh(dir.c_str(), false, &error) && !error.empty());
+	fake.bFail = false;
+	takeQueries(&fake);
+
+	// and full starts over
+	stGetStats(&before);
+	CHECK(stRefresh(dir.c_str(), true, &error));
+	CHECK(takeQueries(&fake) == dir + " -R");
+	stGetStats(&stats);
+	CHECK(stats.fullQueries == before.fullQueries + 1);
+	CHECK(stats.numEntries == 5);
+
+	stSetStatusQuery(NULL);
+	stShutdown();
+	ctRemoveDir(dir);
+}
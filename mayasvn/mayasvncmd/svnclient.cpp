@@ -0,0 +1,924 @@
+/*=======================================================================*
+ |   file name : svnclient.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : in process subversion client (libsvn_client)
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <apr_general.h>
+#include <apr_hash.h>
+#include <apr_strings.h>
+#include <svn_client.h>
+#include <svn_cmdline.h>
+#include <svn_config.h>
+#include <svn_dirent_uri.h>
+#include <svn_error.h>
+#include <svn_pools.h>
+#include <svn_ra.h>
+#include <svn_wc.h>
+
+#include "svnclient.h"
+#include "dircache.h"
+#include "pathutil.h"
+#include "trace.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+typedef map<string, int> PathIndexMap;
+
+// state for one scRun, handed to every svn callback as its baton.
+// Notifications come back with absolute paths so we map them back to
+// the index the caller passed in.
+struct SvnOp
+{
+	PathIndexMap	pathIndex;
+	StringList*		pResults;
+	const char*		pOkText;
+	svn_wc_notify_action_t	okAction;
+	svn_wc_notify_action_t	failAction;
+	const string*	pMessage;
+	svn_revnum_t	committedRev;
+	volatile long*	pCancel;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static volatile LONG	s_csState;		// 0 = no s_cs yet, 1 = being made, 2 = ready
+static CRITICAL_SECTION	s_cs;
+static apr_pool_t*		s_pool  = NULL;	// lives as long as the plugin
+static svn_client_ctx_t*	s_ctx   = NULL;	// reused so the auth cache and ra sessions stay warm
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static string scErrorText (svn_error_t* err)
+{
+	char	buf[1024];
+
+	return string(svn_err_best_message(err, buf, sizeof(buf)));
+}
+
+static string scNumber (long value)
+{
+	char	buf[32];
+
+	sprintf(buf, "%ld", value);
+	return string(buf);
+}
+
+// s_cs is made exactly once whichever thread gets here first
+static void scInitLock ()
+{
+	if (InterlockedCompareExchange(&s_csState, 1, 0) == 0)
+	{
+		InitializeCriticalSection(&s_cs);
+		InterlockedExchange(&s_csState, 2);
+	}
+	while (s_csState != 2)
+	{
+		Sleep(0);
+	}
+}
+
+static int scFindPath (const SvnOp* pOp, const char* path)
+{
+	if (!path)
+	{
+		return -1;
+	}
+
+	PathIndexMap::const_iterator it = pOp->pathIndex.find(puNormalizePath(path));
+	return it != pOp->pathIndex.end() ? it->second : -1;
+}
+
+// the batons below are the SvnOp of the scRun going on or NULL
+// outside scRun (status, getLocks, the auth baton)
+static svn_error_t* scCancel (void* pBaton)
+{
+	SvnOp* pOp = (SvnOp*)pBaton;
+
+	if (pOp && pOp->pCancel && *pOp->pCancel)
+	{
+		return svn_error_create(SVN_ERR_CANCELLED, NULL, "cancelled");
+	}
+	return SVN_NO_ERROR;
+}
+
+static void scNotify (void* pBaton, const svn_wc_notify_t* notify, apr_pool_t* pool)
+{
+	SvnOp* pOp = (SvnOp*)pBaton;
+
+	if (!pOp)
+	{
+		return;
+	}
+
+	int index = scFindPath(pOp, notify->path);
+	if (index < 0)
+	{
+		return;
+	}
+
+	if (notify->action == pOp->okAction)
+	{
+		(*pOp->pResults)[index] = pOp->pOkText;
+	}
+	else if (notify->action == pOp->failAction)
+	{
+		(*pOp->pResults)[index] = string("error:") + (notify->err ? scErrorText(notify->err) : string("failed"));
+	}
+}
+
+static svn_error_t* scLogMessage (const char** ppLogMsg, const char** ppTmpFile,
+								  const apr_array_header_t* commitItems, void* pBaton, apr_pool_t* pool)
+{
+	SvnOp* pOp = (SvnOp*)pBaton;
+
+	*ppLogMsg  = apr_pstrdup(pool, pOp && pOp->pMessage ? pOp->pMessage->c_str() : "");
+	*ppTmpFile = NULL;
+	return SVN_NO_ERROR;
+}
+
+static svn_error_t* scCommitDone (const svn_commit_info_t* pCommitInfo, void* pBaton, apr_pool_t* pool)
+{
+	SvnOp* pOp = (SvnOp*)pBaton;
+
+	pOp->committedRev = pCommitInfo->revision;
+	return SVN_NO_ERROR;
+}
+
+static svn_error_t* scInfoReceiver (void* pBaton, const char* absPath, const svn_client_info2_t* pInfo, apr_pool_t* pool)
+{
+	StringList&	results = *((SvnOp*)pBaton)->pResults;
+
+	results.push_back(string("path=")           + svn_dirent_local_style(absPath, pool));
+	results.push_back(string("url=")            + (pInfo->URL ? pInfo->URL : ""));
+	results.push_back(string("revision=")       + scNumber(pInfo->rev));
+	results.push_back(string("kind=")           + svn_node_kind_to_word(pInfo->kind));
+	results.push_back(string("lastChangedRev=") + scNumber(pInfo->last_changed_rev));
+	results.push_back(string("lastAuthor=")     + (pInfo->last_changed_author ? pInfo->last_changed_author : ""));
+	results.push_back(string("lockOwner=")      + (pInfo->lock && pInfo->lock->owner   ? pInfo->lock->owner   : ""));
+	results.push_back(string("lockToken=")      + (pInfo->lock && pInfo->lock->token   ? pInfo->lock->token   : ""));
+	results.push_back(string("lockComment=")    + (pInfo->lock && pInfo->lock->comment ? pInfo->lock->comment : ""));
+	return SVN_NO_ERROR;
+}
+
+static svn_error_t* scLockReceiver (void* pBaton, const char* absPath, const svn_client_info2_t* pInfo, apr_pool_t* pool)
+{
+	SvnLockInfo* pLock = (SvnLockInfo*)pBaton;
+
+	if (pInfo->lock)
+	{
+		pLock->owner   = pInfo->lock->owner   ? pInfo->lock->owner   : "";
+		pLock->token   = pInfo->lock->token   ? pInfo->lock->token   : "";
+		pLock->comment = pInfo->lock->comment ? pInfo->lock->comment : "";
+	}
+	return SVN_NO_ERROR;
+}
+
+static char scStatusChar (svn_wc_status_kind kind)
+{
+	switch (kind)
+	{
+	case svn_wc_status_unversioned: return '?';
+	case svn_wc_status_added:       return 'A';
+	case svn_wc_status_missing:     return '!';
+	case svn_wc_status_incomplete:  return '!';
+	case svn_wc_status_deleted:     return 'D';
+	case svn_wc_status_replaced:    return 'R';
+	case svn_wc_status_modified:    return 'M';
+	case svn_wc_status_merged:      return 'G';
+	case svn_wc_status_conflicted:  return 'C';
+	case svn_wc_status_ignored:     return 'I';
+	case svn_wc_status_obstructed:  return '~';
+	case svn_wc_status_external:    return 'X';
+	default:                        return ' ';
+	}
+}
+
+struct StatusBaton
+{
+	StatusFunc	func;
+	void*		pContext;
+};
+
+static svn_error_t* scStatusReceiver (void* pBaton, const char* path, const svn_client_status_t* pStatus, apr_pool_t* pool)
+{
+	StatusBaton*	pSB = (StatusBaton*)pBaton;
+	SvnStatus		st;
+	const char*		localToken = pStatus->lock ? pStatus->lock->token : NULL;
+	const char*		reposToken = pStatus->repos_lock ? pStatus->repos_lock->token : NULL;
+	char			cols[8] = "       ";
+
+	// same rules svn status uses.  A property only change shows in
+	// column 2 not column 1
+	svn_wc_status_kind nodeStatus = pStatus->node_status;
+	if (nodeStatus == svn_wc_status_modified && pStatus->text_status == svn_wc_status_normal)
+	{
+		nodeStatus = svn_wc_status_normal;
+	}
+	cols[0] = scStatusChar(nodeStatus);
+	if (pStatus->prop_status == svn_wc_status_modified || pStatus->prop_status == svn_wc_status_conflicted)
+	{
+		cols[1] = scStatusChar(pStatus->prop_status);
+	}
+	if (pStatus->wc_is_locked) { cols[2] = 'L'; }
+	if (pStatus->copied)       { cols[3] = '+'; }
+	if (pStatus->switched)     { cols[4] = 'S'; }
+	else if (pStatus->file_external) { cols[4] = 'X'; }
+	if (localToken)
+	{
+		if (!reposToken)                          { cols[5] = 'B'; }	// broken
+		else if (strcmp(localToken, reposToken))  { cols[5] = 'T'; }	// stolen
+		else                                      { cols[5] = 'K'; }
+	}
+	else if (reposToken)
+	{
+		cols[5] = 'O';
+	}
+	if (pStatus->conflicted && pStatus->text_status != svn_wc_status_conflicted && pStatus->prop_status != svn_wc_status_conflicted)
+	{
+		cols[6] = 'C';	// tree conflict
+	}
+
+	st.path            = svn_dirent_local_style(pStatus->local_abspath, pool);
+	st.status          = cols;
+	st.bVersioned      = pStatus->versioned ? true : false;
+	st.bIsDir          = pStatus->kind == svn_node_dir;
+	st.bOutOfDate      = pStatus->repos_node_status != svn_wc_status_none;
+	st.revision        = pStatus->revision;
+	st.changedRevision = pStatus->changed_rev;
+	st.changedAuthor   = pStatus->changed_author ? pStatus->changed_author : "";
+	st.lockOwner       = pStatus->lock && pStatus->lock->owner ? pStatus->lock->owner : "";
+	st.reposLockOwner  = pStatus->repos_lock && pStatus->repos_lock->owner ? pStatus->repos_lock->owner : "";
+
+	pSB->func(st, pSB->pContext);
+	return SVN_NO_ERROR;
+}
+
+/*************************************************************************
+                              scInit
+ *************************************************************************
+
+   SYNOPSIS
+		bool scInit (string* pError)
+
+   PURPOSE
+		start apr and make the client context.  Called by everything
+		else here, from any thread.  The auth baton is
+		non-interactive because we have no console to prompt on so
+		credentials have to already be cached (by running svn or
+		TortoiseSVN once).
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scInit (string* pError)
+{
+	scInitLock();
+
+	EnterCriticalSection(&s_cs);
+	if (s_ctx)
+	{
+		LeaveCriticalSection(&s_cs);
+		return true;
+	}
+
+	if (apr_initialize() != APR_SUCCESS)
+	{
+		LeaveCriticalSection(&s_cs);
+		*pError = "could not initialize apr";
+		return false;
+	}
+
+	s_pool = svn_pool_create(NULL);
+
+	svn_error_t* err = svn_ra_initialize(s_pool);
+	if (!err)
+	{
+		err = svn_config_ensure(NULL, s_pool);
+	}
+	if (!err)
+	{
+		err = svn_client_create_context(&s_ctx, s_pool);
+	}
+	if (!err)
+	{
+		err = svn_config_get_config(&s_ctx->config, NULL, s_pool);
+	}
+	if (!err)
+	{
+		svn_config_t* pCfg = (svn_config_t*)apr_hash_get(s_ctx->config, SVN_CONFIG_CATEGORY_CONFIG, APR_HASH_KEY_STRING);
+
+		s_ctx->cancel_func     = scCancel;
+		s_ctx->cancel_baton    = NULL;
+		s_ctx->notify_func2    = scNotify;
+		s_ctx->notify_baton2   = NULL;
+		s_ctx->log_msg_func3   = scLogMessage;
+		s_ctx->log_msg_baton3  = NULL;
+
+		err = svn_cmdline_create_auth_baton(&s_ctx->auth_baton,
+											TRUE,	// non interactive
+											NULL, NULL, NULL,
+											FALSE, FALSE,
+											pCfg,
+											scCancel, NULL,
+											s_pool);
+	}
+	if (err)
+	{
+		*pError = scErrorText(err);
+		svn_error_clear(err);
+		svn_pool_destroy(s_pool);
+		s_pool = NULL;
+		s_ctx  = NULL;
+		apr_terminate();
+		LeaveCriticalSection(&s_cs);
+		return false;
+	}
+
+	LeaveCriticalSection(&s_cs);
+	return true;
+}
+
+/*************************************************************************
+                              scIsSubcommand
+ *************************************************************************
+
+   SYNOPSIS
+		bool scIsSubcommand (const char* subcommand)
+
+   PURPOSE
+		check for a subcommand scRun knows before doing any work
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scIsSubcommand (const char* subcommand)
+{
+	return !strcmp(subcommand, "lock")   ||
+		   !strcmp(subcommand, "unlock") ||
+		   !strcmp(subcommand, "commit") ||
+		   !strcmp(subcommand, "add")    ||
+		   !strcmp(subcommand, "update") ||
+		   !strcmp(subcommand, "info");
+}
+
+/*************************************************************************
+                              scRun
+ *************************************************************************
+
+   SYNOPSIS
+		bool scRun (const string& subcommand, const StringList& paths,
+					const string& message, StringList& results,
+					string* pError, volatile long* pCancel)
+
+   PURPOSE
+		run a subversion command in process.
+
+		For lock, unlock, commit, add and update results gets one entry
+		per path, in the same order
+
+			lock     "locked"            or "error:<message>"
+			unlock   "unlocked"          or "error:<message>"
+			commit   "committed:<rev>"   or "error:<message>"
+					 "nothing" if nothing had changed
+			add      "added"             or "error:<message>"
+			update   "updated:<rev>"     or "error:<message>"
+
+		info appends "key=value" entries for each path starting with
+		"path=".  A path info fails on gets "path=" and "error=".
+
+		Only one command runs at a time.  Other threads calling this
+		wait for the current one to finish.
+
+   INPUT
+		subcommand : lock, unlock, commit, add, update or info
+		paths      : local paths
+		message    : lock comment or commit log message
+		results    : filled in as described above
+		pError     : set if the command could not be run at all
+		pCancel    : if not NULL and set non zero the command is cancelled
+
+   RETURNS
+		false if the command failed as a whole (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scRun (const string& subcommand, const StringList& paths, const string& message,
+			StringList& results, string* pError, volatile long* pCancel)
+{
+	TraceSpan span("svn", subcommand.c_str());
+
+	span.setArg("path", paths.empty() ? "" : paths[0].c_str());
+	span.setArg("numPaths", (long)paths.size());
+
+	if (!scIsSubcommand(subcommand.c_str()))
+	{
+		*pError = "unknown svn subcommand (" + subcommand + ")";
+		return false;
+	}
+	if (paths.empty())
+	{
+		*pError = "no paths given";
+		return false;
+	}
+	if (!scInit(pError))
+	{
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	apr_pool_t*			pool    = svn_pool_create(s_pool);
+	apr_array_header_t*	targets = apr_array_make(pool, (int)paths.size(), sizeof(const char*));
+	svn_error_t*		err     = SVN_NO_ERROR;
+	SvnOp				op;
+
+	op.pResults     = &results;
+	op.pOkText      = "";
+	op.okAction     = svn_wc_notify_skip;
+	op.failAction   = svn_wc_notify_skip;
+	op.pMessage     = &message;
+	op.committedRev = SVN_INVALID_REVNUM;
+	op.pCancel      = pCancel;
+
+	for (size_t ii = 0; ii < paths.size() && !err; ++ii)
+	{
+		const char* absPath;
+
+		err = svn_dirent_get_absolute(&absPath, svn_dirent_internal_style(paths[ii].c_str(), pool), pool);
+		if (!err)
+		{
+			APR_ARRAY_PUSH(targets, const char*) = absPath;
+			op.pathIndex[puNormalizePath(absPath)] = (int)ii;
+		}
+	}
+
+	results.clear();
+	if (subcommand != "info")
+	{
+		results.resize(paths.size());
+	}
+
+	s_ctx->cancel_baton   = &op;
+	s_ctx->notify_baton2  = &op;
+	s_ctx->log_msg_baton3 = &op;
+
+	if (!err)
+	{
+		if (subcommand == "lock")
+		{
+			op.pOkText    = "locked";
+			op.okAction   = svn_wc_notify_locked;
+			op.failAction = svn_wc_notify_failed_lock;
+			err = svn_client_lock(targets, message.c_str(), FALSE, s_ctx, pool);
+		}
+		else if (subcommand == "unlock")
+		{
+			op.pOkText    = "unlocked";
+			op.okAction   = svn_wc_notify_unlocked;
+			op.failAction = svn_wc_notify_failed_unlock;
+			err = svn_client_unlock(targets, FALSE, s_ctx, pool);
+		}
+		else if (subcommand == "add")
+		{
+			op.pOkText  = "added";
+			op.okAction = svn_wc_notify_add;
+			for (int ii = 0; ii < targets->nelts && !err; ++ii)
+			{
+				svn_error_t* addErr = svn_client_add4(APR_ARRAY_IDX(targets, ii, const char*),
+													  svn_depth_empty, FALSE, FALSE, FALSE, s_ctx, pool);
+				if (addErr)
+				{
+					if (addErr->apr_err == SVN_ERR_CANCELLED)
+					{
+						err = addErr;
+					}
+					else
+					{
+						results[ii] = "error:" + scErrorText(addErr);
+						svn_error_clear(addErr);
+					}
+				}
+			}
+		}
+		else if (subcommand == "commit")
+		{
+			err = svn_client_commit5(targets, svn_depth_empty, FALSE, FALSE, TRUE, NULL, NULL,
+									 scCommitDone, &op, s_ctx, pool);
+			if (!err)
+			{
+				// no revision means there was nothing to send
+				string outcome = SVN_IS_VALID_REVNUM(op.committedRev) ? "committed:" + scNumber(op.committedRev) : string("nothing");
+				for (size_t ii = 0; ii < results.size(); ++ii)
+				{
+					results[ii] = outcome;
+				}
+			}
+		}
+		else if (subcommand == "update")
+		{
+			apr_array_header_t*	resultRevs = NULL;
+			svn_opt_revision_t	head;
+
+			head.kind = svn_opt_revision_head;
+			err = svn_client_update4(&resultRevs, targets, &head, svn_depth_unknown, FALSE,
+									 FALSE, FALSE, TRUE, FALSE, s_ctx, pool);
+
+			// it wrote files even if it failed part way.  Don't make the
+			// next listing wait for the watch thread to see them.
+			for (size_t ii = 0; ii < paths.size(); ++ii)
+			{
+				dcInvalidate(paths[ii].c_str());
+			}
+			if (!err && resultRevs)
+			{
+				for (int ii = 0; ii < resultRevs->nelts && ii < (int)results.size(); ++ii)
+				{
+					results[ii] = "updated:" + scNumber(APR_ARRAY_IDX(resultRevs, ii, svn_revnum_t));
+				}
+			}
+		}
+		else // info
+		{
+			svn_opt_revision_t	unspecified;
+
+			unspecified.kind = svn_opt_revision_unspecified;
+			for (int ii = 0; ii < targets->nelts && !err; ++ii)
+			{
+				const char*  absPath = APR_ARRAY_IDX(targets, ii, const char*);
+				svn_error_t* infoErr = svn_client_info3(absPath, &unspecified, &unspecified, svn_depth_empty,
+														FALSE, TRUE, NULL, scInfoReceiver, &op, s_ctx, pool);
+				if (infoErr)
+				{
+					if (infoErr->apr_err == SVN_ERR_CANCELLED)
+					{
+						err = infoErr;
+					}
+					else
+					{
+						results.push_back(string("path=") + svn_dirent_local_style(absPath, pool));
+						results.push_back("error=" + scErrorText(infoErr));
+						svn_error_clear(infoErr);
+					}
+				}
+			}
+		}
+	}
+
+	s_ctx->cancel_baton   = NULL;
+	s_ctx->notify_baton2  = NULL;
+	s_ctx->log_msg_baton3 = NULL;
+
+	bool bOk = true;
+	if (!err)
+	{
+		// only a notification that the work was done counts.  svn can
+		// pass over a path (a lock that wasn't taken...) without
+		// raising an error
+		for (size_t ii = 0; ii < results.size(); ++ii)
+		{
+			if (results[ii].empty())
+			{
+				results[ii] = "error:svn did not report doing anything";
+			}
+		}
+	}
+	if (err)
+	{
+		// a whole-command failure (commit out of date, cancelled, bad
+		// path...) applies to every path that has no outcome yet.
+		string msg = scErrorText(err);
+		for (size_t ii = 0; ii < results.size(); ++ii)
+		{
+			if (results[ii].empty())
+			{
+				results[ii] = "error:" + msg;
+			}
+		}
+		if (err->apr_err == SVN_ERR_CANCELLED)
+		{
+			*pError = msg;
+			bOk     = false;
+		}
+		svn_error_clear(err);
+	}
+
+	svn_pool_destroy(pool);
+
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+/*************************************************************************
+                              scGetLocks
+ *************************************************************************
+
+   SYNOPSIS
+		bool scGetLocks (const StringList& paths, vector<SvnLockInfo>& locks,
+						 string* pError)
+
+   PURPOSE
+		ask the repository who holds the lock on each path.  Unlike
+		svn.exe before 1.2 we don't have to try to take the lock to
+		find out.
+
+   RETURNS
+		false if nothing could be asked (pError says why).  Problems
+		with single paths go in that path's error.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scGetLocks (const StringList& paths, vector<SvnLockInfo>& locks, string* pError)
+{
+	TraceSpan span("svn", "getLocks");
+
+	span.setArg("path", paths.empty() ? "" : paths[0].c_str());
+	span.setArg("numPaths", (long)paths.size());
+
+	locks.clear();
+	locks.resize(paths.size());
+
+	if (!scInit(pError))
+	{
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	apr_pool_t*			pool = svn_pool_create(s_pool);
+	apr_pool_t*			iterPool = svn_pool_create(pool);
+	svn_opt_revision_t	head;
+	bool				bOk = true;
+
+	// info at HEAD reports the lock in the repository, not the one
+	// (if any) in our working copy
+	head.kind = svn_opt_revision_head;
+
+	for (size_t ii = 0; ii < paths.size() && bOk; ++ii)
+	{
+		const char* absPath;
+
+		svn_pool_clear(iterPool);
+		svn_error_t* err = svn_dirent_get_absolute(&absPath, svn_dirent_internal_style(paths[ii].c_str(), iterPool), iterPool);
+		if (!err)
+		{
+			err = svn_client_info3(absPath, &head, &head, svn_depth_empty, FALSE, FALSE, NULL,
+								   scLockReceiver, &locks[ii], s_ctx, iterPool);
+		}
+		if (err)
+		{
+			locks[ii].error = scErrorText(err);
+			if (err->apr_err == SVN_ERR_CANCELLED)
+			{
+				*pError = locks[ii].error;
+				bOk = false;
+			}
+			svn_error_clear(err);
+		}
+	}
+
+	svn_pool_destroy(pool);
+
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+/*************************************************************************
+                              scLock
+ *************************************************************************
+
+   SYNOPSIS
+		bool scLock (const StringList& paths, const string& comment,
+					 StringList& outcomes, string* pError)
+
+   PURPOSE
+		lock several paths with one request.  outcomes gets one entry
+		per path
+
+			"acquired"       we have the lock now
+			"held:<user>"    someone (maybe us in another working copy)
+							 already has it
+			"error:<msg>"    anything else
+
+		Only the paths that failed get a second look to find out who
+		holds them.
+
+   RETURNS
+		false if nothing could be done (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scLock (const StringList& paths, const string& comment, StringList& outcomes, string* pError)
+{
+	TraceSpan span("svn", "lock");
+
+	span.setArg("path", paths.empty() ? "" : paths[0].c_str());
+	span.setArg("numPaths", (long)paths.size());
+
+	if (!scInit(pError))
+	{
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	bool bOk = scRun("lock", paths, comment, outcomes, pError);
+	if (bOk)
+	{
+		StringList	failedPaths;
+		vector<int>	failedIndices;
+
+		for (size_t ii = 0; ii < outcomes.size(); ++ii)
+		{
+			if (outcomes[ii] == "locked")
+			{
+				outcomes[ii] = "acquired";
+			}
+			else
+			{
+				failedPaths.push_back(paths[ii]);
+				failedIndices.push_back((int)ii);
+			}
+		}
+
+		if (!failedPaths.empty())
+		{
+			vector<SvnLockInfo>	locks;
+			string				lockError;
+
+			scGetLocks(failedPaths, locks, &lockError);
+			for (size_t ii = 0; ii < locks.size(); ++ii)
+			{
+				if (!locks[ii].owner.empty())
+				{
+					outcomes[failedIndices[ii]] = "held:" + locks[ii].owner;
+				}
+			}
+		}
+	}
+
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+/*************************************************************************
+                              scUnlock
+ *************************************************************************
+
+   SYNOPSIS
+		bool scUnlock (const StringList& paths, StringList& outcomes,
+					   string* pError)
+
+   PURPOSE
+		unlock several paths with one request.  outcomes gets
+		"released" or "error:<msg>" for each path.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scUnlock (const StringList& paths, StringList& outcomes, string* pError)
+{
+	TraceSpan span("svn", "unlock");
+
+	span.setArg("path", paths.empty() ? "" : paths[0].c_str());
+	span.setArg("numPaths", (long)paths.size());
+
+	bool bOk = scRun("unlock", paths, "", outcomes, pError);
+	if (bOk)
+	{
+		for (size_t ii = 0; ii < outcomes.size(); ++ii)
+		{
+			if (outcomes[ii] == "unlocked")
+			{
+				outcomes[ii] = "released";
+			}
+		}
+	}
+	return bOk;
+}
+
+/*************************************************************************
+                              scStatus
+ *************************************************************************
+
+   SYNOPSIS
+		bool scStatus (const char* path, bool bRecurse, StatusFunc func,
+					   void* pContext, string* pError)
+
+   PURPOSE
+		the equivalent of "svn status -u -v".  Asks the server too so
+		locks held by other people and out of date files show up.
+
+   INPUT
+		path     : file or folder
+		bRecurse : true = everything below path, false = just path
+		func     : called once for each path
+		pContext : passed to func
+
+   RETURNS
+		false if the status could not be gotten (pError says why)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool scStatus (const char* path, bool bRecurse, StatusFunc func, void* pContext, string* pError)
+{
+	TraceSpan span("svn", "status");
+
+	span.setArg("path", path);
+	span.setArg("recurse", bRecurse ? "1" : "0");
+
+	if (!scInit(pError))
+	{
+		return false;
+	}
+
+	EnterCriticalSection(&s_cs);
+
+	apr_pool_t*			pool = svn_pool_create(s_pool);
+	const char*			absPath;
+	svn_opt_revision_t	head;
+	StatusBaton			baton;
+
+	head.kind      = svn_opt_revision_head;
+	baton.func     = func;
+	baton.pContext = pContext;
+
+	svn_error_t* err = svn_dirent_get_absolute(&absPath, svn_dirent_internal_style(path, pool), pool);
+	if (!err)
+	{
+		err = svn_client_status5(NULL, s_ctx, absPath, &head,
+								 bRecurse ? svn_depth_infinity : svn_depth_empty,
+								 TRUE,		// get all, not just changed
+								 TRUE,		// contact the server
+								 FALSE, TRUE, FALSE, NULL,
+								 scStatusReceiver, &baton, pool);
+	}
+
+	bool bOk = true;
+	if (err)
+	{
+		*pError = scErrorText(err);
+		svn_error_clear(err);
+		bOk = false;
+	}
+
+	svn_pool_destroy(pool);
+
+	LeaveCriticalSection(&s_cs);
+
+	return bOk;
+}
+
+/*************************************************************************
+                              scShutdown
+ *************************************************************************
+
+   SYNOPSIS
+		void scShutdown ()
+
+   PURPOSE
+		free the client context.  Called when the plugin is unloaded.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void scShutdown ()
+{
+	if (s_csState == 2)
+	{
+		EnterCriticalSection(&s_cs);
+		if (s_ctx)
+		{
+			svn_pool_destroy(s_pool);
+			s_pool = NULL;
+			s_ctx  = NULL;
+			apr_terminate();
+		}
+		LeaveCriticalSection(&s_cs);
+		DeleteCriticalSection(&s_cs);
+		s_csState = 0;
+	}
+}
+
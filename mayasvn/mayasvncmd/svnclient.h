@@ -0,0 +1,72 @@
+/*=======================================================================*
+ |   file name : svnclient.h
+ |-----------------------------------------------------------------------*
+ |   function  : in process subversion client (libsvn_client)
+ *=======================================================================*/
+
+#ifndef SVNCLIENT_H
+#define SVNCLIENT_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+typedef std::vector<std::string> StringList;
+
+// one entry from scStatus, the same things "svn status -u -v" prints
+struct SvnStatus
+{
+	std::string		path;			// absolute, windows style
+	std::string		status;			// 7 columns like svn status
+	bool			bVersioned;
+	bool			bIsDir;
+	bool			bOutOfDate;
+	long			revision;
+	long			changedRevision;
+	std::string		changedAuthor;
+	std::string		lockOwner;		// lock held by this working copy
+	std::string		reposLockOwner;	// lock in the repository (ours or someone else's)
+};
+
+// a lock as the repository sees it
+struct SvnLockInfo
+{
+	std::string		owner;		// "" = not locked
+	std::string		token;
+	std::string		comment;
+	std::string		error;		// "" = we found out
+};
+
+// called once per path.  Called with the svn lock held so it must
+// not call back into svnclient.
+typedef void (*StatusFunc)(const SvnStatus& status, void* pContext);
+
+// scStatus or something pretending to be it.  The caches ask through
+// one of these so coretest can hand them a pretend server.
+typedef bool (*StatusQueryFunc)(const char* path, bool bRecurse, StatusFunc func, void* pContext, std::string* pError);
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool scInit (std::string* pError);
+extern bool scIsSubcommand (const char* subcommand);
+extern bool scRun (const std::string& subcommand, const StringList& paths, const std::string& message,
+				   StringList& results, std::string* pError, volatile long* pCancel = NULL);
+extern bool scLock (const StringList& paths, const std::string& comment, StringList& outcomes, std::string* pError);
+extern bool scUnlock (const StringList& paths, StringList& outcomes, std::string* pError);
+extern bool scGetLocks (const StringList& paths, std::vector<SvnLockInfo>& locks, std::string* pError);
+extern bool scStatus (const char* path, bool bRecurse, StatusFunc func, void* pContext, std::string* pError);
+extern void scShutdown ();
+
+#endif /* SVNCLIENT_H */
+
@@ -0,0 +1,136 @@
+/*=======================================================================*
+ |   file name : svnclienttest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the in process svn client
+ *=======================================================================*/
+
+/*
+   There's no server here so these check the parts that don't need
+   one, what scRun does with bad arguments and how a folder that isn't
+   a working copy is reported.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "coretest.h"
+#include "svnclient.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// StatusFunc, counts the paths it's told about
+static void countStatus (const SvnStatus& status, void* pContext)
+{
+	++*(int*)pContext;
+}
+
+static void testSubcommands ()
+{
+	CHECK(scIsSubcommand("lock"));
+	CHECK(scIsSubcommand("unlock"));
+	CHECK(scIsSubcommand("commit"));
+	CHECK(scIsSubcommand("add"));
+	CHECK(scIsSubcommand("update"));
+	CHECK(scIsSubcommand("info"));
+	CHECK(!scIsSubcommand("delete"));
+	CHECK(!scIsSubcommand("Lock"));
+	CHECK(!scIsSubcommand(""));
+
+	StringList	paths;
+	StringList	results;
+	string		error;
+
+	paths.push_back("c:\\anything.ma");
+	CHECK(!scRun("delete", paths, "", results, &error));
+	CHECK(error == "unknown svn subcommand (delete)");
+
+	paths.clear();
+	error.erase();
+	CHECK(!scRun("info", paths, "", results, &error));
+	CHECK(error == "no paths given");
+}
+
+// a folder svn knows nothing about
+static void testNotWorkingCopy ()
+{
+	string dir;
+	string error;
+
+	if (!CHECK(ctMakeTempDir("svnclient", &dir)))
+	{
+		return;
+	}
+
+	string file = dir + "\\a.ma";
+
+	CHECK(ctWriteFile(file, "a", 0));
+	if (!CHECK(scInit(&error)))
+	{
+		printf ("       %s\n", error.c_str());
+		ctRemoveDir(dir);
+		return;
+	}
+	CHECK(scInit(&error));
+
+	StringList paths;
+	StringList results;
+
+	paths.push_back(file);
+
+	// info says which path failed and why
+	CHECK(scRun("info", paths, "", results, &error));
+	CHECK(results.size() == 2);
+	CHECK(results.size() == 2 && !results[0].compare(0, 5, "path="));
+	CHECK(results.size() == 2 && !results[1].compare(0, 6, "error=") && results[1].size() > 6);
+
+	// one outcome per path for the others
+	CHECK(scRun("add", paths, "", results, &error));
+	CHECK(results.size() == 1);
+	CHECK(results.size() == 1 && !results[0].compare(0, 6, "error:"));
+
+	vector<SvnLockInfo> locks;
+
+	CHECK(scGetLocks(paths, locks, &error));
+	CHECK(locks.size() == 1);
+	CHECK(locks.size() == 1 && !locks[0].error.empty() && locks[0].owner.empty());
+
+	// status fails as a whole and reports nothing
+	int numStatuses = 0;
+
+	error.erase();
+	CHECK(!scStatus(dir.c_str(), true, countStatus, &numStatuses, &error));
+	CHECK(!error.empty());
+	CHECK(numStatuses == 0);
+
+	scShutdown();
+	ctRemoveDir(dir);
+}
+
+void testSvnClient ()
+{
+	testSubcommands();
+	testNotWorkingCopy();
+}
@@ -0,0 +1,477 @@
+/*=======================================================================*
+ |   file name : syncplan.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : work out which textures to copy from one sourceimages
+ |               folder to another
+ *=======================================================================*/
+
+/*
+   The extension list and the exclusion patterns are compiled once.
+   Patterns with no wildcards go in a hash, the rest become a list of
+   character sets, one per character, so matching a name is a table
+   lookup per character instead of parsing the pattern again.  Patterns
+   follow MEL's gmatch: "*", "?", "[abc]", "[a-z]", "[!a]", "\" quotes
+   the next character, and case matters.
+
+   Both trees are listed through dircache so a watched project costs
+   nothing to walk again.  Each destination folder is listed once and
+   looked up by name, and files that are in both places are compared
+   on the worker pool.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <ctype.h>
+#include <string.h>
+
+#include <hash_map>
+#include <string>
+#include <vector>
+
+#include "syncplan.h"
+#include "dircache.h"
+#include "filecompare.h"
+#include "hashindex.h"
+#include "threadpool.h"
+#include "trace.h"
+
+using std::string;
+using std::vector;
+using stdext::hash_map;
+
+/*************************** c o n s t a n t s ***************************/
+
+// the ones the texture sync has always copied
+static const char* s_imageExtensions[] =
+{
+	"tga", "iff", "psd", "gif", "rgb", "sgi", "bw",
+	"ppm", "pic", "tif", "vst", "rla", "tm2",
+};
+
+/******************************* t y p e s *******************************/
+
+struct SyncCompare
+{
+	vector<SyncItem>			items;
+	vector<FileCompareResult>	results;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+#define SP_SET_BIT(sgc, c)	((sgc).bits[(unsigned char)(c) >> 3] |= (unsigned char)(1 << ((unsigned char)(c) & 7)))
+#define SP_HAS_BIT(sgc, c)	((sgc).bits[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
+
+/**************************** r o u t i n e s ****************************/
+
+static string spLower (const string& str)
+{
+	string lower = str;
+
+	for (size_t ii = 0; ii < lower.size(); ++ii)
+	{
+		lower[ii] = (char)tolower((unsigned char)lower[ii]);
+	}
+	return lower;
+}
+
+static bool spHasWildcards (const string& pattern)
+{
+	return pattern.find_first_of("*?[\\") != string::npos;
+}
+
+// "[...]" starting at pattern[pos] (just after the "[").  Returns where
+// the set ends or npos if it never does, in which case "[" is itself
+static size_t spCompileSet (const string& pattern, size_t pos, SyncGlobChar* pChar)
+{
+	bool bNegate = false;
+
+	if (pos < pattern.size() && (pattern[pos] == '!' || pattern[pos] == '^'))
+	{
+		bNegate = true;
+		++pos;
+	}
+
+	size_t first = pos;
+
+	while (pos < pattern.size() && (pattern[pos] != ']' || pos == first))
+	{
+		unsigned char lo = (unsigned char)pattern[pos];
+		unsigned char hi = lo;
+
+		if (pos + 2 < pattern.size() && pattern[pos + 1] == '-' && pattern[pos + 2] != ']')
+		{
+			hi   = (unsigned char)pattern[pos + 2];
+			pos += 2;
+		}
+		for (unsigned c = lo; c <= hi; ++c)
+		{
+			SP_SET_BIT(*pChar, c);
+		}
+		++pos;
+	}
+	if (pos >= pattern.size())
+	{
+		return string::npos;
+	}
+	if (bNegate)
+	{
+		for (int ii = 0; ii < 32; ++ii)
+		{
+			pChar->bits[ii] = (unsigned char)~pChar->bits[ii];
+		}
+	}
+	return pos;
+}
+
+static void spCompileGlob (const string& pattern, SyncGlob* pGlob)
+{
+	for (size_t pos = 0; pos < pattern.size(); ++pos)
+	{
+		SyncGlobChar	sgc;
+		char			c = pattern[pos];
+
+		sgc.bStar = false;
+		memset(sgc.bits, 0, sizeof(sgc.bits));
+
+		if (c == '*')
+		{
+			// "**" is the same as "*"
+			if (!pGlob->chars.empty() && pGlob->chars.back().bStar)
+			{
+				continue;
+			}
+			sgc.bStar = true;
+		}
+		else if (c == '?')
+		{
+			memset(sgc.bits, 0xFF, sizeof(sgc.bits));
+		}
+		else if (c == '[')
+		{
+			size_t end = spCompileSet(pattern, pos + 1, &sgc);
+
+			if (end == string::npos)
+			{
+				memset(sgc.bits, 0, sizeof(sgc.bits));
+				SP_SET_BIT(sgc, c);
+			}
+			else
+			{
+				pos = end;
+			}
+		}
+		else
+		{
+			if (c == '\\' && pos + 1 < pattern.size())
+			{
+				c = pattern[++pos];
+			}
+			SP_SET_BIT(sgc, c);
+		}
+		pGlob->chars.push_back(sgc);
+	}
+}
+
+// when a character doesn't match go back to the last "*" and let it eat
+// one more.  Every other entry matches exactly one character so that's
+// all the backtracking ever needed
+static bool spGlobMatch (const SyncGlob& glob, const char* str)
+{
+	const vector<SyncGlobChar>&	chars    = glob.chars;
+	size_t						numChars = chars.size();
+	size_t						ci       = 0;
+	size_t						starCi   = numChars;
+	const char*					starStr  = NULL;
+
+	while (*str)
+	{
+		if (ci < numChars && chars[ci].bStar)
+		{
+			starCi  = ++ci;
+			starStr = str;
+		}
+		else if (ci < numChars && SP_HAS_BIT(chars[ci], *str))
+		{
+			++ci;
+			++str;
+		}
+		else if (starStr)
+		{
+			ci  = starCi;
+			str = ++starStr;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	while (ci < numChars && chars[ci].bStar)
+	{
+		++ci;
+	}
+	return ci == numChars;
+}
+
+/*************************************************************************
+                             spCompileMatcher
+ *************************************************************************
+
+   SYNOPSIS
+		void spCompileMatcher (const vector<string>& exclusions, SyncMatcher* pMatcher)
+
+   PURPOSE
+		build the matcher for the image extensions and exclusions, which
+		are gmatch patterns.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void spCompileMatcher (const vector<string>& exclusions, SyncMatcher* pMatcher)
+{
+	pMatcher->extensions.clear();
+	pMatcher->literals.clear();
+	pMatcher->globs.clear();
+	pMatcher->exclusions = exclusions;
+
+	for (size_t ii = 0; ii < sizeof(s_imageExtensions) / sizeof(s_imageExtensions[0]); ++ii)
+	{
+		pMatcher->extensions.insert(s_imageExtensions[ii]);
+	}
+
+	for (size_t ii = 0; ii < exclusions.size(); ++ii)
+	{
+		if (!spHasWildcards(exclusions[ii]))
+		{
+			// first one wins, same as the order gmatch was tried in
+			pMatcher->literals.insert(std::make_pair(exclusions[ii], (int)ii));
+			continue;
+		}
+
+		pMatcher->globs.push_back(SyncGlob());
+
+		SyncGlob& glob = pMatcher->globs.back();
+
+		glob.index = (int)ii;
+		spCompileGlob(exclusions[ii], &glob);
+	}
+}
+
+/*************************************************************************
+                                 spMatch
+ *************************************************************************
+
+   SYNOPSIS
+		int spMatch (const SyncMatcher& matcher, const char* relPath, bool bIsDir)
+
+   PURPOSE
+		check one path, relative to the folder being synced, "/"
+		separated.  Folders only have to get past the exclusions.
+
+   RETURNS
+		SP_SYNC, SP_NOT_IMAGE or the index of the exclusion it matched
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int spMatch (const SyncMatcher& matcher, const char* relPath, bool bIsDir)
+{
+	if (!bIsDir)
+	{
+		const char*	name = strrchr(relPath, '/');
+		const char*	dot;
+
+		name = name ? name + 1 : relPath;
+		dot  = strrchr(name, '.');
+
+		// fileExtension is what follows the last "." and has to be 2 or more
+		if (!dot || strlen(dot + 1) < 2 ||
+			matcher.extensions.find(spLower(dot + 1)) == matcher.extensions.end())
+		{
+			return SP_NOT_IMAGE;
+		}
+	}
+
+	int	found = SP_SYNC;
+
+	if (!matcher.literals.empty())
+	{
+		hash_map<string, int>::const_iterator it = matcher.literals.find(relPath);
+
+		if (it != matcher.literals.end())
+		{
+			found = it->second;
+		}
+	}
+	for (size_t ii = 0; ii < matcher.globs.size(); ++ii)
+	{
+		const SyncGlob& glob = matcher.globs[ii];
+
+		if (found != SP_SYNC && glob.index > found)
+		{
+			break;
+		}
+		if (spGlobMatch(glob, relPath))
+		{
+			found = glob.index;
+			break;
+		}
+	}
+	return found;
+}
+
+static void spCompareItem (int index, void* pContext)
+{
+	SyncCompare*	pCompare = (SyncCompare*)pContext;
+	const SyncItem&	item     = pCompare->items[index];
+	TraceSpan		span("compare", "compareFiles");
+
+	hiCompareFiles(item.src.c_str(), item.dst.c_str(), &pCompare->results[index]);
+	span.setArg("file1", item.src);
+	span.setArg("file2", item.dst);
+	span.setArg("result", pCompare->results[index].pReason);
+}
+
+/*************************************************************************
+                               spPlanSync
+ *************************************************************************
+
+   SYNOPSIS
+		bool spPlanSync (const char* srcDir, const char* dstDir, const SyncMatcher& matcher, SyncPlan* pPlan, string* pError)
+
+   PURPOSE
+		walk srcDir and its sub folders and sort every file into
+		copies, overwrites and skips against the same place under
+		dstDir.  Nothing is copied.  svn's own folders are left out.
+		A srcDir that isn't there has nothing to copy.
+
+   RETURNS
+		false if a folder could not be read
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool spPlanSync (const char* srcDir, const char* dstDir, const SyncMatcher& matcher, SyncPlan* pPlan, string* pError)
+{
+	TraceSpan		span("sync", "planSync");
+	vector<string>	pending;	// folders to walk, relative to srcDir
+	SyncCompare		compare;
+
+	span.setArg("src", srcDir);
+	span.setArg("dst", dstDir);
+
+	pPlan->copies.clear();
+	pPlan->overwrites.clear();
+	pPlan->skips.clear();
+	pPlan->numDirs = 0;
+
+	pending.push_back(string());
+	while (!pending.empty())
+	{
+		string			rel     = pending.back();
+		string			srcPath = rel.empty() ? string(srcDir) : string(srcDir) + "/" + rel;
+		string			dstPath = rel.empty() ? string(dstDir) : string(dstDir) + "/" + rel;
+		vector<DirItem>	srcItems;
+		vector<DirItem>	dstItems;
+		bool			bExists;
+
+		pending.pop_back();
+		++pPlan->numDirs;
+
+		if (!dcListDir(srcPath.c_str(), srcItems, &bExists, pError) ||
+			!dcListDir(dstPath.c_str(), dstItems, &bExists, pError))
+		{
+			return false;
+		}
+
+		hash_map<string, size_t> dstByName;
+
+		for (size_t ii = 0; ii < dstItems.size(); ++ii)
+		{
+			dstByName[spLower(dstItems[ii].name)] = ii;
+		}
+
+		for (size_t ii = 0; ii < srcItems.size(); ++ii)
+		{
+			const DirItem&	srcItem = srcItems[ii];
+			string			relName = rel.empty() ? srcItem.name : rel + "/" + srcItem.name;
+			SyncItem		item;
+
+			if (srcItem.bIsDir && (!_stricmp(srcItem.name.c_str(), ".svn") || !_stricmp(srcItem.name.c_str(), "_svn")))
+			{
+				continue;
+			}
+
+			item.src = srcPath + "/" + srcItem.name;
+			item.dst = dstPath + "/" + srcItem.name;
+
+			int match = spMatch(matcher, relName.c_str(), srcItem.bIsDir);
+
+			if (match == SP_NOT_IMAGE)
+			{
+				item.reason = "not an image";
+				pPlan->skips.push_back(item);
+				continue;
+			}
+			if (match != SP_SYNC)
+			{
+				item.reason = "excluded by " + matcher.exclusions[match];
+				pPlan->skips.push_back(item);
+				continue;
+			}
+			if (srcItem.bIsDir)
+			{
+				pending.push_back(relName);
+				continue;
+			}
+
+			hash_map<string, size_t>::const_iterator it = dstByName.find(spLower(srcItem.name));
+
+			if (it == dstByName.end())
+			{
+				item.reason = "new";
+				pPlan->copies.push_back(item);
+				continue;
+			}
+
+			const DirItem& dstItem = dstItems[it->second];
+
+			if (dstItem.bIsDir)
+			{
+				item.reason = "a folder is in the way";
+				pPlan->skips.push_back(item);
+			}
+			else if (dstItem.size != srcItem.size)
+			{
+				// no need to open anything to know that
+				item.reason = "size differs";
+				pPlan->overwrites.push_back(item);
+			}
+			else
+			{
+				compare.items.push_back(item);
+			}
+		}
+	}
+
+	compare.results.resize(compare.items.size());
+	wpRunParallel((int)compare.items.size(), spCompareItem, &compare);
+
+	for (size_t ii = 0; ii < compare.items.size(); ++ii)
+	{
+		SyncItem& item = compare.items[ii];
+
+		item.reason = compare.results[ii].pReason;
+		if (compare.results[ii].bSame)
+		{
+			pPlan->skips.push_back(item);
+		}
+		else
+		{
+			pPlan->overwrites.push_back(item);
+		}
+	}
+	return true;
+}
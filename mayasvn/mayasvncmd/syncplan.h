@@ -0,0 +1,73 @@
+/*=======================================================================*
+ |   file name : syncplan.h
+ |-----------------------------------------------------------------------*
+ |   function  : work out which textures to copy from one sourceimages
+ |               folder to another
+ *=======================================================================*/
+
+#ifndef SYNCPLAN_H
+#define SYNCPLAN_H
+/**************************** i n c l u d e s ****************************/
+
+#include <hash_map>
+#include <hash_set>
+#include <string>
+#include <vector>
+
+/*************************** c o n s t a n t s ***************************/
+
+#define SP_SYNC			-1	// spMatch, the file should be synced
+#define SP_NOT_IMAGE	-2	// spMatch, not an image extension
+							// spMatch otherwise returns which exclusion matched
+
+/******************************* t y p e s *******************************/
+
+struct SyncGlobChar
+{
+	bool			bStar;
+	unsigned char	bits[32];	// which characters match, when not a star
+};
+
+struct SyncGlob
+{
+	int							index;		// into SyncMatcher::exclusions
+	std::vector<SyncGlobChar>	chars;
+};
+
+struct SyncMatcher
+{
+	stdext::hash_set<std::string>		extensions;	// lower case, no "."
+	stdext::hash_map<std::string, int>	literals;	// exclusions with no wildcards
+	std::vector<SyncGlob>				globs;		// the rest
+	std::vector<std::string>			exclusions;	// as given
+};
+
+struct SyncItem
+{
+	std::string		src;
+	std::string		dst;
+	std::string		reason;
+};
+
+struct SyncPlan
+{
+	std::vector<SyncItem>	copies;		// not in the destination
+	std::vector<SyncItem>	overwrites;	// in the destination but different
+	std::vector<SyncItem>	skips;		// not images, excluded or the same
+	unsigned				numDirs;	// folders walked
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern void spCompileMatcher (const std::vector<std::string>& exclusions, SyncMatcher* pMatcher);
+extern int spMatch (const SyncMatcher& matcher, const char* relPath, bool bIsDir);
+extern bool spPlanSync (const char* srcDir, const char* dstDir, const SyncMatcher& matcher, SyncPlan* pPlan, std::string* pError);
+
+#endif /* SYNCPLAN_H */
+
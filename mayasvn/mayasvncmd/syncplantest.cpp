@@ -0,0 +1,82 @@
+/*=======================================================================*
+ |   file name : syncplantest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the texture sync matcher
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+#include <vector>
+
+#include "coretest.h"
+#include "syncplan.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// the exclusions are gmatch patterns, spMatch has to agree with gmatch
+void testSyncPlan ()
+{
+	static const char* patterns[] =
+	{
+		"old/*", "temp.tga", "*_bak.[tT][gG][aA]", "x?.tga", "[!a-z]*.psd", "a\\*.tga",
+	};
+
+	vector<string>	exclusions(patterns, patterns + sizeof(patterns) / sizeof(patterns[0]));
+	SyncMatcher		matcher;
+
+	spCompileMatcher(exclusions, &matcher);
+
+	CHECK(spMatch(matcher, "wood.tga", false) == SP_SYNC);
+	CHECK(spMatch(matcher, "sub/WOOD.TGA", false) == SP_SYNC);
+	CHECK(spMatch(matcher, "notes.txt", false) == SP_NOT_IMAGE);
+	CHECK(spMatch(matcher, "noext", false) == SP_NOT_IMAGE);
+	CHECK(spMatch(matcher, "sub.tga/noext", false) == SP_NOT_IMAGE);
+	CHECK(spMatch(matcher, "a.b", false) == SP_NOT_IMAGE);
+
+	CHECK(spMatch(matcher, "old/wood.tga", false) == 0);
+	CHECK(spMatch(matcher, "old", true) == SP_SYNC);
+	CHECK(spMatch(matcher, "old/sub", true) == 0);
+	CHECK(spMatch(matcher, "temp.tga", false) == 1);
+	CHECK(spMatch(matcher, "sub/temp.tga", false) == SP_SYNC);
+	CHECK(spMatch(matcher, "rock_bak.TgA", false) == 2);
+	CHECK(spMatch(matcher, "x1.tga", false) == 3);
+	CHECK(spMatch(matcher, "x12.tga", false) == SP_SYNC);
+	CHECK(spMatch(matcher, "1abc.psd", false) == 4);
+	CHECK(spMatch(matcher, "abc.psd", false) == SP_SYNC);
+	CHECK(spMatch(matcher, "a*.tga", false) == 5);
+	CHECK(spMatch(matcher, "ab.tga", false) == SP_SYNC);
+
+	// the first exclusion that matches wins, literal or not
+	exclusions.clear();
+	exclusions.push_back("*.tga");
+	exclusions.push_back("temp.tga");
+	spCompileMatcher(exclusions, &matcher);
+	CHECK(spMatch(matcher, "temp.tga", false) == 0);
+
+	exclusions.clear();
+	exclusions.push_back("temp.tga");
+	exclusions.push_back("*.tga");
+	spCompileMatcher(exclusions, &matcher);
+	CHECK(spMatch(matcher, "temp.tga", false) == 0);
+	CHECK(spMatch(matcher, "rock.tga", false) == 1);
+}
+
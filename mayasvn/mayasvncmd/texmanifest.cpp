@@ -0,0 +1,120 @@
+/*=======================================================================*
+ |   file name : texmanifest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : list of every texture a scene could use, no duplicates
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "texmanifest.h"
+#include "pathnorm.h"
+#include "seqscan.h"
+
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+void tmInit (TexManifest* pManifest, const FsInterface* pFs)
+{
+	pManifest->textures.clear();
+	pManifest->seen.clear();
+	pManifest->sequences.clear();
+	pManifest->numSequences  = 0;
+	pManifest->numDuplicates = 0;
+	pManifest->pFs           = pFs;
+}
+
+/*************************************************************************
+                              tmAddTexture
+ *************************************************************************
+
+   SYNOPSIS
+		bool tmAddTexture (TexManifest* pManifest, const char* path)
+
+   PURPOSE
+		add path unless it's already there.  "X:\a\B.tga" and
+		"x:/a/b.tga" are the same file.
+
+   RETURNS
+		false if it was a duplicate (or empty)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool tmAddTexture (TexManifest* pManifest, const char* path)
+{
+	if (!*path)
+	{
+		return false;
+	}
+	if (!pManifest->seen.insert(puNormalizePath(path)).second)
+	{
+		++pManifest->numDuplicates;
+		return false;
+	}
+	pManifest->textures.push_back(path);
+	return true;
+}
+
+/*************************************************************************
+                              tmAddSequence
+ *************************************************************************
+
+   SYNOPSIS
+		void tmAddSequence (TexManifest* pManifest, const char* path)
+
+   PURPOSE
+		add every frame on disk of the sequence path is part of.  Lots
+		of file nodes often share a sequence, the directory is only
+		scanned the first time.  A path with no frame number, or no
+		frames on disk, is added as is.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void tmAddSequence (TexManifest* pManifest, const char* path)
+{
+	string prefix;
+	string suffix;
+
+	if (!ssSplitPath(path, &prefix, &suffix))
+	{
+		tmAddTexture(pManifest, path);
+		return;
+	}
+	if (!pManifest->sequences.insert(puNormalizePath((prefix + "\t" + suffix).c_str())).second)
+	{
+		return;
+	}
+
+	SeqInfo	info;
+	string	error;
+
+	++pManifest->numSequences;
+	if (!ssFindSequence(path, pManifest->pFs, &info, &error) || info.frames.empty())
+	{
+		tmAddTexture(pManifest, path);
+		return;
+	}
+	for (size_t ii = 0; ii < info.frames.size(); ++ii)
+	{
+		tmAddTexture(pManifest, info.frames[ii].path.c_str());
+	}
+}
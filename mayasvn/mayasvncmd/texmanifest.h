@@ -0,0 +1,47 @@
+/*=======================================================================*
+ |   file name : texmanifest.h
+ |-----------------------------------------------------------------------*
+ |   function  : list of every texture a scene could use, no duplicates
+ *=======================================================================*/
+
+#ifndef TEXMANIFEST_H
+#define TEXMANIFEST_H
+/**************************** i n c l u d e s ****************************/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "fsiface.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+// nothing in here knows about Maya or windows, the caller feeds it the
+// file nodes and says how to list a folder
+struct TexManifest
+{
+	std::vector<std::string>	textures;	// in the order they were first seen
+	std::set<std::string>		seen;		// normalized paths in textures
+	std::set<std::string>		sequences;	// prefix + "\t" + suffix already expanded
+	unsigned					numSequences;
+	unsigned					numDuplicates;
+	const FsInterface*			pFs;		// for the sequences
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern void tmInit (TexManifest* pManifest, const FsInterface* pFs);
+extern bool tmAddTexture (TexManifest* pManifest, const char* path);
+extern void tmAddSequence (TexManifest* pManifest, const char* path);
+
+#endif /* TEXMANIFEST_H */
+
@@ -0,0 +1,71 @@
+/*=======================================================================*
+ |   file name : texmanifesttest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the scene texture list
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include "coretest.h"
+#include "texmanifest.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+void testTexManifest ()
+{
+	static const char* texNames[] =
+	{
+		"wood.0001.tga", "wood.0002.tga", "wood.0003.tga", "wood.0010.tga",
+		"WOOD.0011.TGA", "rock.tga",
+	};
+
+	FakeFs		fake;
+	FsInterface	fs;
+	TexManifest	manifest;
+
+	ctInitFakeFs(&fake, &fs);
+	ctAddFakeFiles(&fake, "x:/tex", texNames, sizeof(texNames) / sizeof(texNames[0]));
+	tmInit(&manifest, &fs);
+
+	CHECK(tmAddTexture(&manifest, "X:\\tex\\Rock.tga"));
+	CHECK(!tmAddTexture(&manifest, "x:/tex/rock.tga"));
+	CHECK(!tmAddTexture(&manifest, ""));
+	CHECK(manifest.numDuplicates == 1);
+
+	// every frame once, the folder only listed once per sequence
+	tmAddSequence(&manifest, "x:/tex/wood.0005.tga");
+	tmAddSequence(&manifest, "X:\\TEX\\wood.0002.tga");
+	CHECK(manifest.numSequences == 1);
+	CHECK(fake.numListings == 1);
+	CHECK(manifest.textures.size() == 6);
+	CHECK(manifest.textures.size() == 6 && manifest.textures[1] == "x:/tex/wood.0001.tga");
+
+	// a frame someone also named on its own isn't listed twice
+	CHECK(!tmAddTexture(&manifest, "x:/tex/wood.0003.tga"));
+
+	// no frames on disk or no frame number, added as is
+	tmAddSequence(&manifest, "x:/tex/gone.0001.tga");
+	tmAddSequence(&manifest, "x:/tex/plain.tga");
+	CHECK(manifest.numSequences == 2);
+	CHECK(fake.numListings == 2);
+	CHECK(manifest.textures.size() == 8);
+	CHECK(manifest.textures.size() == 8 && manifest.textures[7] == "x:/tex/plain.tga");
+
+	tmInit(&manifest, &fs);
+	CHECK(manifest.textures.empty() && manifest.numSequences == 0 && manifest.numDuplicates == 0);
+}
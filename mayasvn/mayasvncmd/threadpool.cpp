@@ -0,0 +1,152 @@
+/*=======================================================================*
+ |   file name : threadpool.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : run a batch of independent work items on several threads
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <process.h>
+#include "threadpool.h"
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct WorkBatch
+{
+	volatile LONG	nextIndex;
+	int				numItems;
+	WorkFunc		func;
+	void*			pContext;
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static void wpDoWork (WorkBatch* pBatch)
+{
+	for (;;)
+	{
+		int index = InterlockedIncrement(&pBatch->nextIndex) - 1;
+		if (index >= pBatch->numItems)
+		{
+			break;
+		}
+		pBatch->func(index, pBatch->pContext);
+	}
+}
+
+static unsigned __stdcall wpThreadMain (void* pData)
+{
+	wpDoWork((WorkBatch*)pData);
+	return 0;
+}
+
+/*************************************************************************
+                              wpNumWorkers
+ *************************************************************************
+
+   SYNOPSIS
+		int wpNumWorkers ()
+
+   PURPOSE
+		number of threads wpRunParallel will use by default.  Our work
+		is mostly waiting on the disk so we use 2 per processor to
+		keep requests queued up.
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+int wpNumWorkers ()
+{
+	static int numWorkers = 0;
+
+	if (!numWorkers)
+	{
+		SYSTEM_INFO si;
+
+		GetSystemInfo(&si);
+		numWorkers = si.dwNumberOfProcessors * 2;
+		if (numWorkers < 2) numWorkers = 2;
+		if (numWorkers > WP_MAX_WORKERS) numWorkers = WP_MAX_WORKERS;
+	}
+
+	return numWorkers;
+}
+
+/*************************************************************************
+                              wpRunParallel
+ *************************************************************************
+
+   SYNOPSIS
+		void wpRunParallel (int numItems, WorkFunc func, void* pContext, int maxWorkers)
+
+   PURPOSE
+		call func(index, pContext) for every index 0 to numItems - 1
+		spread across several threads.  The calling thread does work
+		too.  Does not return until every item is done.
+
+		If a thread can't be started the remaining threads (or just
+		the calling thread) pick up the slack.
+
+   INPUT
+		numItems   : number of work items
+		func       : function to call for each item
+		pContext   : passed to func
+		maxWorkers : max threads to use including the caller, 0 = default
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void wpRunParallel (int numItems, WorkFunc func, void* pContext, int maxWorkers)
+{
+	WorkBatch	batch;
+	HANDLE		threads[WP_MAX_WORKERS];
+	int			numThreads = 0;
+
+	batch.nextIndex = 0;
+	batch.numItems  = numItems;
+	batch.func      = func;
+	batch.pContext  = pContext;
+
+	if (maxWorkers <= 0 || maxWorkers > WP_MAX_WORKERS)
+	{
+		maxWorkers = wpNumWorkers();
+	}
+	if (maxWorkers > numItems)
+	{
+		maxWorkers = numItems;
+	}
+
+	// -1 because this thread works too
+	for (int ii = 0; ii < maxWorkers - 1; ++ii)
+	{
+		HANDLE h = (HANDLE)_beginthreadex(NULL, 0, wpThreadMain, &batch, 0, NULL);
+		if (!h)
+		{
+			break;
+		}
+		threads[numThreads++] = h;
+	}
+
+	wpDoWork(&batch);
+
+	if (numThreads > 0)
+	{
+		WaitForMultipleObjects(numThreads, threads, TRUE, INFINITE);
+		for (int ii = 0; ii < numThreads; ++ii)
+		{
+			CloseHandle(threads[ii]);
+		}
+	}
+}
+
@@ -0,0 +1,34 @@
+/*=======================================================================*
+ |   file name : threadpool.h
+ |-----------------------------------------------------------------------*
+ |   function  : run a batch of independent work items on several threads
+ *=======================================================================*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+/**************************** i n c l u d e s ****************************/
+
+
+/*************************** c o n s t a n t s ***************************/
+
+#define WP_MAX_WORKERS	32
+
+/******************************* t y p e s *******************************/
+
+// called once for each item.  Called from several threads at once so it
+// must not touch Maya (MGlobal, MString from other threads etc).
+typedef void (*WorkFunc)(int index, void* pContext);
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern int  wpNumWorkers ();
+extern void wpRunParallel (int numItems, WorkFunc func, void* pContext, int maxWorkers = 0);
+
+#endif /* THREADPOOL_H */
+
@@ -0,0 +1,107 @@
+/*=======================================================================*
+ |   file name : threadpooltest.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : checks for the worker pool
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+
+#include <vector>
+
+#include "coretest.h"
+#include "threadpool.h"
+
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+#define CT_NUM_ITEMS	1000
+
+/******************************* t y p e s *******************************/
+
+struct RunCount
+{
+	vector<LONG>	counts;		// times each index was run
+	vector<DWORD>	threads;	// thread that ran each index
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+// WorkFunc.  Each index has its own slots so only the count needs locking
+static void countRun (int index, void* pContext)
+{
+	RunCount* pRun = (RunCount*)pContext;
+
+	InterlockedIncrement(&pRun->counts[index]);
+	pRun->threads[index] = GetCurrentThreadId();
+}
+
+static void initRun (RunCount* pRun, int numItems)
+{
+	pRun->counts.assign(numItems + 1, 0);	// + 1 to catch a run past the end
+	pRun->threads.assign(numItems + 1, 0);
+}
+
+// every index run once and nothing past the end
+static bool ranOnce (const RunCount& run, int numItems)
+{
+	for (int ii = 0; ii < numItems; ++ii)
+	{
+		if (run.counts[ii] != 1)
+		{
+			return false;
+		}
+	}
+	return run.counts[numItems] == 0;
+}
+
+void testThreadPool ()
+{
+	RunCount run;
+
+	CHECK(wpNumWorkers() >= 2 && wpNumWorkers() <= WP_MAX_WORKERS);
+
+	// the default number of workers
+	initRun(&run, CT_NUM_ITEMS);
+	wpRunParallel(CT_NUM_ITEMS, countRun, &run);
+	CHECK(ranOnce(run, CT_NUM_ITEMS));
+
+	// more workers than the pool allows falls back to the default
+	initRun(&run, CT_NUM_ITEMS);
+	wpRunParallel(CT_NUM_ITEMS, countRun, &run, WP_MAX_WORKERS + 1);
+	CHECK(ranOnce(run, CT_NUM_ITEMS));
+
+	// more workers than items
+	initRun(&run, 3);
+	wpRunParallel(3, countRun, &run, WP_MAX_WORKERS);
+	CHECK(ranOnce(run, 3));
+
+	// one worker is just the caller
+	initRun(&run, 10);
+	wpRunParallel(10, countRun, &run, 1);
+	CHECK(ranOnce(run, 10));
+
+	bool bCaller = true;
+
+	for (int ii = 0; ii < 10; ++ii)
+	{
+		bCaller = bCaller && run.threads[ii] == GetCurrentThreadId();
+	}
+	CHECK(bCaller);
+
+	// nothing to do
+	initRun(&run, 0);
+	wpRunParallel(0, countRun, &run);
+	CHECK(ranOnce(run, 0));
+}
@@ -0,0 +1,414 @@
+/*=======================================================================*
+ |   file name : trace.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : timeline of callbacks and svn operations for a trace
+ |               viewer (chrome://tracing, perfetto)
+ *=======================================================================*/
+
+/*
+   Each thread records into its own buffer, found through TLS, so
+   threads don't wait on each other while tracing.  The buffer's lock
+   is only ever contended by trStop collecting it.  Buffers outlive
+   their threads, trStop still wants what they recorded.
+
+   trStop writes the trace event format, one "complete" (ph "X") event
+   per span.
+*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+using std::string;
+using std::vector;
+
+/*************************** c o n s t a n t s ***************************/
+
+
+/******************************* t y p e s *******************************/
+
+struct TraceEvent
+{
+	const char*	pCategory;	// always a literal
+	string		name;
+	__int64		start;
+	__int64		end;
+	DWORD		threadId;
+	int			numArgs;
+	const char*	argNames[TR_MAX_ARGS];
+	string		argValues[TR_MAX_ARGS];
+};
+
+struct TraceBuffer
+{
+	DWORD				threadId;
+	CRITICAL_SECTION	cs;
+	vector<TraceEvent>	events;
+	unsigned			dropped;
+};
+
+struct ltevent
+{
+	bool operator()(const TraceEvent& e1, const TraceEvent& e2) const
+	{
+		return e1.start < e2.start;
+	}
+};
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+volatile long g_trEnabled;
+
+static bool					s_bInitialized;
+static CRITICAL_SECTION		s_cs;			// the buffer list and the settings
+static DWORD				s_tlsIndex;
+static vector<TraceBuffer*>	s_buffers;
+static string				s_filename;
+static __int64				s_startTime;
+static DWORD				s_mainThreadId;	// whoever started the trace
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static void trInit ()
+{
+	if (!s_bInitialized)
+	{
+		InitializeCriticalSection(&s_cs);
+		s_tlsIndex     = TlsAlloc();
+		s_bInitialized = true;
+	}
+}
+
+static __int64 trNow ()
+{
+	LARGE_INTEGER now;
+
+	QueryPerformanceCounter(&now);
+	return now.QuadPart;
+}
+
+// this thread's buffer, made the first time the thread records
+static TraceBuffer* trGetBuffer ()
+{
+	TraceBuffer* pBuffer = (TraceBuffer*)TlsGetValue(s_tlsIndex);
+
+	if (!pBuffer)
+	{
+		pBuffer = new TraceBuffer;
+		pBuffer->threadId = GetCurrentThreadId();
+		pBuffer->dropped  = 0;
+		InitializeCriticalSection(&pBuffer->cs);
+		TlsSetValue(s_tlsIndex, pBuffer);
+
+		EnterCriticalSection(&s_cs);
+		s_buffers.push_back(pBuffer);
+		LeaveCriticalSection(&s_cs);
+	}
+	return pBuffer;
+}
+
+static void trWriteString (FILE* fp, const string& str)
+{
+	fputc('"', fp);
+	for (size_t ii = 0; ii < str.size(); ++ii)
+	{
+		unsigned char c = (unsigned char)str[ii];
+
+		if (c == '"' || c == '\\')
+		{
+			fputc('\\', fp);
+			fputc(c, fp);
+		}
+		else if (c < 0x20)
+		{
+			fprintf(fp, "\\u%04x", c);
+		}
+		else
+		{
+			fputc(c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+// strncpy that always ends the string
+static void trCopy (char* pDst, const char* pSrc, size_t size)
+{
+	size_t len = pSrc ? strlen(pSrc) : 0;
+
+	if (len >= size)
+	{
+		len = size - 1;
+	}
+	memcpy(pDst, pSrc, len);
+	pDst[len] = '\0';
+}
+
+TraceSpan::TraceSpan (const char* pCategory, const char* pName)
+{
+	if (!trEnabled())
+	{
+		_start = 0;
+		return;
+	}
+	_pCategory = pCategory;
+	_numArgs   = 0;
+	trCopy(_name, pName, sizeof(_name));
+	_start     = trNow();
+}
+
+void TraceSpan::setArg (const char* pName, const char* pValue)
+{
+	if (_start && _numArgs < TR_MAX_ARGS)
+	{
+		_argNames[_numArgs] = pName;
+		trCopy(_argValues[_numArgs], pValue, sizeof(_argValues[_numArgs]));
+		++_numArgs;
+	}
+}
+
+void TraceSpan::setArg (const char* pName, long value)
+{
+	if (_start && _numArgs < TR_MAX_ARGS)
+	{
+		_argNames[_numArgs] = pName;
+		_snprintf (_argValues[_numArgs], sizeof(_argValues[_numArgs]), "%ld", value);
+		_argValues[_numArgs][sizeof(_argValues[_numArgs]) - 1] = '\0';
+		++_numArgs;
+	}
+}
+
+TraceSpan::~TraceSpan ()
+{
+	// started before the trace or the trace has stopped
+	if (!_start || !trEnabled() || _start < s_startTime)
+	{
+		return;
+	}
+
+	__int64			end     = trNow();
+	TraceBuffer*	pBuffer = trGetBuffer();
+
+	EnterCriticalSection(&pBuffer->cs);
+	if (pBuffer->events.size() < TR_MAX_THREAD_EVENTS)
+	{
+		pBuffer->events.push_back(TraceEvent());
+
+		TraceEvent& event = pBuffer->events.back();
+
+		event.pCategory = _pCategory;
+		event.name      = _name;
+		event.start     = _start;
+		event.end       = end;
+		event.threadId  = pBuffer->threadId;
+		event.numArgs   = _numArgs;
+		for (int ii = 0; ii < _numArgs; ++ii)
+		{
+			event.argNames[ii]  = _argNames[ii];
+			event.argValues[ii] = _argValues[ii];
+		}
+	}
+	else
+	{
+		++pBuffer->dropped;
+	}
+	LeaveCriticalSection(&pBuffer->cs);
+}
+
+/*************************************************************************
+                                 trStart
+ *************************************************************************
+
+   SYNOPSIS
+		bool trStart (const char* filename, string* pError)
+
+   PURPOSE
+		start recording.  Anything already recorded is thrown away.
+		Nothing is written until trStop.  Main thread only.
+
+   RETURNS
+		false if the file can't be written
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool trStart (const char* filename, string* pError)
+{
+	trInit();
+
+	// find out now rather than after the interesting part
+	FILE* fp = fopen(filename, "w");
+	if (!fp)
+	{
+		*pError = string("could not open \"") + filename + "\"";
+		return false;
+	}
+	fclose(fp);
+
+	InterlockedExchange(&g_trEnabled, 0);
+
+	EnterCriticalSection(&s_cs);
+	for (size_t ii = 0; ii < s_buffers.size(); ++ii)
+	{
+		TraceBuffer* pBuffer = s_buffers[ii];
+
+		EnterCriticalSection(&pBuffer->cs);
+		pBuffer->events.clear();
+		pBuffer->dropped = 0;
+		LeaveCriticalSection(&pBuffer->cs);
+	}
+	s_filename      = filename;
+	s_startTime     = trNow();
+	s_mainThreadId  = GetCurrentThreadId();
+	LeaveCriticalSection(&s_cs);
+
+	InterlockedExchange(&g_trEnabled, 1);
+	return true;
+}
+
+/*************************************************************************
+                                  trStop
+ *************************************************************************
+
+   SYNOPSIS
+		bool trStop (int* pNumEvents, string* pError)
+
+   PURPOSE
+		stop recording and write everything recorded since trStart.
+		Main thread only.
+
+   INPUT
+		pNumEvents : set to how many spans were written
+
+   RETURNS
+		false if no trace was running or the file could not be written
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool trStop (int* pNumEvents, string* pError)
+{
+	*pNumEvents = 0;
+	if (!s_bInitialized || !trEnabled())
+	{
+		*pError = "no trace running";
+		return false;
+	}
+
+	InterlockedExchange(&g_trEnabled, 0);
+
+	vector<TraceEvent>	events;
+	unsigned			dropped = 0;
+
+	EnterCriticalSection(&s_cs);
+	for (size_t ii = 0; ii < s_buffers.size(); ++ii)
+	{
+		TraceBuffer*		pBuffer = s_buffers[ii];
+		vector<TraceEvent>	threadEvents;
+
+		EnterCriticalSection(&pBuffer->cs);
+		threadEvents.swap(pBuffer->events);
+		dropped += pBuffer->dropped;
+		pBuffer->dropped = 0;
+		LeaveCriticalSection(&pBuffer->cs);
+
+		events.insert(events.end(), threadEvents.begin(), threadEvents.end());
+	}
+	string filename = s_filename;
+	LeaveCriticalSection(&s_cs);
+
+	std::sort(events.begin(), events.end(), ltevent());
+
+	FILE* fp = fopen(filename.c_str(), "w");
+	if (!fp)
+	{
+		*pError = "could not write \"" + filename + "\"";
+		return false;
+	}
+
+	LARGE_INTEGER freq;
+	DWORD pid = GetCurrentProcessId();
+
+	QueryPerformanceFrequency(&freq);
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"maya\"}},\n",
+			(unsigned long)pid, (unsigned long)s_mainThreadId);
+	fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"main\"}}",
+			(unsigned long)pid, (unsigned long)s_mainThreadId);
+
+	for (size_t ii = 0; ii < events.size(); ++ii)
+	{
+		const TraceEvent& event = events[ii];
+		double ts  = (double)(event.start - s_startTime) * 1000000.0 / (double)freq.QuadPart;
+		double dur = (double)(event.end - event.start) * 1000000.0 / (double)freq.QuadPart;
+
+		fprintf(fp, ",\n{\"name\":");
+		trWriteString(fp, event.name);
+		fprintf(fp, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu",
+				event.pCategory, ts, dur, (unsigned long)pid, (unsigned long)event.threadId);
+		if (event.numArgs)
+		{
+			fprintf(fp, ",\"args\":{");
+			for (int jj = 0; jj < event.numArgs; ++jj)
+			{
+				fprintf(fp, "%s\"%s\":", jj ? "," : "", event.argNames[jj]);
+				trWriteString(fp, event.argValues[jj]);
+			}
+			fputc('}', fp);
+		}
+		fputc('}', fp);
+	}
+	if (dropped)
+	{
+		fprintf(fp, ",\n{\"name\":\"%u spans dropped\",\"ph\":\"i\",\"s\":\"g\",\"ts\":0,\"pid\":%lu,\"tid\":%lu}",
+				dropped, (unsigned long)pid, (unsigned long)s_mainThreadId);
+	}
+	fprintf(fp, "\n]}\n");
+
+	bool bOk = !ferror(fp);
+	if (fclose(fp) != 0 || !bOk)
+	{
+		*pError = "could not write \"" + filename + "\"";
+		return false;
+	}
+
+	*pNumEvents = (int)events.size();
+	return true;
+}
+
+// "" = not tracing
+string trGetFile ()
+{
+	return trEnabled() ? s_filename : string();
+}
+
+void trShutdown ()
+{
+	if (s_bInitialized)
+	{
+		InterlockedExchange(&g_trEnabled, 0);
+
+		for (size_t ii = 0; ii < s_buffers.size(); ++ii)
+		{
+			DeleteCriticalSection(&s_buffers[ii]->cs);
+			delete s_buffers[ii];
+		}
+		s_buffers.clear();
+		TlsFree(s_tlsIndex);
+		DeleteCriticalSection(&s_cs);
+		s_bInitialized = false;
+	}
+}
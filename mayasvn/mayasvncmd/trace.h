@@ -0,0 +1,66 @@
+/*=======================================================================*
+ |   file name : trace.h
+ |-----------------------------------------------------------------------*
+ |   function  : timeline of callbacks and svn operations for a trace
+ |               viewer (chrome://tracing, perfetto)
+ *=======================================================================*/
+
+#ifndef TRACE_H
+#define TRACE_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+/*************************** c o n s t a n t s ***************************/
+
+#define TR_MAX_ARGS				3
+#define TR_MAX_NAME				128		// longer names and values are cut short
+#define TR_MAX_VALUE			260
+#define TR_MAX_THREAD_EVENTS	100000	// per thread, after that they're dropped
+
+/******************************* t y p e s *******************************/
+
+// times one block of code.  Does nothing unless a trace is running,
+// not even copy its name, so one can go anywhere.
+//
+//   TraceSpan span("svn", "update");
+//   span.setArg("path", path);
+class TraceSpan
+{
+public:
+	TraceSpan (const char* pCategory, const char* pName);
+	~TraceSpan ();
+
+	void setArg (const char* pName, const char* pValue);
+	void setArg (const char* pName, const std::string& value) { setArg(pName, value.c_str()); }
+	void setArg (const char* pName, long value);
+
+private:
+	TraceSpan (const TraceSpan&);
+	TraceSpan& operator= (const TraceSpan&);
+
+	__int64			_start;	// 0 = not tracing, nothing below is set
+	const char*		_pCategory;
+	char			_name[TR_MAX_NAME];
+	int				_numArgs;
+	const char*		_argNames[TR_MAX_ARGS];
+	char			_argValues[TR_MAX_ARGS][TR_MAX_VALUE];
+};
+
+/***************************** g l o b a l s *****************************/
+
+extern volatile long g_trEnabled;
+
+/****************************** m a c r o s ******************************/
+
+#define trEnabled()	(g_trEnabled != 0)
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool trStart (const char* filename, std::string* pError);
+extern bool trStop (int* pNumEvents, std::string* pError);
+extern std::string trGetFile ();
+extern void trShutdown ();
+
+#endif /* TRACE_H */
+
@@ -0,0 +1,444 @@
+/*=======================================================================*
+ |   file name : wcreader.cpp
+ |-----------------------------------------------------------------------*
+ |   function  : read subversion working copy metadata (.svn/wc.db)
+ *=======================================================================*/
+
+/**************************** i n c l u d e s ****************************/
+
+#include <windows.h>
+#include <sqlite3.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "wcreader.h"
+#include "pathutil.h"
+#include "filecompare.h"
+
+using std::map;
+using std::string;
+
+/*************************** c o n s t a n t s ***************************/
+
+// FILETIME of 1970/01/01 (apr_time_t is microseconds since then)
+#define WC_FILETIME_1970	((unsigned __int64)116444736 * 1000000000)
+
+/******************************* t y p e s *******************************/
+
+struct WcDb
+{
+	sqlite3*		db;
+	sqlite3_int64	wcId;
+	sqlite3_stmt*	pNodeStmt;
+	sqlite3_stmt*	pNodeNoCaseStmt;
+	sqlite3_stmt*	pBaseStmt;
+	sqlite3_stmt*	pLockStmt;
+	sqlite3_stmt*	pReposStmt;
+};
+
+typedef map<string, WcDb*> WcDbMap;
+
+/************************** p r o t o t y p e s **************************/
+
+
+/***************************** g l o b a l s *****************************/
+
+static WcDbMap	s_dbs;	// open databases by normalized wc root
+
+/****************************** m a c r o s ******************************/
+
+
+/**************************** r o u t i n e s ****************************/
+
+static string wcColText (sqlite3_stmt* pStmt, int col)
+{
+	const unsigned char* s = sqlite3_column_text(pStmt, col);
+	return s ? string((const char*)s) : string();
+}
+
+static bool wcPathExists (const string& path, bool* pIsDir)
+{
+	PathInfo info;
+
+	if (!puGetPathInfo(path.c_str(), &info))
+	{
+		return false;
+	}
+	if (pIsDir)
+	{
+		*pIsDir = info.bIsDir;
+	}
+	return true;
+}
+
+static void wcCloseDb (WcDb* pWc)
+{
+	sqlite3_finalize(pWc->pNodeStmt);
+	sqlite3_finalize(pWc->pNodeNoCaseStmt);
+	sqlite3_finalize(pWc->pBaseStmt);
+	sqlite3_finalize(pWc->pLockStmt);
+	sqlite3_finalize(pWc->pReposStmt);
+	sqlite3_close(pWc->db);
+	delete pWc;
+}
+
+// find the working copy root for an absolute path.  1.7+ working copies
+// only have a .svn folder at the root.  If we find a .svn folder without
+// a wc.db it's an older format we don't read.
+static bool wcFindRoot (const string& absPath, string* pRoot, string* pError)
+{
+	string dir = absPath;
+
+	for (;;)
+	{
+		bool bIsDir = false;
+
+		if (wcPathExists(dir + "\\.svn\\wc.db", NULL))
+		{
+			*pRoot = dir;
+			return true;
+		}
+		if (wcPathExists(dir + "\\.svn", &bIsDir) && bIsDir)
+		{
+			*pError = "working copy format is older than 1.7";
+			return false;
+		}
+
+		string::size_type slash = dir.rfind('\\');
+		if (slash == string::npos || slash < 2)
+		{
+			break;
+		}
+		dir.erase(slash);
+	}
+
+	pRoot->erase();
+	return true;
+}
+
+static WcDb* wcOpenDb (const string& root, string* pError)
+{
+	string key = puNormalizePath(root.c_str());
+	WcDbMap::iterator it = s_dbs.find(key);
+
+	if (it != s_dbs.end())
+	{
+		return it->second;
+	}
+
+	WcDb* pWc = new WcDb;
+	memset(pWc, 0, sizeof(*pWc));
+
+	string dbPath = root + "\\.svn\\wc.db";
+	if (sqlite3_open_v2(dbPath.c_str(), &pWc->db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+	{
+		*pError = string("could not open ") + dbPath + " : " + sqlite3_errmsg(pWc->db);
+		wcCloseDb(pWc);
+		return NULL;
+	}
+
+	// svn might be writing to it right now
+	sqlite3_busy_timeout(pWc->db, 2000);
+
+	bool bOk =
+		sqlite3_prepare_v2(pWc->db,
+			"SELECT presence, kind, revision, changed_revision, changed_author, repos_id, repos_path, "
+			"translated_size, last_mod_time, checksum, op_depth, properties, local_relpath "
+			"FROM nodes WHERE wc_id = ?1 AND local_relpath = ?2 ORDER BY op_depth DESC LIMIT 1",
+			-1, &pWc->pNodeStmt, NULL) == SQLITE_OK &&
+		sqlite3_prepare_v2(pWc->db,
+			"SELECT presence, kind, revision, changed_revision, changed_author, repos_id, repos_path, "
+			"translated_size, last_mod_time, checksum, op_depth, properties, local_relpath "
+			"FROM nodes WHERE wc_id = ?1 AND local_relpath = ?2 COLLATE NOCASE ORDER BY op_depth DESC LIMIT 1",
+			-1, &pWc->pNodeNoCaseStmt, NULL) == SQLITE_OK &&
+		sqlite3_prepare_v2(pWc->db,
+			"SELECT repos_id, repos_path, revision, changed_revision, changed_author "
+			"FROM nodes WHERE wc_id = ?1 AND local_relpath = ?2 AND op_depth = 0",
+			-1, &pWc->pBaseStmt, NULL) == SQLITE_OK &&
+		sqlite3_prepare_v2(pWc->db,
+			"SELECT lock_token, lock_owner, lock_comment FROM lock WHERE repos_id = ?1 AND repos_relpath = ?2",
+			-1, &pWc->pLockStmt, NULL) == SQLITE_OK &&
+		sqlite3_prepare_v2(pWc->db,
+			"SELECT root FROM repository WHERE id = ?1",
+			-1, &pWc->pReposStmt, NULL) == SQLITE_OK;
+
+	if (bOk)
+	{
+		sqlite3_stmt* pStmt = NULL;
+
+		bOk = sqlite3_prepare_v2(pWc->db, "SELECT id FROM wcroot LIMIT 1", -1, &pStmt, NULL) == SQLITE_OK &&
+			  sqlite3_step(pStmt) == SQLITE_ROW;
+		if (bOk)
+		{
+			pWc->wcId = sqlite3_column_int64(pStmt, 0);
+		}
+		sqlite3_finalize(pStmt);
+	}
+
+	if (!bOk)
+	{
+		*pError = string("unsupported working copy database ") + dbPath + " : " + sqlite3_errmsg(pWc->db);
+		wcCloseDb(pWc);
+		return NULL;
+	}
+
+	s_dbs[key] = pWc;
+	return pWc;
+}
+
+// file is unchanged if size and time match what svn recorded, otherwise
+// compare it to the pristine copy.  Files with keywords or eol
+// translation can't be compared byte for byte so we call them modified.
+static bool wcIsFileModified (const string& root, const string& absPath, const PathInfo& info,
+							  sqlite3_int64 translatedSize, sqlite3_int64 lastModTime,
+							  const string& checksum, const string& props)
+{
+	sqlite3_int64 mtime = (sqlite3_int64)((info.mtime - WC_FILETIME_1970) / 10);
+
+	if (translatedSize >= 0 && (sqlite3_int64)info.size != translatedSize)
+	{
+		return true;
+	}
+	if (translatedSize >= 0 && mtime == lastModTime)
+	{
+		return false;
+	}
+	if (props.find("svn:keywords") != string::npos || props.find("svn:eol-style") != string::npos)
+	{
+		return true;
+	}
+	if (checksum.compare(0, 6, "$sha1$") != 0 || checksum.size() < 8)
+	{
+		return true;
+	}
+
+	string hex      = checksum.substr(6);
+	string pristine = root + "\\.svn\\pristine\\" + hex.substr(0, 2) + "\\" + hex + ".svn-base";
+
+	return !fcCompareFiles(absPath.c_str(), pristine.c_str(), NULL);
+}
+
+/*************************************************************************
+                                wcGetInfo
+ *************************************************************************
+
+   SYNOPSIS
+		bool wcGetInfo (const char* path, WcInfo* pInfo, std::string* pError)
+
+   PURPOSE
+		Answer the same questions as "svn info" / "svn status" for a
+		single path by reading the working copy database directly.
+		No process is started and nothing is sent to the server so
+		only locks held by THIS working copy are known.
+
+		Databases are kept open between calls.
+
+   RETURNS
+		true on success (including "not versioned"), false if the
+		working copy could not be read (pre 1.7 format etc)
+
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+bool wcGetInfo (const char* path, WcInfo* pInfo, string* pError)
+{
+	char	fullPath[MAX_PATH];
+	string	absPath;
+	string	root;
+	string	relPath;
+	WcDb*	pWc;
+
+	pInfo->bVersioned      = false;
+	pInfo->bModified       = false;
+	pInfo->kind.erase();
+	pInfo->status          = "?      ";
+	pInfo->revision        = -1;
+	pInfo->changedRevision = -1;
+	pInfo->changedAuthor.erase();
+	pInfo->url.erase();
+	pInfo->lockToken.erase();
+	pInfo->lockOwner.erase();
+	pInfo->lockComment.erase();
+	pInfo->wcRoot.erase();
+
+	if (!GetFullPathName(path, MAX_PATH, fullPath, NULL))
+	{
+		*pError = string("bad path ") + path;
+		return false;
+	}
+
+	absPath = fullPath;
+	for (string::size_type ii = 0; ii < absPath.size(); ++ii)
+	{
+		if (absPath[ii] == '/')
+		{
+			absPath[ii] = '\\';
+		}
+	}
+	while (absPath.size() > 3 && absPath[absPath.size() - 1] == '\\')
+	{
+		absPath.erase(absPath.size() - 1);
+	}
+
+	if (!wcFindRoot(absPath, &root, pError))
+	{
+		return false;
+	}
+	if (root.empty())
+	{
+		// not in a working copy
+		return true;
+	}
+
+	pWc = wcOpenDb(root, pError);
+	if (!pWc)
+	{
+		return false;
+	}
+
+	pInfo->wcRoot = root;
+
+	if (absPath.size() > root.size())
+	{
+		relPath = absPath.substr(root.size() + 1);
+		for (string::size_type ii = 0; ii < relPath.size(); ++ii)
+		{
+			if (relPath[ii] == '\\')
+			{
+				relPath[ii] = '/';
+			}
+		}
+	}
+
+	// try the exact name first since that can use the index.  Windows
+	// users don't care about case so try again without it.
+	sqlite3_stmt* pNode = pWc->pNodeStmt;
+	sqlite3_bind_int64(pNode, 1, pWc->wcId);
+	sqlite3_bind_text(pNode, 2, relPath.c_str(), -1, SQLITE_TRANSIENT);
+	int rc = sqlite3_step(pNode);
+	if (rc == SQLITE_DONE)
+	{
+		sqlite3_reset(pNode);
+		pNode = pWc->pNodeNoCaseStmt;
+		sqlite3_bind_int64(pNode, 1, pWc->wcId);
+		sqlite3_bind_text(pNode, 2, relPath.c_str(), -1, SQLITE_TRANSIENT);
+		rc = sqlite3_step(pNode);
+	}
+
+	if (rc != SQLITE_ROW)
+	{
+		sqlite3_reset(pNode);
+		if (rc != SQLITE_DONE)
+		{
+			*pError = string("error reading working copy : ") + sqlite3_errmsg(pWc->db);
+			return false;
+		}
+		return true;	// not versioned
+	}
+
+	string			presence       = wcColText(pNode, 0);
+	string			kind           = wcColText(pNode, 1);
+	sqlite3_int64	translatedSize = sqlite3_column_type(pNode, 7) == SQLITE_NULL ? -1 : sqlite3_column_int64(pNode, 7);
+	sqlite3_int64	lastModTime    = sqlite3_column_int64(pNode, 8);
+	string			checksum       = wcColText(pNode, 9);
+	int				opDepth        = sqlite3_column_int(pNode, 10);
+	bool			bCopied        = opDepth > 0 && sqlite3_column_type(pNode, 6) != SQLITE_NULL;
+	string			props((const char*)sqlite3_column_blob(pNode, 11) ? (const char*)sqlite3_column_blob(pNode, 11) : "", sqlite3_column_bytes(pNode, 11));
+
+	relPath = wcColText(pNode, 12);
+	sqlite3_reset(pNode);
+
+	if (presence != "normal" && presence != "base-deleted" && presence != "incomplete")
+	{
+		// not-present, excluded, server-excluded
+		return true;
+	}
+
+	pInfo->bVersioned = true;
+	pInfo->kind       = kind;
+	pInfo->status     = "       ";
+
+	// BASE has the repository info, added files don't have one
+	bool bHaveBase = false;
+	sqlite3_int64 reposId = 0;
+	string reposPath;
+
+	sqlite3_bind_int64(pWc->pBaseStmt, 1, pWc->wcId);
+	sqlite3_bind_text(pWc->pBaseStmt, 2, relPath.c_str(), -1, SQLITE_TRANSIENT);
+	if (sqlite3_step(pWc->pBaseStmt) == SQLITE_ROW)
+	{
+		bHaveBase               = true;
+		reposId                 = sqlite3_column_int64(pWc->pBaseStmt, 0);
+		reposPath               = wcColText(pWc->pBaseStmt, 1);
+		pInfo->revision         = (long)sqlite3_column_int64(pWc->pBaseStmt, 2);
+		pInfo->changedRevision  = (long)sqlite3_column_int64(pWc->pBaseStmt, 3);
+		pInfo->changedAuthor    = wcColText(pWc->pBaseStmt, 4);
+	}
+	sqlite3_reset(pWc->pBaseStmt);
+
+	if (bHaveBase)
+	{
+		sqlite3_bind_int64(pWc->pReposStmt, 1, reposId);
+		if (sqlite3_step(pWc->pReposStmt) == SQLITE_ROW)
+		{
+			pInfo->url = wcColText(pWc->pReposStmt, 0) + "/" + reposPath;
+		}
+		sqlite3_reset(pWc->pReposStmt);
+
+		sqlite3_bind_int64(pWc->pLockStmt, 1, reposId);
+		sqlite3_bind_text(pWc->pLockStmt, 2, reposPath.c_str(), -1, SQLITE_TRANSIENT);
+		if (sqlite3_step(pWc->pLockStmt) == SQLITE_ROW)
+		{
+			pInfo->lockToken   = wcColText(pWc->pLockStmt, 0);
+			pInfo->lockOwner   = wcColText(pWc->pLockStmt, 1);
+			pInfo->lockComment = wcColText(pWc->pLockStmt, 2);
+			pInfo->status[5]   = 'K';
+		}
+		sqlite3_reset(pWc->pLockStmt);
+	}
+
+	if (presence == "base-deleted")
+	{
+		pInfo->status[0] = 'D';
+	}
+	else if (opDepth > 0)
+	{
+		pInfo->status[0] = bHaveBase ? 'R' : 'A';
+		if (bCopied)
+		{
+			pInfo->status[3] = '+';
+		}
+	}
+	else if (presence == "incomplete")
+	{
+		pInfo->status[0] = '!';
+	}
+	else
+	{
+		PathInfo info;
+
+		if (!puGetPathInfo(absPath.c_str(), &info))
+		{
+			pInfo->status[0] = '!';
+		}
+		else if (kind == "file" &&
+				 wcIsFileModified(root, absPath, info, translatedSize, lastModTime, checksum, props))
+		{
+			pInfo->bModified = true;
+			pInfo->status[0] = 'M';
+		}
+	}
+
+	return true;
+}
+
+void wcCloseAll ()
+{
+	for (WcDbMap::iterator it = s_dbs.begin(); it != s_dbs.end(); ++it)
+	{
+		wcCloseDb(it->second);
+	}
+	s_dbs.clear();
+}
+
@@ -0,0 +1,47 @@
+/*=======================================================================*
+ |   file name : wcreader.h
+ |-----------------------------------------------------------------------*
+ |   function  : read subversion working copy metadata (.svn/wc.db)
+ *=======================================================================*/
+
+#ifndef WCREADER_H
+#define WCREADER_H
+/**************************** i n c l u d e s ****************************/
+
+#include <string>
+
+/*************************** c o n s t a n t s ***************************/
+
+#define WC_STATUS_COLUMNS	7
+
+/******************************* t y p e s *******************************/
+
+struct WcInfo
+{
+	bool		bVersioned;
+	bool		bModified;
+	std::string	kind;			// "file", "dir", "symlink" or "" if unversioned
+	std::string	status;			// first 7 columns of "svn status"
+	long		revision;
+	long		changedRevision;
+	std::string	changedAuthor;
+	std::string	url;
+	std::string	lockToken;		// only locks held by this working copy
+	std::string	lockOwner;
+	std::string	lockComment;
+	std::string	wcRoot;
+};
+
+/***************************** g l o b a l s *****************************/
+
+
+/****************************** m a c r o s ******************************/
+
+
+/************************** p r o t o t y p e s **************************/
+
+extern bool wcGetInfo (const char* path, WcInfo* pInfo, std::string* pError);
+extern void wcCloseAll ();
+
+#endif /* WCREADER_H */
+